@@ -1,8 +1,6 @@
 #version 330 core
 
-out vec4 FragColor;
-
-in vec2 TexCoord;
+#include "fragment_common.glsl"
 
 void main() {
     FragColor = vec4(1.0, 1.0, 1.0, 1.0);
@@ -0,0 +1,158 @@
+#ifndef ATLASBUILDER_H
+#define ATLASBUILDER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FileData.h"
+#include "JobPool.h"
+#include "MipGenerator.h"
+
+struct AtlasRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Bottom left skyline packer. Keeps the top edge of everything placed so far as a list of horizontal segments and
+// puts each new rectangle where its top ends up lowest, which packs sorted images tightly for very little work.
+class SkylinePacker {
+public:
+    SkylinePacker(int width, int height);
+
+    // Returns where the rectangle went, or nothing if it doesn't fit anymore.
+    std::optional<AtlasRect> insert(int width, int height);
+
+    // Fraction of the area covered by placed rectangles.
+    [[nodiscard]] float getOccupancy() const;
+
+private:
+    struct Segment {
+        int x;
+        int y;
+        int width;
+    };
+
+    int m_width;
+    int m_height;
+    size_t m_usedArea = 0;
+    std::vector<Segment> m_skyline;
+
+    // The y a rectangle starting at segment index would sit at, or -1 if it doesn't fit there.
+    [[nodiscard]] int _fit(size_t index, int width, int height) const;
+};
+
+// Where a packed image ended up: the layer of the array texture, and its UV rectangle as offset plus size.
+struct AtlasRegion {
+    uint32_t layer = 0;
+    float u = 0.0f;
+    float v = 0.0f;
+    float width = 1.0f;
+    float height = 1.0f;
+};
+
+// Packed RGBA8 pages, all the same square size, with their mips and the region of every image.
+// Comes either from AtlasBuilder::build or from a cooked file written by save(), which maps straight back in.
+class PackedAtlas {
+public:
+    [[nodiscard]] int getPageSize() const { return m_pageSize; }
+    [[nodiscard]] size_t getLayerCount() const { return m_layerCount; }
+    [[nodiscard]] size_t getLevelCount() const { return m_levelCount; }
+    [[nodiscard]] bool isSrgb() const { return m_srgb; }
+    [[nodiscard]] const std::unordered_map<std::string, AtlasRegion>& getRegions() const { return m_regions; }
+
+    [[nodiscard]] int levelSize(const size_t level) const { return std::max(1, m_pageSize >> level); }
+    [[nodiscard]] const unsigned char* levelData(size_t layer, size_t level) const;
+
+    bool save(const std::filesystem::path& path) const;
+    // Prints ERROR::ATLAS::... and returns false if the file is missing, from another version or damaged.
+    static bool load(const std::filesystem::path& path, PackedAtlas& atlas);
+
+private:
+    friend class AtlasBuilder;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pageSize;
+        uint32_t layerCount;
+        uint32_t levelCount;
+        uint32_t regionCount;
+        uint32_t srgb;
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t MAGIC = 0x4C544145; // "EATL"
+    static constexpr uint32_t VERSION = 1;
+    // Bigger pages in a file are taken as damage, no GL implementation has array layers that large.
+    static constexpr uint32_t MAX_PAGE_SIZE = 65536;
+
+    int m_pageSize = 0;
+    size_t m_layerCount = 0;
+    size_t m_levelCount = 0;
+    bool m_srgb = false;
+    std::unordered_map<std::string, AtlasRegion> m_regions;
+
+    // Built atlases own their chains, loaded ones point into the file.
+    std::vector<MipChain> m_pages;
+    FileData m_file;
+    size_t m_pixelOffset = 0;
+};
+
+struct AtlasOptions {
+    int pageSize = 2048;
+    int padding = 4;
+    bool srgb = false;
+    bool flip = true;
+    MipFilter filter = MipFilter::Box;
+};
+
+// Collects images and packs them into PackedAtlas pages.
+// Each image gets padding pixels of gutter, filled by wrapping the image round so repeating UVs still filter
+// correctly at the edges, and sits on a grid aligned to its lowest mip. Mips stop once the gutter is one texel
+// wide, past that neighbours would bleed into each other.
+class AtlasBuilder {
+public:
+    AtlasBuilder() = default;
+    explicit AtlasBuilder(const AtlasOptions& options) : m_options(options) {}
+
+    // Copies the pixels, which must be RGBA8. Names are what regions are looked up by, so a name already added prints
+    // ERROR::ATLAS::DUPLICATE_NAME and returns false, keeping the first image.
+    bool add(const std::string& name, const unsigned char* rgba, int width, int height);
+    bool addFile(const std::string& name, const std::filesystem::path& path);
+    // Manifest lines are "name path" or just "path" (then the path is also the name), paths relative to the
+    // manifest, # starts a comment. Returns false if any image failed to load or reused a name.
+    bool addManifest(const std::filesystem::path& manifestPath);
+
+    // Prints ERROR::ATLAS::IMAGE_TOO_LARGE and returns false if an image can't fit on a page.
+    bool build(PackedAtlas& atlas, JobPool* pool = nullptr) const;
+
+    // True if cooked exists and is newer than the manifest and every image it lists.
+    static bool isUpToDate(const std::filesystem::path& manifestPath, const std::filesystem::path& cookedPath);
+    // Loads cooked if it is up to date, otherwise builds from the manifest and saves the result to cooked.
+    static bool loadOrBuild(const std::filesystem::path& manifestPath, const std::filesystem::path& cookedPath, PackedAtlas& atlas, const AtlasOptions& options = {}, JobPool* pool = nullptr);
+
+private:
+    struct Image {
+        std::string name;
+        int width;
+        int height;
+        std::vector<unsigned char> pixels;
+    };
+
+    AtlasOptions m_options;
+    std::vector<Image> m_images;
+    std::unordered_set<std::string> m_names;
+
+    // name, absolute path pairs in manifest order.
+    static std::vector<std::pair<std::string, std::filesystem::path>> _readManifest(const std::filesystem::path& manifestPath);
+};
+
+#endif //ATLASBUILDER_H
@@ -0,0 +1,119 @@
+#ifndef BINDLESSTEXTURES_H
+#define BINDLESSTEXTURES_H
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "Texture.h"
+
+// Samples textures through ARB_bindless_texture handles instead of texture units.
+// Each pair of textures an object draws with gets a slot in one uniform buffer of handles (the BindlessMaterials
+// block in shaders/include/material.glsl), and a draw only sets which slot to read. Draws that differ only by
+// texture then no longer touch any binding, which is what lets them be merged into one.
+// A handle freezes its texture's state, so textures only get one once fully loaded, and streamed ones never do.
+// Those keep being bound to units as before.
+class BindlessTextures {
+public:
+    // Must match the BindlessMaterials block. At 16 bytes a slot this stays inside the 16KB every driver allows.
+    static constexpr int MAX_MATERIALS = 1024;
+    // Blocks start out on binding 0 and this is the only block for now, so programs need no setup for it.
+    static constexpr GLuint BLOCK_BINDING = 0;
+
+    // Needs a current context. Check isSupported() afterwards, nothing else does anything without the extension.
+    explicit BindlessTextures(const GLADloadproc loader) {
+        if (!hasGlExtension("GL_ARB_bindless_texture")) { return; }
+
+        m_getTextureHandle = reinterpret_cast<PFNGLGETTEXTUREHANDLEARBPROC>(loader("glGetTextureHandleARB"));
+        m_getTextureSamplerHandle = reinterpret_cast<PFNGLGETTEXTURESAMPLERHANDLEARBPROC>(loader("glGetTextureSamplerHandleARB"));
+        m_makeTextureHandleResident = reinterpret_cast<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(loader("glMakeTextureHandleResidentARB"));
+        if (!m_getTextureHandle || !m_getTextureSamplerHandle || !m_makeTextureHandleResident) { return; }
+
+        glGenBuffers(1, &m_buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(Slot), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    [[nodiscard]] bool isSupported() const { return m_buffer != 0; }
+
+    // Resident handle for texture sampled with sampler (0 for the texture's own parameters), created the first time
+    // it is asked for. 0 while it can't have one. The sampler is frozen too, which SamplerCache's never change anyway.
+    GLuint64 handleFor(const Texture& texture, const GLuint sampler = 0) const {
+        for (const auto& [handleSampler, handle] : texture.m_bindlessHandles) {
+            if (handleSampler == sampler) { return handle; }
+        }
+        if (!isSupported() || !texture.isReady() || texture.m_streamed) { return 0; }
+
+        const GLuint64 handle = sampler != 0 ? m_getTextureSamplerHandle(texture.ID, sampler) : m_getTextureHandle(texture.ID);
+        if (handle == 0) { return 0; }
+
+        m_makeTextureHandleResident(handle);
+        texture.m_bindlessHandles.emplace_back(sampler, handle);
+        return handle;
+    }
+
+    // Slot holding the handles of textures[0] and textures[1] (textures[0] twice for a single texture). -1 if either
+    // has no handle yet, there are more than two, or the table is full for this frame.
+    int materialFor(const std::vector<std::shared_ptr<Texture>>& textures, const GLuint sampler = 0) {
+        if (textures.empty() || textures.size() > 2) { return -1; }
+
+        const GLuint64 first = handleFor(*textures[0], sampler);
+        const GLuint64 second = textures.size() > 1 ? handleFor(*textures[1], sampler) : first;
+        if (first == 0 || second == 0) { return -1; }
+
+        const Slot slot = { first, second };
+        if (const auto it = m_slots.find(slot); it != m_slots.end()) {
+            return it->second;
+        }
+        if (m_slots.size() >= MAX_MATERIALS) { return -1; }
+
+        const int index = static_cast<int>(m_slots.size());
+        glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, static_cast<GLintptr>(index * sizeof(Slot)), sizeof(Slot), &slot);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        m_slots.emplace(slot, index);
+        return index;
+    }
+
+    // Call at the start of every frame. Slots are never freed one at a time, once the table fills up it starts over
+    // here, and objects claim a slot again the next time they draw.
+    void beginFrame() {
+        if (m_slots.size() >= MAX_MATERIALS) {
+            m_slots.clear();
+        }
+        glBindBufferBase(GL_UNIFORM_BUFFER, BLOCK_BINDING, m_buffer);
+    }
+
+    void destroy() const {
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+private:
+    // One uvec4 of the block: texture1 in xy, texture2 in zw.
+    struct Slot {
+        GLuint64 first;
+        GLuint64 second;
+
+        bool operator==(const Slot& other) const { return first == other.first && second == other.second; }
+    };
+
+    struct SlotHash {
+        size_t operator()(const Slot& slot) const {
+            return std::hash<GLuint64>()(slot.first) ^ std::hash<GLuint64>()(slot.second) * 0x9E3779B97F4A7C15ull;
+        }
+    };
+
+    PFNGLGETTEXTUREHANDLEARBPROC m_getTextureHandle = nullptr;
+    PFNGLGETTEXTURESAMPLERHANDLEARBPROC m_getTextureSamplerHandle = nullptr;
+    PFNGLMAKETEXTUREHANDLERESIDENTARBPROC m_makeTextureHandleResident = nullptr;
+    unsigned int m_buffer = 0;
+    std::unordered_map<Slot, int, SlotHash> m_slots;
+};
+
+#endif //BINDLESSTEXTURES_H
@@ -5,6 +5,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "MathHeaders/Trig.h"
+
 enum CameraMovement {
 	FORWARD,
 	BACKWARD,
@@ -90,11 +92,11 @@ public:
 
 private:
 	void updateCameraVectors() {
-		const glm::vec3 front = glm::vec3(
-			cos(glm::radians(Yaw)) * cos(glm::radians(Pitch)),
-			sin(glm::radians(Pitch)),
-			sin(glm::radians(Yaw)) * cos(glm::radians(Pitch))
-		);
+		float sinYaw, cosYaw, sinPitch, cosPitch;
+		emc::SinCos(glm::radians(Yaw), sinYaw, cosYaw);
+		emc::SinCos(glm::radians(Pitch), sinPitch, cosPitch);
+
+		const glm::vec3 front = glm::vec3(cosYaw * cosPitch, sinPitch, sinYaw * cosPitch);
 
 		Front = normalize(front);
 		Right = normalize(cross(Front, WorldUp));
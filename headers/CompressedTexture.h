@@ -0,0 +1,42 @@
+#ifndef COMPRESSEDTEXTURE_H
+#define COMPRESSEDTEXTURE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "FileData.h"
+
+// One mip level inside a CompressedImage's file.
+struct CompressedLevel {
+    size_t offset;
+    size_t size;
+    int width;
+    int height;
+};
+
+// A block compressed image (BC1, BC3, BC4, BC5 or BC7) read from a DDS or KTX2 container.
+// The levels point straight into the loaded file, nothing is decoded or copied.
+struct CompressedImage {
+    GLenum internalFormat = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<CompressedLevel> levels;
+    FileData file;
+
+    [[nodiscard]] const unsigned char* levelData(const size_t level) const { return file.bytes() + levels[level].offset; }
+};
+
+// True for paths with a .dds or .ktx2 extension.
+bool isCompressedTexturePath(const std::string& path);
+
+// Parses a DDS or KTX2 file. Only single 2D images are supported, no arrays, cubemaps or KTX2 supercompression.
+// Prints ERROR::TEXTURE::... and returns false for anything else.
+bool loadCompressedImage(FileData file, CompressedImage& image);
+
+// Whether the current context can sample internalFormat. Needs a current GL context.
+bool isCompressedFormatSupported(GLenum internalFormat);
+
+#endif //COMPRESSEDTEXTURE_H
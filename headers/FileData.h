@@ -0,0 +1,55 @@
+#ifndef FILEDATA_H
+#define FILEDATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Read only view of a whole file's bytes, for passing straight to GL or a decoder without intermediate copies.
+// Large files are memory mapped where the platform allows it. Small ones, and everything elsewhere, are read with
+// one call into a buffer borrowed from a shared pool, so repeated loads don't keep allocating.
+// Mapped files must not be truncated while open, which is why sources that get edited live stay under the map threshold.
+class FileData {
+public:
+    // Files this size and up are mapped rather than read.
+    static constexpr size_t MAP_THRESHOLD = 64 * 1024;
+
+    FileData() = default;
+    ~FileData();
+
+    FileData(FileData&& other) noexcept;
+    FileData& operator=(FileData&& other) noexcept;
+    FileData(const FileData&) = delete;
+    FileData& operator=(const FileData&) = delete;
+
+    // Returns an invalid FileData if the file can't be opened, and prints ERROR::FILE::NOT_READ.
+    static FileData open(const std::filesystem::path& path);
+
+    [[nodiscard]] bool isValid() const { return m_valid; }
+    explicit operator bool() const { return m_valid; }
+
+    [[nodiscard]] const char* data() const { return m_data; }
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] std::string_view view() const { return { m_data, m_size }; }
+    [[nodiscard]] const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>(m_data); }
+    [[nodiscard]] bool isMapped() const { return m_mapped; }
+
+    // Asks the OS to start reading a mapped file in now, ahead of first use. No-op for buffered files.
+    void prefetch() const;
+
+    // 64 bit hash of the contents, for caches keyed on what a file holds rather than where it lives. 0 when invalid.
+    [[nodiscard]] uint64_t hash() const;
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_valid = false;
+    bool m_mapped = false;
+    std::vector<char> m_buffer;
+
+    void _release();
+};
+
+#endif //FILEDATA_H
@@ -0,0 +1,136 @@
+#ifndef GEOMETRYHEAP_H
+#define GEOMETRYHEAP_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "VertexArrayCache.h"
+#include "VertexLayout.h"
+
+// Hands out ranges of [0, capacity) in whatever unit the caller counts in. Free blocks are kept both by offset, to
+// merge neighbours as they are freed, and by size, so allocation takes the smallest block that fits.
+class FreeListAllocator {
+public:
+    static constexpr size_t INVALID = ~static_cast<size_t>(0);
+
+    explicit FreeListAllocator(size_t capacity = 0);
+
+    // Offset of size free units, or INVALID if no block is big enough.
+    size_t allocate(size_t size);
+    // Claims exactly [offset, offset + size), which must be free. Used to move allocations into place.
+    void allocateAt(size_t offset, size_t size);
+    void free(size_t offset, size_t size);
+    // Adds [capacity, newCapacity) as free space.
+    void grow(size_t newCapacity);
+
+    [[nodiscard]] size_t getCapacity() const { return m_capacity; }
+    [[nodiscard]] size_t getUsed() const { return m_used; }
+    [[nodiscard]] size_t getLargestFree() const { return m_bySize.empty() ? 0 : m_bySize.rbegin()->first; }
+    // Offset to size of every free block, lowest first.
+    [[nodiscard]] const std::map<size_t, size_t>& getFreeBlocks() const { return m_byOffset; }
+
+private:
+    std::map<size_t, size_t> m_byOffset;
+    std::set<std::pair<size_t, size_t>> m_bySize;
+    size_t m_capacity = 0;
+    size_t m_used = 0;
+
+    void _insert(size_t offset, size_t size);
+    void _erase(std::map<size_t, size_t>::iterator block);
+};
+
+// Every mesh's vertices and indices sub-allocated out of a few large buffers, one set per vertex layout, rather than
+// buffers of their own. Meshes sharing a layout then share one VAO, draw with glDrawElementsBaseVertex at their
+// offsets, and can be batched. Buffers double when full, and defragment() moves allocations down into the holes
+// meshes leave behind when they are freed, under a byte budget so streaming meshes in and out spreads the copying
+// over many frames.
+class GeometryHeap {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = ~0u;
+
+    // Where a mesh currently is. Offsets change when the heap defragments, so look them up each draw.
+    struct Allocation {
+        uint32_t pool;
+        size_t vertexOffset;
+        size_t vertexCount;
+        // In 4 byte words, so 16 and 32 bit indices can share a buffer and stay aligned.
+        size_t indexOffset;
+        size_t indexWords;
+    };
+
+    struct Stats {
+        size_t pools = 0;
+        size_t allocations = 0;
+        size_t vertexBytes = 0;
+        size_t vertexBytesUsed = 0;
+        size_t indexBytes = 0;
+        size_t indexBytesUsed = 0;
+        size_t bytesMoved = 0;
+    };
+
+    // Room for this many vertices and index bytes in each layout's buffers to start with.
+    static constexpr size_t INITIAL_VERTICES = 64 * 1024;
+    static constexpr size_t INITIAL_INDEX_BYTES = 1024 * 1024;
+
+    explicit GeometryHeap(VertexArrayCache& vertexArrays) : m_vertexArrays(vertexArrays) {}
+
+    // Copies a mesh in: streams holds vertexCount vertices per stream of layout (see packVertexStreams), indices any
+    // mix of index types. Needs a current context.
+    Handle allocate(const VertexLayout& layout, const std::array<std::vector<unsigned char>, VertexLayout::MAX_STREAMS>& streams,
+                    size_t vertexCount, const std::vector<unsigned char>& indices);
+    void free(Handle handle);
+
+    [[nodiscard]] const Allocation& get(const Handle handle) const { return m_allocations[handle]; }
+    // The VAO shared by every mesh in handle's pool, reading every attribute or only positions.
+    [[nodiscard]] GLuint getVertexArray(Handle handle, bool positionsOnly) const;
+
+    // Moves allocations down over the holes below them, copying no more than budgetBytes. An allocation bigger than
+    // what is left of the budget stays where it is, and one bigger than the whole budget never moves. Returns the
+    // bytes moved, 0 once there is nothing left that can be closed.
+    size_t defragment(size_t budgetBytes);
+
+    [[nodiscard]] Stats getStats() const;
+    void destroy();
+
+private:
+    struct Pool {
+        VertexLayout layout;
+        VertexLayout positionLayout;
+        std::array<GLuint, VertexLayout::MAX_STREAMS> vertexBuffers{};
+        GLuint indexBuffer = 0;
+        FreeListAllocator vertices;
+        FreeListAllocator indices;
+        // Allocation at each offset, to find what sits right above a hole.
+        std::map<size_t, Handle> vertexOwners;
+        std::map<size_t, Handle> indexOwners;
+    };
+
+    VertexArrayCache& m_vertexArrays;
+    std::vector<Pool> m_pools;
+    std::vector<Allocation> m_allocations;
+    std::vector<Handle> m_freeHandles;
+    size_t m_bytesMoved = 0;
+    // Moves go through here, so each is two copies however far it goes.
+    GLuint m_scratch = 0;
+    size_t m_scratchSize = 0;
+
+    uint32_t _poolFor(const VertexLayout& layout);
+    void _growVertices(Pool& pool, size_t minimum);
+    void _growIndices(Pool& pool, size_t minimum);
+    // A buffer can't copy onto an overlapping range of itself, so data is staged through the scratch buffer.
+    void _moveWithin(GLuint buffer, size_t from, size_t to, size_t size);
+    // Slides allocations of one allocator down into the holes below them. Offsets and sizes are in the allocator's
+    // units of unitBytes, move copies the data of count units.
+    size_t _compact(FreeListAllocator& space, std::map<size_t, Handle>& owners, size_t Allocation::* offset, size_t Allocation::* count,
+                    size_t unitBytes, size_t budgetBytes, const std::function<void(size_t from, size_t to, size_t count)>& move);
+};
+
+#endif //GEOMETRYHEAP_H
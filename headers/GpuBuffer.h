@@ -1,58 +1,97 @@
 #ifndef GPUBUFFER_H
 #define GPUBUFFER_H
 
+#include <array>
+#include <vector>
+
+#include "GeometryHeap.h"
+#include "IndexBuffer.h"
+#include "VertexLayout.h"
+
 struct Vertex {
     glm::vec3 position;
     glm::vec2 texCoord;
 };
 
+// One byte array per stream of layout, holding vertices encoded the way it describes.
+inline std::array<std::vector<unsigned char>, VertexLayout::MAX_STREAMS> packVertexStreams(const std::vector<Vertex>& vertices, const VertexLayout& layout) {
+    std::array<std::vector<unsigned char>, VertexLayout::MAX_STREAMS> streams;
+    for (uint32_t stream = 0; stream < layout.getStreamCount(); ++stream) {
+        streams[stream].resize(vertices.size() * layout.getStride(stream));
+    }
+
+    for (const VertexLayoutAttribute& attribute : layout.getAttributes()) {
+        const uint32_t stride = layout.getStride(attribute.stream);
+        unsigned char* out = streams[attribute.stream].data() + attribute.offset;
+        for (const Vertex& vertex : vertices) {
+            if (attribute.semantic == VertexSemantic::Position) {
+                const float values[4] = { vertex.position.x, vertex.position.y, vertex.position.z, 1.0f };
+                encodeVertexAttribute(values, attribute.format, out);
+            } else {
+                const float values[4] = { vertex.texCoord.x, vertex.texCoord.y, 0.0f, 0.0f };
+                encodeVertexAttribute(values, attribute.format, out);
+            }
+            out += stride;
+        }
+    }
+    return streams;
+}
+
 class GpuBuffer {
 public:
     virtual ~GpuBuffer() = default;
 
-    unsigned int VAO = 0;
-    unsigned int VBO = 0;
-    unsigned int EBO = 0;
+    VertexLayout layout;
     int indexCount = 0;
+    // GL_UNSIGNED_SHORT whenever the mesh allows it, see packIndexBuffer.
+    GLenum indexType = GL_UNSIGNED_INT;
+    // One draw each. A single range unless the mesh had to be split for 16 bit indices.
+    std::vector<IndexRange> ranges;
 };
 
 class OpenGLGpuBuffer : public GpuBuffer {
 public:
-    OpenGLGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
-        this->indexCount = static_cast<int>(indices.size());
+    // Vertices and indices are copied into heap, which must outlive the buffer.
+    OpenGLGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const VertexLayout& layout, GeometryHeap& heap)
+        : m_heap(heap) {
+        this->layout = layout;
         _setupBuffers(vertices, indices);
     }
-    ~OpenGLGpuBuffer() override {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-    }
-
-private:
-    void _setupBuffers(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices) {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+    ~OpenGLGpuBuffer() override { m_heap.free(m_allocation); }
 
-        glBindVertexArray(VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    // VAO shared with every buffer of the same layout, reading every attribute or only positions.
+    [[nodiscard]] GLuint getVertexArray(const bool positionsOnly = false) const {
+        return m_heap.getVertexArray(m_allocation, positionsOnly);
+    }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    // Where range is in the heap's buffers right now, defragmenting moves it.
+    [[nodiscard]] size_t getFirstIndex(const IndexRange& range) const {
+        return m_heap.get(m_allocation).indexOffset * 4 / getIndexSize() + range.firstIndex;
+    }
+    [[nodiscard]] GLint getBaseVertex(const IndexRange& range) const {
+        return static_cast<GLint>(m_heap.get(m_allocation).vertexOffset) + range.baseVertex;
+    }
+    [[nodiscard]] size_t getIndexSize() const { return indexType == GL_UNSIGNED_SHORT ? 2 : 4; }
 
-        // Position
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
+private:
+    GeometryHeap& m_heap;
+    GeometryHeap::Handle m_allocation = GeometryHeap::INVALID_HANDLE;
 
-        // Normals will go here, and will follow the same offset pattern, it will be part of vertex.
+    void _setupBuffers(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices) {
+        PackedIndexBuffer packed = packIndexBuffer(indices, vertices.size(), layout.getVertexSize());
+        indexType = packed.type;
+        ranges = std::move(packed.ranges);
+        indexCount = static_cast<int>(packed.data.size() / packed.getIndexSize());
 
-        // TexCoord
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, texCoord)));
+        // Splitting reorders vertices and duplicates the ones ranges share.
+        std::vector<Vertex> remapped;
+        if (!packed.vertexRemap.empty()) {
+            remapped.reserve(packed.vertexRemap.size());
+            for (const unsigned int vertex : packed.vertexRemap) { remapped.push_back(vertices[vertex]); }
+        }
 
-        glBindVertexArray(0);
+        const std::vector<Vertex>& uploaded = packed.vertexRemap.empty() ? vertices : remapped;
+        m_allocation = m_heap.allocate(layout, packVertexStreams(uploaded, layout), uploaded.size(), packed.data);
     }
 };
 
@@ -0,0 +1,37 @@
+#ifndef INDEXBUFFER_H
+#define INDEXBUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// Part of an index buffer drawn with one glDrawElementsBaseVertex call.
+struct IndexRange {
+    size_t firstIndex;
+    size_t indexCount;
+    // Added to every index in the range, so 16 bit indices can reach vertices past 65535.
+    GLint baseVertex;
+};
+
+// Indices as they go to the GPU: in the smallest type that can hold them, split into ranges when that's needed.
+struct PackedIndexBuffer {
+    GLenum type = GL_UNSIGNED_INT;
+    std::vector<unsigned char> data;
+    std::vector<IndexRange> ranges;
+    // Source vertex of each vertex the indices now refer to, when splitting had to reorder and duplicate them. Empty
+    // when the original vertices are used as they are.
+    std::vector<unsigned int> vertexRemap;
+
+    [[nodiscard]] size_t getIndexSize() const { return type == GL_UNSIGNED_SHORT ? 2 : 4; }
+};
+
+// Largest vertex count a range can reach with 16 bit indices.
+constexpr size_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+// Picks 16 bit indices when vertexCount allows it. Bigger meshes are cut, in triangle order, into ranges that each
+// use fewer than MAX_SHORT_INDEX_VERTICES vertices, with the vertices on a cut duplicated into both ranges. That is
+// only done when the index bytes saved outweigh vertexSize bytes per duplicate, otherwise the indices stay 32 bit.
+PackedIndexBuffer packIndexBuffer(const std::vector<unsigned int>& indices, size_t vertexCount, size_t vertexSize);
+
+#endif //INDEXBUFFER_H
@@ -0,0 +1,42 @@
+#ifndef JOBPOOL_H
+#define JOBPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued jobs.
+// parallelFor splits a range into chunks the calling thread works through alongside the workers, so it is safe to
+// call from inside a job: it never just blocks waiting for a worker that might be busy running its own caller.
+// Jobs still queued when the pool is destroyed are dropped, ones already running are waited for.
+class JobPool {
+public:
+    // threadCount 0 picks one less than the hardware thread count, at least one.
+    explicit JobPool(unsigned int threadCount = 0);
+    ~JobPool();
+
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+    // Calls body(begin, end) over [0, count) in chunks of at most grain items and returns once every chunk is done.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    [[nodiscard]] unsigned int getThreadCount() const { return static_cast<unsigned int>(m_threads.size()); }
+
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_stopping = false;
+
+    void _work();
+};
+
+#endif //JOBPOOL_H
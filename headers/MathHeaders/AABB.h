@@ -0,0 +1,101 @@
+#ifndef AABB_H
+#define AABB_H
+
+#pragma once
+
+#include <cmath>
+#include <string>
+#include "Matrix4.h"
+#include "Sphere.h"
+#include "Vector3.h"
+
+namespace emc {
+    // Axis aligned bounding box stored as min/max corners.
+    struct AABB {
+        Vector3 min;
+        Vector3 max;
+
+        AABB() = default;
+        AABB(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+        static AABB FromCenterExtents(const Vector3& center, const Vector3& extents) {
+            return { center - extents, center + extents };
+        }
+
+        // Smallest box around a set of points, e.g. a mesh's vertex positions. stride is in bytes.
+        static AABB FromPoints(const float* points, const size_t count, const size_t stride = sizeof(float) * 3) {
+            if (count == 0) { return {}; }
+            AABB box({points[0], points[1], points[2]}, {points[0], points[1], points[2]});
+            for (size_t i = 1; i < count; ++i) {
+                const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(points) + i * stride);
+                box.Expand({p[0], p[1], p[2]});
+            }
+            return box;
+        }
+
+        [[nodiscard]] std::string ToString() const {
+            return min.ToString() + max.ToString();
+        }
+
+        [[nodiscard]] Vector3 Center() const { return (min + max) * 0.5f; }
+        [[nodiscard]] Vector3 Extents() const { return (max - min) * 0.5f; }
+
+        void Expand(const Vector3& point) {
+            min = { std::fmin(min.x, point.x), std::fmin(min.y, point.y), std::fmin(min.z, point.z) };
+            max = { std::fmax(max.x, point.x), std::fmax(max.y, point.y), std::fmax(max.z, point.z) };
+        }
+
+        void Expand(const AABB& other) {
+            Expand(other.min);
+            Expand(other.max);
+        }
+
+        [[nodiscard]] bool Contains(const Vector3& point) const {
+            return point.x >= min.x && point.x <= max.x &&
+                   point.y >= min.y && point.y <= max.y &&
+                   point.z >= min.z && point.z <= max.z;
+        }
+
+        [[nodiscard]] bool Intersects(const AABB& other) const {
+            return min.x <= other.max.x && max.x >= other.min.x &&
+                   min.y <= other.max.y && max.y >= other.min.y &&
+                   min.z <= other.max.z && max.z >= other.min.z;
+        }
+
+        [[nodiscard]] bool Intersects(const Sphere& sphere) const {
+            // Distance from the sphere center to the closest point on the box.
+            const float dx = std::fmax(std::fmax(min.x - sphere.center.x, 0.0f), sphere.center.x - max.x);
+            const float dy = std::fmax(std::fmax(min.y - sphere.center.y, 0.0f), sphere.center.y - max.y);
+            const float dz = std::fmax(std::fmax(min.z - sphere.center.z, 0.0f), sphere.center.z - max.z);
+            return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius;
+        }
+
+        // Box around this box after an affine transform (Arvo's method), e.g. local bounds to world bounds.
+        [[nodiscard]] AABB Transformed(const Matrix4& transform) const {
+            const Vector3 center = Center();
+            const Vector3 extents = Extents();
+
+            const Vector3 newCenter = {
+                transform.m1 * center.x + transform.m5 * center.y + transform.m9 * center.z + transform.m13,
+                transform.m2 * center.x + transform.m6 * center.y + transform.m10 * center.z + transform.m14,
+                transform.m3 * center.x + transform.m7 * center.y + transform.m11 * center.z + transform.m15
+            };
+            const Vector3 newExtents = {
+                std::abs(transform.m1) * extents.x + std::abs(transform.m5) * extents.y + std::abs(transform.m9) * extents.z,
+                std::abs(transform.m2) * extents.x + std::abs(transform.m6) * extents.y + std::abs(transform.m10) * extents.z,
+                std::abs(transform.m3) * extents.x + std::abs(transform.m7) * extents.y + std::abs(transform.m11) * extents.z
+            };
+            return FromCenterExtents(newCenter, newExtents);
+        }
+
+        [[nodiscard]] Sphere BoundingSphere() const {
+            return { Center(), Extents().Magnitude() };
+        }
+
+        bool operator==(const AABB& other) const {
+            return min == other.min && max == other.max;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef COLOURSPACE_H
+#define COLOURSPACE_H
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Colour.h"
+#include "Vector4.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMC_COLOUR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Bulk colour conversions shared by texture processing, vertex colours and clear colours.
+// Pixel arrays are RGBA8 in memory order (what stb_image hands back) or four floats per pixel.
+// Alpha is always linear, only RGB goes through the sRGB curve.
+namespace emc {
+    // Exact sRGB transfer functions, reference for the tables below.
+    inline float SrgbToLinear(const float value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline float LinearToSrgb(const float value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    namespace colour_detail {
+        // 8 bit sRGB to linear float, exact.
+        inline const std::array<float, 256>& SrgbDecodeTable() {
+            static const std::array<float, 256> table = [] {
+                std::array<float, 256> t{};
+                for (int i = 0; i < 256; ++i) { t[i] = SrgbToLinear(static_cast<float>(i) / 255.0f); }
+                return t;
+            }();
+            return table;
+        }
+
+        // Linear float to 8 bit sRGB. Indexed by the float's exponent and top mantissa bits, so buckets are
+        // finest near black where the curve is steepest, and interpolated linearly inside each bucket.
+        // Matches exact rounding of LinearToSrgb(x) * 255 except within 0.02 of a half step.
+        constexpr int ENCODE_MANTISSA_BITS = 6;
+        constexpr int ENCODE_OCTAVES = 13;                          // [2^-13, 1)
+        constexpr uint32_t ENCODE_MIN_BITS = (127u - ENCODE_OCTAVES) << 23;
+        constexpr int ENCODE_BUCKETS = ENCODE_OCTAVES << ENCODE_MANTISSA_BITS;
+
+        inline const std::array<float, ENCODE_BUCKETS + 1>& SrgbEncodeTable() {
+            static const std::array<float, ENCODE_BUCKETS + 1> table = [] {
+                std::array<float, ENCODE_BUCKETS + 1> t{};
+                for (int i = 0; i <= ENCODE_BUCKETS; ++i) {
+                    const uint32_t bits = ENCODE_MIN_BITS + (static_cast<uint32_t>(i) << (23 - ENCODE_MANTISSA_BITS));
+                    float x;
+                    std::memcpy(&x, &bits, sizeof(x));
+                    t[i] = LinearToSrgb(x) * 255.0f;
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        inline uint8_t EncodeSrgb8(const float value) {
+            if (!(value > 0.0f)) { return 0; }
+            if (value >= 1.0f) { return 255; }
+
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            if (bits < ENCODE_MIN_BITS) {
+                // Below the table everything sits on the linear segment of the curve.
+                return static_cast<uint8_t>(value * (12.92f * 255.0f) + 0.5f);
+            }
+
+            const auto& table = SrgbEncodeTable();
+            const uint32_t offset = bits - ENCODE_MIN_BITS;
+            const uint32_t index = offset >> (23 - ENCODE_MANTISSA_BITS);
+            const float frac = static_cast<float>(offset & ((1u << (23 - ENCODE_MANTISSA_BITS)) - 1)) * (1.0f / (1 << (23 - ENCODE_MANTISSA_BITS)));
+            return static_cast<uint8_t>(table[index] + (table[index + 1] - table[index]) * frac + 0.5f);
+        }
+
+        // (value * alpha) / 255 rounded, exact for all 8 bit inputs.
+        inline uint8_t MulDiv255(const unsigned int value, const unsigned int alpha) {
+            const unsigned int t = value * alpha + 128;
+            return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+        }
+    }
+
+    inline float SrgbToLinear8(const uint8_t value) { return colour_detail::SrgbDecodeTable()[value]; }
+    inline uint8_t LinearToSrgb8(const float value) { return colour_detail::EncodeSrgb8(value); }
+
+    // Colour stores red in the high byte. These give 0-1 floats, optionally decoding sRGB to linear.
+    inline Vector4 ColourToVector4(const Colour colour) {
+        constexpr float inv = 1.0f / 255.0f;
+        return { colour.GetRed() * inv, colour.GetGreen() * inv, colour.GetBlue() * inv, colour.GetAlpha() * inv };
+    }
+
+    inline Vector4 ColourToLinear(const Colour colour) {
+        return { SrgbToLinear8(colour.GetRed()), SrgbToLinear8(colour.GetGreen()), SrgbToLinear8(colour.GetBlue()), colour.GetAlpha() * (1.0f / 255.0f) };
+    }
+
+    inline Colour LinearToColour(const Vector4& linear) {
+        const float alpha = linear.w < 0.0f ? 0.0f : (linear.w > 1.0f ? 1.0f : linear.w);
+        return { LinearToSrgb8(linear.x), LinearToSrgb8(linear.y), LinearToSrgb8(linear.z), static_cast<Byte>(alpha * 255.0f + 0.5f) };
+    }
+
+    // RGBA8 to 0-1 floats, no curve applied.
+    inline void Rgba8ToFloat(const uint8_t* rgba, float* out, const size_t pixelCount) {
+        const size_t count = pixelCount * 4;
+        size_t i = 0;
+#ifdef EMC_COLOUR_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i));
+            const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+            _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+            _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+        }
+#endif
+        for (; i < count; ++i) { out[i] = rgba[i] * (1.0f / 255.0f); }
+    }
+
+    // 0-1 floats to RGBA8, clamped and rounded, no curve applied.
+    inline void FloatToRgba8(const float* in, uint8_t* rgba, const size_t pixelCount) {
+        const size_t count = pixelCount * 4;
+        size_t i = 0;
+#ifdef EMC_COLOUR_SSE2
+        const __m128 scale = _mm_set1_ps(255.0f), lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f);
+        for (; i + 16 <= count; i += 16) {
+            __m128i v[4];
+            for (int k = 0; k < 4; ++k) {
+                const __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + k * 4), lo), hi);
+                v[k] = _mm_cvtps_epi32(_mm_mul_ps(f, scale));
+            }
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i), packed);
+        }
+#endif
+        for (; i < count; ++i) {
+            const float f = in[i] < 0.0f ? 0.0f : (in[i] > 1.0f ? 1.0f : in[i]);
+            rgba[i] = static_cast<uint8_t>(std::nearbyint(f * 255.0f));
+        }
+    }
+
+    // sRGB encoded RGBA8 to linear floats. Table driven, exact.
+    inline void SrgbToLinear(const uint8_t* rgba, float* out, const size_t pixelCount) {
+        const auto& table = colour_detail::SrgbDecodeTable();
+        for (size_t p = 0; p < pixelCount; ++p) {
+            out[p * 4] = table[rgba[p * 4]];
+            out[p * 4 + 1] = table[rgba[p * 4 + 1]];
+            out[p * 4 + 2] = table[rgba[p * 4 + 2]];
+            out[p * 4 + 3] = rgba[p * 4 + 3] * (1.0f / 255.0f);
+        }
+    }
+
+    // Linear floats to sRGB encoded RGBA8. SSE2 does the clamping and bucket lookup math four channels at a time,
+    // the table reads themselves stay scalar since there is no gather before AVX2.
+    inline void LinearToSrgb(const float* in, uint8_t* rgba, const size_t pixelCount) {
+        size_t p = 0;
+#ifdef EMC_COLOUR_SSE2
+        using namespace colour_detail;
+        const auto& table = SrgbEncodeTable();
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128 linearScale = _mm_set1_ps(12.92f * 255.0f);
+        const __m128i minBits = _mm_set1_epi32(static_cast<int>(ENCODE_MIN_BITS));
+        const __m128i fracMask = _mm_set1_epi32((1 << (23 - ENCODE_MANTISSA_BITS)) - 1);
+        const __m128 fracScale = _mm_set1_ps(1.0f / (1 << (23 - ENCODE_MANTISSA_BITS)));
+        // Clamp just under 1 so the top bucket still has a right hand neighbour.
+        const __m128 almostOne = _mm_castsi128_ps(_mm_set1_epi32(0x3F7FFFFF));
+
+        for (; p < pixelCount; ++p) {
+            const __m128 raw = _mm_loadu_ps(in + p * 4);
+            const __m128 x = _mm_min_ps(_mm_max_ps(raw, zero), almostOne);
+            const __m128i bits = _mm_castps_si128(x);
+
+            const __m128i belowTable = _mm_cmplt_epi32(bits, minBits);
+            const __m128i offset = _mm_andnot_si128(belowTable, _mm_sub_epi32(bits, minBits));
+            const __m128i index = _mm_srli_epi32(offset, 23 - ENCODE_MANTISSA_BITS);
+            const __m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(offset, fracMask)), fracScale);
+
+            alignas(16) int32_t idx[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx), index);
+            const __m128 a = _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]], 0.0f);
+            const __m128 b = _mm_setr_ps(table[idx[0] + 1], table[idx[1] + 1], table[idx[2] + 1], 0.0f);
+
+            __m128 encoded = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), frac));
+            const __m128 linearPart = _mm_mul_ps(x, linearScale);
+            encoded = _mm_or_ps(_mm_and_ps(_mm_castsi128_ps(belowTable), linearPart), _mm_andnot_ps(_mm_castsi128_ps(belowTable), encoded));
+
+            // Saturated inputs and alpha bypass the curve.
+            const __m128 saturated = _mm_cmpge_ps(raw, one);
+            encoded = _mm_or_ps(_mm_and_ps(saturated, _mm_set1_ps(255.0f)), _mm_andnot_ps(saturated, encoded));
+            const __m128 alpha = _mm_mul_ps(_mm_min_ps(_mm_max_ps(raw, zero), one), _mm_set1_ps(255.0f));
+            const __m128 alphaMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+            encoded = _mm_or_ps(_mm_and_ps(alphaMask, _mm_add_ps(alpha, _mm_set1_ps(0.5f))), _mm_andnot_ps(alphaMask, _mm_add_ps(encoded, _mm_set1_ps(0.5f))));
+
+            const __m128i ints = _mm_cvttps_epi32(encoded);
+            const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(ints, ints), _mm_setzero_si128());
+            const int value = _mm_cvtsi128_si32(packed);
+            std::memcpy(rgba + p * 4, &value, 4);
+        }
+#endif
+        for (; p < pixelCount; ++p) {
+            rgba[p * 4] = LinearToSrgb8(in[p * 4]);
+            rgba[p * 4 + 1] = LinearToSrgb8(in[p * 4 + 1]);
+            rgba[p * 4 + 2] = LinearToSrgb8(in[p * 4 + 2]);
+            const float alpha = in[p * 4 + 3] < 0.0f ? 0.0f : (in[p * 4 + 3] > 1.0f ? 1.0f : in[p * 4 + 3]);
+            rgba[p * 4 + 3] = static_cast<uint8_t>(alpha * 255.0f + 0.5f);
+        }
+    }
+
+    // In place rgb *= a for RGBA8, rounded to nearest. Premultiply linear data for correct blending.
+    inline void PremultiplyAlpha(uint8_t* rgba, const size_t pixelCount) {
+        size_t p = 0;
+#ifdef EMC_COLOUR_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+        const __m128i alphaLane = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+        const __m128i round = _mm_set1_epi16(128);
+
+        const auto premultiply = [&](const __m128i px) {
+            // Broadcast each pixel's alpha across its four lanes, but multiply alpha itself by 255 so it survives.
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_or_si128(_mm_and_si128(alpha, rgbMask), alphaLane);
+            const __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), round);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+
+        for (; p + 4 <= pixelCount; p += 4) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + p * 4));
+            const __m128i lo = premultiply(_mm_unpacklo_epi8(bytes, zero));
+            const __m128i hi = premultiply(_mm_unpackhi_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + p * 4), _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; p < pixelCount; ++p) {
+            const unsigned int alpha = rgba[p * 4 + 3];
+            rgba[p * 4] = colour_detail::MulDiv255(rgba[p * 4], alpha);
+            rgba[p * 4 + 1] = colour_detail::MulDiv255(rgba[p * 4 + 1], alpha);
+            rgba[p * 4 + 2] = colour_detail::MulDiv255(rgba[p * 4 + 2], alpha);
+        }
+    }
+
+    inline void PremultiplyAlpha(float* rgba, const size_t pixelCount) {
+        size_t p = 0;
+#ifdef EMC_COLOUR_SSE2
+        const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 alphaOne = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+        for (; p < pixelCount; ++p) {
+            const __m128 px = _mm_loadu_ps(rgba + p * 4);
+            const __m128 alpha = _mm_shuffle_ps(px, px, _MM_SHUFFLE(3, 3, 3, 3));
+            _mm_storeu_ps(rgba + p * 4, _mm_mul_ps(px, _mm_or_ps(_mm_and_ps(alpha, rgbMask), alphaOne)));
+        }
+#endif
+        for (; p < pixelCount; ++p) {
+            rgba[p * 4] *= rgba[p * 4 + 3];
+            rgba[p * 4 + 1] *= rgba[p * 4 + 3];
+            rgba[p * 4 + 2] *= rgba[p * 4 + 3];
+        }
+    }
+
+    // Inverse of PremultiplyAlpha. Fully transparent pixels are left black.
+    inline void UnpremultiplyAlpha(float* rgba, const size_t pixelCount) {
+        for (size_t p = 0; p < pixelCount; ++p) {
+            const float alpha = rgba[p * 4 + 3];
+            const float inv = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+            rgba[p * 4] *= inv;
+            rgba[p * 4 + 1] *= inv;
+            rgba[p * 4 + 2] *= inv;
+        }
+    }
+}
+
+#endif
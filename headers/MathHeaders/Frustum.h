@@ -0,0 +1,236 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "AABB.h"
+#include "Matrix4.h"
+#include "Plane.h"
+#include "Sphere.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMC_FRUSTUM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define EMC_FRUSTUM_AVX 1
+#include <immintrin.h>
+#endif
+
+namespace emc {
+    // Boxes in structure of arrays form as center/extents, the layout the batch frustum tests read.
+    // Unused lanes should be left as zero sized boxes far outside the frustum, or just ignored in the result mask.
+    template <int N>
+    struct AABBPack {
+        static constexpr int Width = N;
+
+        alignas(N * 4) float centerX[N];
+        alignas(N * 4) float centerY[N];
+        alignas(N * 4) float centerZ[N];
+        alignas(N * 4) float extentX[N];
+        alignas(N * 4) float extentY[N];
+        alignas(N * 4) float extentZ[N];
+
+        void Set(const int lane, const AABB& box) {
+            const Vector3 center = box.Center();
+            const Vector3 extents = box.Extents();
+            centerX[lane] = center.x;
+            centerY[lane] = center.y;
+            centerZ[lane] = center.z;
+            extentX[lane] = extents.x;
+            extentY[lane] = extents.y;
+            extentZ[lane] = extents.z;
+        }
+    };
+
+    using AABBPack4 = AABBPack<4>;
+    using AABBPack8 = AABBPack<8>;
+
+    struct Frustum {
+        enum PlaneIndex { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+        // Plane normals point into the frustum.
+        Plane planes[PlaneCount];
+
+        // Extracts the six planes from a column major view-projection matrix (Gribb/Hartmann),
+        // assuming GL style clip space with depth in [-1, 1].
+        static Frustum FromMatrix(const float* m) {
+            const auto row = [m](const int i) { return Vector4(m[i], m[4 + i], m[8 + i], m[12 + i]); };
+            const Vector4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+            const auto plane = [](const Vector4& v) { return Plane(v.x, v.y, v.z, v.w).Normalised(); };
+
+            Frustum frustum;
+            frustum.planes[Left] = plane(r3 + r0);
+            frustum.planes[Right] = plane(r3 - r0);
+            frustum.planes[Bottom] = plane(r3 + r1);
+            frustum.planes[Top] = plane(r3 - r1);
+            frustum.planes[Near] = plane(r3 + r2);
+            frustum.planes[Far] = plane(r3 - r2);
+            return frustum;
+        }
+
+        static Frustum FromMatrix(const Matrix4& viewProjection) {
+            return FromMatrix(&viewProjection.m1);
+        }
+
+        [[nodiscard]] std::string ToString() const {
+            std::string str;
+            for (int i = 0; i < PlaneCount; ++i) {
+                str += planes[i].ToString() + "\n";
+            }
+            return str;
+        }
+
+        [[nodiscard]] bool Contains(const Vector3& point) const {
+            for (int i = 0; i < PlaneCount; ++i) {
+                if (planes[i].DistanceToPoint(point) < 0.0f) { return false; }
+            }
+            return true;
+        }
+
+        // The intersection tests are conservative: a shape can pass while sitting just outside a frustum corner.
+        [[nodiscard]] bool Intersects(const Sphere& sphere) const {
+            for (int i = 0; i < PlaneCount; ++i) {
+                if (planes[i].DistanceToPoint(sphere.center) < -sphere.radius) { return false; }
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool Intersects(const AABB& box) const {
+            const Vector3 center = box.Center();
+            const Vector3 extents = box.Extents();
+            for (int i = 0; i < PlaneCount; ++i) {
+                const Plane& p = planes[i];
+                const float radius = std::abs(p.normal.x) * extents.x + std::abs(p.normal.y) * extents.y + std::abs(p.normal.z) * extents.z;
+                if (p.DistanceToPoint(center) < -radius) { return false; }
+            }
+            return true;
+        }
+
+        // Bit i of the result is set when lane i of the pack intersects the frustum.
+        [[nodiscard]] int Intersects(const AABBPack4& pack) const {
+#ifdef EMC_FRUSTUM_SSE2
+            const __m128 cx = _mm_load_ps(pack.centerX), cy = _mm_load_ps(pack.centerY), cz = _mm_load_ps(pack.centerZ);
+            const __m128 ex = _mm_load_ps(pack.extentX), ey = _mm_load_ps(pack.extentY), ez = _mm_load_ps(pack.extentZ);
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+            for (int i = 0; i < PlaneCount; ++i) {
+                const Plane& p = planes[i];
+                const __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.normal.x), cx), _mm_mul_ps(_mm_set1_ps(p.normal.y), cy)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.normal.z), cz), _mm_set1_ps(p.d)));
+                const __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(p.normal.x)), ex), _mm_mul_ps(_mm_set1_ps(std::abs(p.normal.y)), ey)),
+                    _mm_mul_ps(_mm_set1_ps(std::abs(p.normal.z)), ez));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            return _mm_movemask_ps(visible);
+#else
+            return IntersectsScalar(pack);
+#endif
+        }
+
+        [[nodiscard]] int Intersects(const AABBPack8& pack) const {
+#if defined(EMC_FRUSTUM_AVX)
+            const __m256 cx = _mm256_load_ps(pack.centerX), cy = _mm256_load_ps(pack.centerY), cz = _mm256_load_ps(pack.centerZ);
+            const __m256 ex = _mm256_load_ps(pack.extentX), ey = _mm256_load_ps(pack.extentY), ez = _mm256_load_ps(pack.extentZ);
+            __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (int i = 0; i < PlaneCount; ++i) {
+                const Plane& p = planes[i];
+                const __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.normal.x), cx), _mm256_mul_ps(_mm256_set1_ps(p.normal.y), cy)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.normal.z), cz), _mm256_set1_ps(p.d)));
+                const __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal.x)), ex), _mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal.y)), ey)),
+                    _mm256_mul_ps(_mm256_set1_ps(std::abs(p.normal.z)), ez));
+                visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+            return _mm256_movemask_ps(visible);
+#else
+            // Two four wide halves.
+            AABBPack4 lo, hi;
+            for (int lane = 0; lane < 4; ++lane) {
+                lo.centerX[lane] = pack.centerX[lane]; hi.centerX[lane] = pack.centerX[lane + 4];
+                lo.centerY[lane] = pack.centerY[lane]; hi.centerY[lane] = pack.centerY[lane + 4];
+                lo.centerZ[lane] = pack.centerZ[lane]; hi.centerZ[lane] = pack.centerZ[lane + 4];
+                lo.extentX[lane] = pack.extentX[lane]; hi.extentX[lane] = pack.extentX[lane + 4];
+                lo.extentY[lane] = pack.extentY[lane]; hi.extentY[lane] = pack.extentY[lane + 4];
+                lo.extentZ[lane] = pack.extentZ[lane]; hi.extentZ[lane] = pack.extentZ[lane + 4];
+            }
+            return Intersects(lo) | (Intersects(hi) << 4);
+#endif
+        }
+
+        // Tests an array of boxes, writing 1 for visible and 0 for culled into results.
+        // Packs eight at a time with AVX and four otherwise.
+        void IntersectsBatch(const AABB* boxes, const size_t count, uint8_t* results) const {
+#if defined(EMC_FRUSTUM_AVX)
+            using Pack = AABBPack8;
+#else
+            using Pack = AABBPack4;
+#endif
+            Pack pack;
+            for (size_t base = 0; base < count; base += Pack::Width) {
+                const int lanes = static_cast<int>(count - base < Pack::Width ? count - base : Pack::Width);
+                for (int lane = 0; lane < Pack::Width; ++lane) {
+                    pack.Set(lane, lane < lanes ? boxes[base + lane] : AABB());
+                }
+                const int mask = Intersects(pack);
+                for (int lane = 0; lane < lanes; ++lane) {
+                    results[base + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+                }
+            }
+        }
+
+        // Sphere form of IntersectsBatch, spheres are tested four at a time with SSE2.
+        void IntersectsBatch(const Sphere* spheres, const size_t count, uint8_t* results) const {
+            size_t i = 0;
+#ifdef EMC_FRUSTUM_SSE2
+            for (; i + 4 <= count; i += 4) {
+                const __m128 cx = _mm_setr_ps(spheres[i].center.x, spheres[i + 1].center.x, spheres[i + 2].center.x, spheres[i + 3].center.x);
+                const __m128 cy = _mm_setr_ps(spheres[i].center.y, spheres[i + 1].center.y, spheres[i + 2].center.y, spheres[i + 3].center.y);
+                const __m128 cz = _mm_setr_ps(spheres[i].center.z, spheres[i + 1].center.z, spheres[i + 2].center.z, spheres[i + 3].center.z);
+                const __m128 r = _mm_setr_ps(spheres[i].radius, spheres[i + 1].radius, spheres[i + 2].radius, spheres[i + 3].radius);
+                __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+                for (int p = 0; p < PlaneCount; ++p) {
+                    const Plane& plane = planes[p];
+                    const __m128 distance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.x), cx), _mm_mul_ps(_mm_set1_ps(plane.normal.y), cy)),
+                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normal.z), cz), _mm_set1_ps(plane.d)));
+                    visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, r), _mm_setzero_ps()));
+                }
+
+                const int mask = _mm_movemask_ps(visible);
+                for (int lane = 0; lane < 4; ++lane) {
+                    results[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+                }
+            }
+#endif
+            for (; i < count; ++i) {
+                results[i] = Intersects(spheres[i]) ? 1 : 0;
+            }
+        }
+
+    private:
+        template <int N>
+        [[nodiscard]] int IntersectsScalar(const AABBPack<N>& pack) const {
+            int mask = 0;
+            for (int lane = 0; lane < N; ++lane) {
+                const Vector3 center(pack.centerX[lane], pack.centerY[lane], pack.centerZ[lane]);
+                const Vector3 extents(pack.extentX[lane], pack.extentY[lane], pack.extentZ[lane]);
+                if (Intersects(AABB::FromCenterExtents(center, extents))) { mask |= 1 << lane; }
+            }
+            return mask;
+        }
+    };
+}
+
+#endif
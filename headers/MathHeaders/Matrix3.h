@@ -8,6 +8,7 @@
 #include <string>
 #include <cmath>
 #include "Vector3.h"
+#include "Trig.h"
 
 namespace emc {
     struct Matrix3 {
@@ -79,25 +80,31 @@ namespace emc {
         }
 
         static Matrix3 MakeRotateX(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
                 1.0f, 0.0f, 0.0f,
-                0.0f, std::cos(theta), -std::sin(theta),
-                0.0f, std::sin(theta), std::cos(theta)
+                0.0f, c, -s,
+                0.0f, s, c
             };
         }
 
         static Matrix3 MakeRotateY(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
-                std::cos(theta), 0.0f, std::sin(theta),
+                c, 0.0f, s,
                 0.0f, 1.0f, 0.0f,
-                -std::sin(theta), 0.0f, std::cos(theta)
+                -s, 0.0f, c
             };
         }
 
         static Matrix3 MakeRotateZ(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
-                std::cos(theta), std::sin(theta), 0.0f,
-                -std::sin(theta), std::cos(theta), 0.0f,
+                c, s, 0.0f,
+                -s, c, 0.0f,
                 0.0f, 0.0f, 1.0f
             };
         }
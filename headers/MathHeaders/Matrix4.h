@@ -9,6 +9,7 @@
 #include <string>
 #include "Vector3.h"
 #include "Vector4.h"
+#include "Trig.h"
 
 namespace emc {
     struct Matrix4 {
@@ -92,27 +93,33 @@ namespace emc {
         }
 
 		static Matrix4 MakeRotateX(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
                 1.0f, 0.0f, 0.0f, 0.0f,
-                0.0f, std::cos(theta), -std::sin(theta), 0.0f,
-                0.0f, std::sin(theta), std::cos(theta), 0.0f,
+                0.0f, c, -s, 0.0f,
+                0.0f, s, c, 0.0f,
                 0.0f, 0.0f, 0.0f, 1.0f
             };
         }
 
         static Matrix4 MakeRotateY(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
-                std::cos(theta), 0.0f, std::sin(theta), 0.0f,
+                c, 0.0f, s, 0.0f,
                 0.0f, 1.0f, 0.0f, 0.0f,
-                -std::sin(theta), 0.0f, std::cos(theta), 0.0f,
+                -s, 0.0f, c, 0.0f,
                 0.0f, 0.0f, 0.0f, 1.0f
             };
         }
 
         static Matrix4 MakeRotateZ(const float theta) {
+            float s, c;
+            SinCos(theta, s, c);
             return {
-                std::cos(theta), std::sin(theta), 0.0f, 0.0f,
-                -std::sin(theta), std::cos(theta), 0.0f, 0.0f,
+                c, s, 0.0f, 0.0f,
+                -s, c, 0.0f, 0.0f,
                 0.0f, 0.0f, 1.0f, 0.0f,
                 0.0f, 0.0f, 0.0f, 1.0f
             };
@@ -0,0 +1,416 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Vector2.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMC_PACKED_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__F16C__)
+#define EMC_PACKED_F16C 1
+#include <immintrin.h>
+#endif
+
+// Compact storage types for vertex and instance data.
+// Everything here is plain data with the same layout the GPU reads, see VertexFormats.h for the matching GL descriptors.
+namespace emc {
+    namespace packed_detail {
+        inline uint32_t FloatBits(const float f) { uint32_t u; std::memcpy(&u, &f, sizeof(u)); return u; }
+        inline float BitsFloat(const uint32_t u) { float f; std::memcpy(&f, &u, sizeof(f)); return f; }
+
+        inline float Clamp(const float v, const float lo, const float hi) { return v < lo ? lo : (v > hi ? hi : v); }
+    }
+
+    // IEEE 754 binary16, round to nearest even. Overflow goes to infinity, NaN stays NaN
+    // (the F16C bulk path keeps NaN payloads, this one does not).
+    inline uint16_t FloatToHalf(const float value) {
+        using namespace packed_detail;
+        uint32_t x = FloatBits(value);
+        const uint32_t sign = (x >> 16) & 0x8000u;
+        x &= 0x7FFFFFFFu;
+
+        if (x > 0x7F800000u) { return static_cast<uint16_t>(sign | 0x7E00u); }
+        if (x >= 0x477FF000u) { return static_cast<uint16_t>(sign | 0x7C00u); }
+
+        if (x < 0x38800000u) {
+            // Result is a half denormal. Adding 0.5 lines the half ulp up with the float ulp so the FPU does the rounding.
+            const float rounded = BitsFloat(x) + 0.5f;
+            return static_cast<uint16_t>(sign | (FloatBits(rounded) - 0x3F000000u));
+        }
+
+        // Rebias the exponent and round the 13 dropped mantissa bits to nearest even.
+        const uint32_t mantissaOdd = (x >> 13) & 1u;
+        x += 0xC8000FFFu + mantissaOdd;
+        return static_cast<uint16_t>(sign | (x >> 13));
+    }
+
+    inline float HalfToFloat(const uint16_t half) {
+        using namespace packed_detail;
+        constexpr uint32_t shiftedExp = 0x7C00u << 13;
+
+        uint32_t o = (half & 0x7FFFu) << 13;
+        const uint32_t exp = o & shiftedExp;
+        o += (127 - 15) << 23;
+
+        if (exp == shiftedExp) {
+            o += (128 - 16) << 23;
+        } else if (exp == 0) {
+            o += 1 << 23;
+            o = FloatBits(BitsFloat(o) - BitsFloat(113 << 23));
+        }
+
+        return BitsFloat(o | (static_cast<uint32_t>(half & 0x8000u) << 16));
+    }
+
+    inline int16_t FloatToSnorm16(const float value) {
+        return static_cast<int16_t>(std::nearbyint(packed_detail::Clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline float Snorm16ToFloat(const int16_t value) {
+        const float f = static_cast<float>(value) * (1.0f / 32767.0f);
+        return f < -1.0f ? -1.0f : f;
+    }
+
+    inline uint16_t FloatToUnorm16(const float value) {
+        return static_cast<uint16_t>(std::nearbyint(packed_detail::Clamp(value, 0.0f, 1.0f) * 65535.0f));
+    }
+
+    inline float Unorm16ToFloat(const uint16_t value) {
+        return static_cast<float>(value) * (1.0f / 65535.0f);
+    }
+
+    struct Half2 {
+        uint16_t x, y;
+
+        Half2() : x(0), y(0) {}
+        explicit Half2(const Vector2& vec) : x(FloatToHalf(vec.x)), y(FloatToHalf(vec.y)) {}
+        Half2(const float x, const float y) : x(FloatToHalf(x)), y(FloatToHalf(y)) {}
+
+        [[nodiscard]] Vector2 ToVector2() const { return { HalfToFloat(x), HalfToFloat(y) }; }
+
+        bool operator==(const Half2& other) const { return x == other.x && y == other.y; }
+    };
+
+    struct Half4 {
+        uint16_t x, y, z, w;
+
+        Half4() : x(0), y(0), z(0), w(0) {}
+        explicit Half4(const Vector4& vec) :
+            x(FloatToHalf(vec.x)), y(FloatToHalf(vec.y)), z(FloatToHalf(vec.z)), w(FloatToHalf(vec.w)) {}
+        Half4(const float x, const float y, const float z, const float w) :
+            x(FloatToHalf(x)), y(FloatToHalf(y)), z(FloatToHalf(z)), w(FloatToHalf(w)) {}
+
+        [[nodiscard]] Vector4 ToVector4() const { return { HalfToFloat(x), HalfToFloat(y), HalfToFloat(z), HalfToFloat(w) }; }
+
+        bool operator==(const Half4& other) const { return x == other.x && y == other.y && z == other.z && w == other.w; }
+    };
+
+    // Signed normalized, each component maps [-1, 1] onto [-32767, 32767].
+    struct Snorm16x4 {
+        int16_t x, y, z, w;
+
+        Snorm16x4() : x(0), y(0), z(0), w(0) {}
+        explicit Snorm16x4(const Vector4& vec) :
+            x(FloatToSnorm16(vec.x)), y(FloatToSnorm16(vec.y)), z(FloatToSnorm16(vec.z)), w(FloatToSnorm16(vec.w)) {}
+
+        [[nodiscard]] Vector4 ToVector4() const { return { Snorm16ToFloat(x), Snorm16ToFloat(y), Snorm16ToFloat(z), Snorm16ToFloat(w) }; }
+
+        bool operator==(const Snorm16x4& other) const { return x == other.x && y == other.y && z == other.z && w == other.w; }
+    };
+
+    // Unsigned normalized, each component maps [0, 1] onto [0, 65535]. Meant for texture coordinates.
+    struct Unorm16x2 {
+        uint16_t x, y;
+
+        Unorm16x2() : x(0), y(0) {}
+        explicit Unorm16x2(const Vector2& vec) : x(FloatToUnorm16(vec.x)), y(FloatToUnorm16(vec.y)) {}
+        Unorm16x2(const float x, const float y) : x(FloatToUnorm16(x)), y(FloatToUnorm16(y)) {}
+
+        [[nodiscard]] Vector2 ToVector2() const { return { Unorm16ToFloat(x), Unorm16ToFloat(y) }; }
+
+        bool operator==(const Unorm16x2& other) const { return x == other.x && y == other.y; }
+    };
+
+    // Signed normalized 10:10:10:2 in GL_INT_2_10_10_10_REV order, x in the low bits.
+    // xyz use [-511, 511], w is -1, 0 or 1 (handy for tangent handedness).
+    struct Snorm1010102 {
+        uint32_t bits;
+
+        Snorm1010102() : bits(0) {}
+        explicit Snorm1010102(const Vector3& vec, const float w = 0.0f) { bits = Encode(vec.x, vec.y, vec.z, w); }
+        explicit Snorm1010102(const Vector4& vec) { bits = Encode(vec.x, vec.y, vec.z, vec.w); }
+
+        [[nodiscard]] Vector4 ToVector4() const {
+            const int32_t raw = static_cast<int32_t>(bits);
+            return {
+                Component(raw << 22 >> 22, 1.0f / 511.0f),
+                Component(raw << 12 >> 22, 1.0f / 511.0f),
+                Component(raw << 2 >> 22, 1.0f / 511.0f),
+                Component(raw >> 30, 1.0f)
+            };
+        }
+
+        [[nodiscard]] Vector3 ToVector3() const {
+            const Vector4 vec = ToVector4();
+            return { vec.x, vec.y, vec.z };
+        }
+
+        bool operator==(const Snorm1010102& other) const { return bits == other.bits; }
+
+        static uint32_t Encode(const float x, const float y, const float z, const float w) {
+            using packed_detail::Clamp;
+            const auto ix = static_cast<int32_t>(std::nearbyint(Clamp(x, -1.0f, 1.0f) * 511.0f));
+            const auto iy = static_cast<int32_t>(std::nearbyint(Clamp(y, -1.0f, 1.0f) * 511.0f));
+            const auto iz = static_cast<int32_t>(std::nearbyint(Clamp(z, -1.0f, 1.0f) * 511.0f));
+            const auto iw = static_cast<int32_t>(std::nearbyint(Clamp(w, -1.0f, 1.0f)));
+            return (static_cast<uint32_t>(ix) & 0x3FFu) | ((static_cast<uint32_t>(iy) & 0x3FFu) << 10) |
+                   ((static_cast<uint32_t>(iz) & 0x3FFu) << 20) | ((static_cast<uint32_t>(iw) & 0x3u) << 30);
+        }
+
+    private:
+        static float Component(const int32_t value, const float inverseScale) {
+            const float f = static_cast<float>(value) * inverseScale;
+            return f < -1.0f ? -1.0f : f;
+        }
+    };
+
+    static_assert(sizeof(Half2) == 4 && sizeof(Half4) == 8, "Half types must be tightly packed");
+    static_assert(sizeof(Snorm16x4) == 8 && sizeof(Unorm16x2) == 4 && sizeof(Snorm1010102) == 4, "Packed types must be tightly packed");
+
+#ifdef EMC_PACKED_SSE2
+    namespace packed_detail {
+        // Same algorithm as FloatToHalf, four lanes, results in the low 16 bits of each 32 bit lane.
+        inline __m128i FloatToHalf4(const __m128 value) {
+            const __m128i x = _mm_castps_si128(value);
+            const __m128i sign = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(0x8000));
+            const __m128i absX = _mm_and_si128(x, _mm_set1_epi32(0x7FFFFFFF));
+
+            const __m128 denormRounded = _mm_add_ps(_mm_castsi128_ps(absX), _mm_set1_ps(0.5f));
+            const __m128i denorm = _mm_sub_epi32(_mm_castps_si128(denormRounded), _mm_set1_epi32(0x3F000000));
+
+            const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(absX, 13), _mm_set1_epi32(1));
+            __m128i normal = _mm_add_epi32(absX, _mm_set1_epi32(static_cast<int>(0xC8000FFFu)));
+            normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+            const __m128i isDenorm = _mm_cmplt_epi32(absX, _mm_set1_epi32(0x38800000));
+            const __m128i isOverflow = _mm_cmpgt_epi32(absX, _mm_set1_epi32(0x477FEFFF));
+            const __m128i isNan = _mm_cmpgt_epi32(absX, _mm_set1_epi32(0x7F800000));
+
+            __m128i result = _mm_or_si128(_mm_and_si128(isDenorm, denorm), _mm_andnot_si128(isDenorm, normal));
+            result = _mm_or_si128(_mm_and_si128(isOverflow, _mm_set1_epi32(0x7C00)), _mm_andnot_si128(isOverflow, result));
+            result = _mm_or_si128(result, _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+            return _mm_or_si128(result, sign);
+        }
+
+        // Input is one half per 32 bit lane.
+        inline __m128 HalfToFloat4(const __m128i half) {
+            const __m128i shiftedExp = _mm_set1_epi32(0x7C00 << 13);
+
+            __m128i o = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+            const __m128i exp = _mm_and_si128(o, shiftedExp);
+            o = _mm_add_epi32(o, _mm_set1_epi32((127 - 15) << 23));
+
+            const __m128i isInfNan = _mm_cmpeq_epi32(exp, shiftedExp);
+            const __m128i isDenorm = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+
+            o = _mm_add_epi32(o, _mm_and_si128(isInfNan, _mm_set1_epi32((128 - 16) << 23)));
+
+            const __m128i denormBits = _mm_add_epi32(o, _mm_set1_epi32(1 << 23));
+            const __m128 denorm = _mm_sub_ps(_mm_castsi128_ps(denormBits), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+            o = _mm_or_si128(_mm_and_si128(isDenorm, _mm_castps_si128(denorm)), _mm_andnot_si128(isDenorm, o));
+
+            const __m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+            return _mm_castsi128_ps(_mm_or_si128(o, sign));
+        }
+
+        // Narrows four 32 bit lanes holding 0..65535 to 16 bits without SSE4.1's packus.
+        inline __m128i PackUnsigned16(const __m128i lo, const __m128i hi) {
+            const __m128i bias = _mm_set1_epi32(0x8000);
+            const __m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias));
+            return _mm_xor_si128(packed, _mm_set1_epi16(static_cast<short>(0x8000)));
+        }
+    }
+#endif
+
+    // Bulk converters over flat component arrays. count is the number of components, not elements,
+    // so a Half4 array of n elements is converted with count = n * 4.
+
+    inline void EncodeHalf(const float* src, uint16_t* dst, const size_t count) {
+        size_t i = 0;
+#if defined(EMC_PACKED_F16C)
+        for (; i + 8 <= count; i += 8) {
+            const __m256 value = _mm256_loadu_ps(src + i);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+        }
+#elif defined(EMC_PACKED_SSE2)
+        for (; i + 8 <= count; i += 8) {
+            const __m128i lo = packed_detail::FloatToHalf4(_mm_loadu_ps(src + i));
+            const __m128i hi = packed_detail::FloatToHalf4(_mm_loadu_ps(src + i + 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed_detail::PackUnsigned16(lo, hi));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = FloatToHalf(src[i]); }
+    }
+
+    inline void DecodeHalf(const uint16_t* src, float* dst, const size_t count) {
+        size_t i = 0;
+#if defined(EMC_PACKED_F16C)
+        for (; i + 8 <= count; i += 8) {
+            const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+        }
+#elif defined(EMC_PACKED_SSE2)
+        for (; i + 8 <= count; i += 8) {
+            const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_ps(dst + i, packed_detail::HalfToFloat4(_mm_unpacklo_epi16(half, _mm_setzero_si128())));
+            _mm_storeu_ps(dst + i + 4, packed_detail::HalfToFloat4(_mm_unpackhi_epi16(half, _mm_setzero_si128())));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = HalfToFloat(src[i]); }
+    }
+
+    inline void EncodeSnorm16(const float* src, int16_t* dst, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(32767.0f);
+        for (; i + 8 <= count; i += 8) {
+            const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi), scale);
+            const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = FloatToSnorm16(src[i]); }
+    }
+
+    inline void DecodeSnorm16(const int16_t* src, float* dst, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 32767.0f), lo = _mm_set1_ps(-1.0f);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            // Interleaving with itself then shifting right arithmetic sign extends to 32 bits.
+            const __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+            const __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+            _mm_storeu_ps(dst + i, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(a), scale), lo));
+            _mm_storeu_ps(dst + i + 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(b), scale), lo));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = Snorm16ToFloat(src[i]); }
+    }
+
+    inline void EncodeUnorm16(const float* src, uint16_t* dst, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 lo = _mm_setzero_ps(), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(65535.0f);
+        for (; i + 8 <= count; i += 8) {
+            const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi), scale);
+            const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi), scale);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed_detail::PackUnsigned16(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = FloatToUnorm16(src[i]); }
+    }
+
+    inline void DecodeUnorm16(const uint16_t* src, float* dst, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+        for (; i + 8 <= count; i += 8) {
+            const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128i a = _mm_unpacklo_epi16(value, _mm_setzero_si128());
+            const __m128i b = _mm_unpackhi_epi16(value, _mm_setzero_si128());
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(b), scale));
+        }
+#endif
+        for (; i < count; ++i) { dst[i] = Unorm16ToFloat(src[i]); }
+    }
+
+    // Packs tightly strided xyz triples (e.g. Vector3 or glm::vec3 arrays) with w = 0.
+    inline void EncodeNormals1010102(const float* xyz, Snorm1010102* dst, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(511.0f);
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        for (; i + 4 <= count; i += 4) {
+            // Transpose four xyz triples into x, y and z vectors.
+            const __m128 a = _mm_loadu_ps(xyz + i * 3);
+            const __m128 b = _mm_loadu_ps(xyz + i * 3 + 4);
+            const __m128 c = _mm_loadu_ps(xyz + i * 3 + 8);
+
+            const __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            const __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+            const __m128i ix = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, lo), hi), scale));
+            const __m128i iy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, lo), hi), scale));
+            const __m128i iz = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(z, lo), hi), scale));
+
+            __m128i bits = _mm_and_si128(ix, mask);
+            bits = _mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(iy, mask), 10));
+            bits = _mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(iz, mask), 20));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bits);
+        }
+#endif
+        for (; i < count; ++i) { dst[i].bits = Snorm1010102::Encode(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2], 0.0f); }
+    }
+
+    inline void DecodeNormals1010102(const Snorm1010102* src, float* xyz, const size_t count) {
+        size_t i = 0;
+#ifdef EMC_PACKED_SSE2
+        const __m128 scale = _mm_set1_ps(1.0f / 511.0f), lo = _mm_set1_ps(-1.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i bits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            const __m128 x = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(bits, 22), 22)), scale), lo);
+            const __m128 y = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(bits, 12), 22)), scale), lo);
+            const __m128 z = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(bits, 2), 22)), scale), lo);
+
+            // Inverse of the transpose in EncodeNormals1010102.
+            const __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 0, 1, 0));   // x0 x1 y0 y1
+            const __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(2, 1, 1, 0));   // z0 z1 x1 x2
+            const __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(2, 1, 2, 1));   // y1 y2 z1 z2
+            const __m128 xy2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2));  // x2 x2 y2 y2
+            const __m128 zx3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));  // z2 z2 x3 x3
+            const __m128 yz3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));  // y3 y3 z3 z3
+            _mm_storeu_ps(xyz + i * 3, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));      // x0 y0 z0 x1
+            _mm_storeu_ps(xyz + i * 3 + 4, _mm_shuffle_ps(yz, xy2, _MM_SHUFFLE(2, 0, 2, 0))); // y1 z1 x2 y2
+            _mm_storeu_ps(xyz + i * 3 + 8, _mm_shuffle_ps(zx3, yz3, _MM_SHUFFLE(2, 0, 2, 0))); // z2 x3 y3 z3
+        }
+#endif
+        for (; i < count; ++i) {
+            const Vector3 vec = src[i].ToVector3();
+            xyz[i * 3] = vec.x;
+            xyz[i * 3 + 1] = vec.y;
+            xyz[i * 3 + 2] = vec.z;
+        }
+    }
+
+    inline void EncodeHalf2(const Vector2* src, Half2* dst, const size_t count) {
+        EncodeHalf(reinterpret_cast<const float*>(src), reinterpret_cast<uint16_t*>(dst), count * 2);
+    }
+
+    inline void EncodeHalf4(const Vector4* src, Half4* dst, const size_t count) {
+        EncodeHalf(reinterpret_cast<const float*>(src), reinterpret_cast<uint16_t*>(dst), count * 4);
+    }
+
+    inline void EncodeSnorm16x4(const Vector4* src, Snorm16x4* dst, const size_t count) {
+        EncodeSnorm16(reinterpret_cast<const float*>(src), reinterpret_cast<int16_t*>(dst), count * 4);
+    }
+
+    inline void EncodeUnorm16x2(const Vector2* src, Unorm16x2* dst, const size_t count) {
+        EncodeUnorm16(reinterpret_cast<const float*>(src), reinterpret_cast<uint16_t*>(dst), count * 2);
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef PLANE_H
+#define PLANE_H
+
+#pragma once
+
+#include <cmath>
+#include <string>
+#include "Vector3.h"
+
+namespace emc {
+    // Plane as normal . p + d = 0. Points on the side the normal faces have positive distance.
+    struct Plane {
+        Vector3 normal;
+        float d;
+
+        Plane() : normal(0.0f, 1.0f, 0.0f), d(0.0f) {}
+        Plane(const Vector3& normal, const float d) : normal(normal), d(d) {}
+        Plane(const float a, const float b, const float c, const float d) : normal(a, b, c), d(d) {}
+
+        static Plane FromPointNormal(const Vector3& point, const Vector3& normal) {
+            const Vector3 n = normal.Normalised();
+            return { n, -n.Dot(point) };
+        }
+
+        static Plane FromPoints(const Vector3& a, const Vector3& b, const Vector3& c) {
+            return FromPointNormal(a, (b - a).Cross(c - a));
+        }
+
+        [[nodiscard]] std::string ToString() const {
+            return normal.ToString() + std::to_string(d);
+        }
+
+        // Scales so the normal is unit length, which makes DistanceToPoint a true distance.
+        void Normalise() {
+            const float mag = normal.Magnitude();
+            if (mag == 0.0f) { return; }
+            normal = normal / mag;
+            d /= mag;
+        }
+
+        [[nodiscard]] Plane Normalised() const {
+            Plane plane = *this;
+            plane.Normalise();
+            return plane;
+        }
+
+        [[nodiscard]] float DistanceToPoint(const Vector3& point) const { return normal.Dot(point) + d; }
+
+        bool operator==(const Plane& other) const {
+            return normal == other.normal && std::abs(d - other.d) < TOLERANCE;
+        }
+    };
+}
+
+#endif
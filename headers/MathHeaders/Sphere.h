@@ -0,0 +1,38 @@
+#ifndef SPHERE_H
+#define SPHERE_H
+
+#pragma once
+
+#include <string>
+#include "Vector3.h"
+
+namespace emc {
+    struct Sphere {
+        Vector3 center;
+        float radius;
+
+        Sphere() : radius(0.0f) {}
+        Sphere(const Vector3& center, const float radius) : center(center), radius(radius) {}
+
+        [[nodiscard]] std::string ToString() const {
+            return center.ToString() + std::to_string(radius);
+        }
+
+        [[nodiscard]] bool Contains(const Vector3& point) const {
+            const Vector3 delta = point - center;
+            return delta.Dot(delta) <= radius * radius;
+        }
+
+        [[nodiscard]] bool Intersects(const Sphere& other) const {
+            const Vector3 delta = other.center - center;
+            const float reach = radius + other.radius;
+            return delta.Dot(delta) <= reach * reach;
+        }
+
+        bool operator==(const Sphere& other) const {
+            return center == other.center && std::abs(radius - other.radius) < TOLERANCE;
+        }
+    };
+}
+
+#endif
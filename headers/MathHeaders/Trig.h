@@ -0,0 +1,214 @@
+#ifndef TRIG_H
+#define TRIG_H
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EMC_TRIG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace emc {
+    // Accuracy tiers for the sin/cos helpers below.
+    // Errors are absolute and were measured against double precision over |theta| <= 8192.
+    enum class TrigPrecision {
+        Fast,       // Degree 5/4 polynomials. Max error 1.3e-5.
+        Standard,   // Degree 7/8 polynomials (cephes sinf/cosf). Max error 8e-8.
+        Exact       // std::sin / std::cos. Max error 3.3e-8 (float rounding), scalar only.
+    };
+
+    namespace trig_detail {
+        // pi/4 split into three parts so that j * pi/4 can be subtracted without losing bits (Cody-Waite).
+        constexpr float DP1 = 0.78515625f;
+        constexpr float DP2 = 2.4187564849853515625e-4f;
+        constexpr float DP3 = 3.77489497744594108e-8f;
+        constexpr float FOUR_OVER_PI = 1.27323954473516f;
+
+        // Past this the reduction above stops being accurate, so we hand off to std.
+        constexpr float REDUCTION_LIMIT = 8192.0f;
+
+        template <TrigPrecision P>
+        float SinPoly(const float x, const float z) {
+            if constexpr (P == TrigPrecision::Fast) {
+                return ((8.15299230e-3f * z - 1.66628338e-1f) * z) * x + x;
+            } else {
+                return (((-1.9515295891e-4f * z + 8.3321608736e-3f) * z - 1.6666654611e-1f) * z) * x + x;
+            }
+        }
+
+        template <TrigPrecision P>
+        float CosPoly(const float z) {
+            if constexpr (P == TrigPrecision::Fast) {
+                return (4.04889359e-2f * z - 4.99776307e-1f) * z + 1.0f;
+            } else {
+                return ((2.443315711809948e-5f * z - 1.388731625493765e-3f) * z + 4.166664568298827e-2f) * z * z - 0.5f * z + 1.0f;
+            }
+        }
+
+        template <TrigPrecision P>
+        void SinCosReduced(const float theta, float& outSin, float& outCos) {
+            float x = std::fabs(theta);
+
+            // Octant index, rounded up to even so the remainder lands in [-pi/4, pi/4].
+            unsigned int j = static_cast<unsigned int>(x * FOUR_OVER_PI);
+            j = (j + 1) & ~1u;
+            const float y = static_cast<float>(j);
+            x = ((x - y * DP1) - y * DP2) - y * DP3;
+
+            const float z = x * x;
+            const float s = SinPoly<P>(x, z);
+            const float c = CosPoly<P>(z);
+
+            // Bit 1 of the octant swaps the polynomials, bit 2 flips the sign.
+            const bool swap = (j & 2) != 0;
+            float sinResult = swap ? c : s;
+            float cosResult = swap ? s : c;
+
+            if (((j & 4) != 0) != (theta < 0.0f)) { sinResult = -sinResult; }
+            if (((j + 2) & 4) != 0) { cosResult = -cosResult; }
+
+            outSin = sinResult;
+            outCos = cosResult;
+        }
+    }
+
+    // Computes sin and cos of the same angle with a single range reduction.
+    template <TrigPrecision P = TrigPrecision::Standard>
+    void SinCos(const float theta, float& outSin, float& outCos) {
+        if constexpr (P == TrigPrecision::Exact) {
+            outSin = std::sin(theta);
+            outCos = std::cos(theta);
+        } else {
+            if (!(std::fabs(theta) <= trig_detail::REDUCTION_LIMIT)) {
+                outSin = std::sin(theta);
+                outCos = std::cos(theta);
+                return;
+            }
+            trig_detail::SinCosReduced<P>(theta, outSin, outCos);
+        }
+    }
+
+    template <TrigPrecision P = TrigPrecision::Standard>
+    float Sin(const float theta) {
+        float s, c;
+        SinCos<P>(theta, s, c);
+        return s;
+    }
+
+    template <TrigPrecision P = TrigPrecision::Standard>
+    float Cos(const float theta) {
+        float s, c;
+        SinCos<P>(theta, s, c);
+        return c;
+    }
+
+#ifdef EMC_TRIG_SSE2
+    namespace trig_detail {
+        // Four-wide version of SinCosReduced, lanes are independent.
+        template <TrigPrecision P>
+        void SinCos4(const __m128 theta, __m128& outSin, __m128& outCos) {
+            const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+
+            __m128 x = _mm_andnot_ps(signMask, theta);
+            const __m128 inputSign = _mm_and_ps(theta, signMask);
+
+            __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+            j = _mm_add_epi32(j, _mm_set1_epi32(1));
+            j = _mm_and_si128(j, _mm_set1_epi32(~1));
+            const __m128 y = _mm_cvtepi32_ps(j);
+
+            x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+            x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+            x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+
+            const __m128 z = _mm_mul_ps(x, x);
+
+            __m128 s;
+            __m128 c;
+            if constexpr (P == TrigPrecision::Fast) {
+                s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(8.15299230e-3f), z), _mm_set1_ps(-1.66628338e-1f));
+                s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+                c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(4.04889359e-2f), z), _mm_set1_ps(-4.99776307e-1f));
+                c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(1.0f));
+            } else {
+                s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+                s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+                s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+                c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+                c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+                c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+                c = _mm_sub_ps(c, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+                c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+            }
+
+            const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+            const __m128 sinResult = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+            const __m128 cosResult = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+            // Move bit 2 of the octant into the float sign bit.
+            const __m128 sinFlip = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+            const __m128 cosFlip = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+
+            outSin = _mm_xor_ps(sinResult, _mm_xor_ps(sinFlip, inputSign));
+            outCos = _mm_xor_ps(cosResult, cosFlip);
+        }
+    }
+#endif
+
+    // Batch sin/cos over an array of angles. outSin or outCos may be null if only one is needed.
+    // Uses SSE2 four lanes at a time when available, the tail and out of range lanes go through the scalar path.
+    template <TrigPrecision P = TrigPrecision::Standard>
+    void SinCosBatch(const float* angles, float* outSin, float* outCos, const size_t count) {
+        size_t i = 0;
+
+#ifdef EMC_TRIG_SSE2
+        if constexpr (P != TrigPrecision::Exact) {
+            const __m128 limit = _mm_set1_ps(trig_detail::REDUCTION_LIMIT);
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+            for (; i + 4 <= count; i += 4) {
+                const __m128 theta = _mm_loadu_ps(angles + i);
+                __m128 s, c;
+                trig_detail::SinCos4<P>(theta, s, c);
+
+                if (outSin) { _mm_storeu_ps(outSin + i, s); }
+                if (outCos) { _mm_storeu_ps(outCos + i, c); }
+
+                // NaN compares false here too, so it also takes the fix up.
+                const int inRange = _mm_movemask_ps(_mm_cmple_ps(_mm_and_ps(theta, absMask), limit));
+                if (inRange != 0xF) {
+                    for (int lane = 0; lane < 4; ++lane) {
+                        if (inRange & (1 << lane)) { continue; }
+                        if (outSin) { outSin[i + lane] = std::sin(angles[i + lane]); }
+                        if (outCos) { outCos[i + lane] = std::cos(angles[i + lane]); }
+                    }
+                }
+            }
+        }
+#endif
+
+        for (; i < count; ++i) {
+            float s, c;
+            SinCos<P>(angles[i], s, c);
+            if (outSin) { outSin[i] = s; }
+            if (outCos) { outCos[i] = c; }
+        }
+    }
+
+    // Runtime selectable form of SinCosBatch, for callers that pick the tier from settings.
+    inline void SinCosBatch(const float* angles, float* outSin, float* outCos, const size_t count, const TrigPrecision precision) {
+        switch (precision) {
+            case TrigPrecision::Fast: SinCosBatch<TrigPrecision::Fast>(angles, outSin, outCos, count); break;
+            case TrigPrecision::Standard: SinCosBatch<TrigPrecision::Standard>(angles, outSin, outCos, count); break;
+            case TrigPrecision::Exact: SinCosBatch<TrigPrecision::Exact>(angles, outSin, outCos, count); break;
+        }
+    }
+}
+
+#endif
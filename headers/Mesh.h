@@ -1,5 +1,8 @@
 #ifndef MESH_H
 #define MESH_H
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include <vector>
 #include "GpuBuffer.h"
 
@@ -7,8 +10,25 @@ class Mesh {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
+    // How vertices are stored once on the GPU, the CPU side copy is always full Vertex structs.
+    VertexLayout layout = VertexLayout::standard();
 
     std::unique_ptr<GpuBuffer> gpuBuffer;
+
+    // Distance from the origin to the furthest vertex, worked out the first time it is asked for.
+    [[nodiscard]] float getBoundingRadius() const {
+        if (m_boundingRadius < 0.0f) {
+            float radiusSquared = 0.0f;
+            for (const Vertex& vertex : vertices) {
+                radiusSquared = std::max(radiusSquared, glm::dot(vertex.position, vertex.position));
+            }
+            m_boundingRadius = std::sqrt(radiusSquared);
+        }
+        return m_boundingRadius;
+    }
+
+private:
+    mutable float m_boundingRadius = -1.0f;
 };
 
 #endif //MESH_H
@@ -0,0 +1,32 @@
+#ifndef MESHIMPORTER_H
+#define MESHIMPORTER_H
+
+#include <filesystem>
+
+#include "FileData.h"
+#include "JobPool.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+// Imports Wavefront OBJ and binary glTF 2.0 (.glb) geometry into a Mesh.
+// Files are mapped in with FileData and parsed in place, numbers are read with std::from_chars straight out of the
+// mapping, so nothing is allocated per token. Large files are split into chunks parsed on pool, and every triangle
+// corner then goes through a hash map so identical vertices are stored once.
+// Only positions and the first texture coordinate are kept, which is all Vertex holds. V is flipped for glTF so both
+// formats match the bottom up textures TextureLoader makes.
+//
+// Each returns false and leaves mesh alone on failure, printing ERROR::MESH::... . On success mesh's vertices and
+// indices are replaced, so load before its bounds are first asked for. Pool may be null to parse on the caller only.
+
+// Picks the format from the extension, then reorders the result with optimizeMesh. Report, if given, gets its cache
+// stats from before and after.
+bool loadMesh(const std::filesystem::path& path, Mesh& mesh, JobPool* pool = nullptr, MeshOptimizationReport* report = nullptr);
+
+// Faces with more than three corners are fanned into triangles. Groups, objects, materials and normals are ignored.
+bool loadObjMesh(const FileData& file, Mesh& mesh, JobPool* pool = nullptr);
+
+// Every triangle primitive in the default scene, with node transforms applied, merged into one mesh. Buffers must be
+// in the file's BIN chunk, and sparse accessors aren't supported.
+bool loadGlbMesh(const FileData& file, Mesh& mesh, JobPool* pool = nullptr);
+
+#endif //MESHIMPORTER_H
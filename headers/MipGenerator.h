@@ -0,0 +1,122 @@
+#ifndef MIPGENERATOR_H
+#define MIPGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "FileData.h"
+#include "JobPool.h"
+
+// Flips an image in place. Used instead of stbi_set_flip_vertically_on_load, which is global state shared by every
+// thread decoding at the time.
+inline void flipImageVertically(unsigned char* pixels, const int width, const int height, const int bytesPerPixel) {
+    const size_t rowSize = static_cast<size_t>(width) * bytesPerPixel;
+    std::vector<unsigned char> row(rowSize);
+
+    for (int y = 0; y < height / 2; ++y) {
+        unsigned char* top = pixels + rowSize * y;
+        unsigned char* bottom = pixels + rowSize * (height - 1 - y);
+        std::memcpy(row.data(), top, rowSize);
+        std::memcpy(top, bottom, rowSize);
+        std::memcpy(bottom, row.data(), rowSize);
+    }
+}
+
+enum class MipFilter {
+    Box,    // Average of the footprint, what glGenerateMipmap does.
+    Kaiser, // Kaiser windowed sinc, keeps small mips sharper at a little more cost.
+};
+
+enum class MipPixelType : uint32_t { UnsignedByte, Float };
+
+// One level inside a MipChain's storage. Rows are tightly packed.
+struct MipLevel {
+    size_t offset;
+    size_t size;
+    int width;
+    int height;
+};
+
+// A mip chain down to 1x1 unless it was cut short, level 0 included, in one block of memory. Either owned, or mapped straight from a
+// MipCache file.
+class MipChain {
+public:
+    [[nodiscard]] bool isValid() const { return !m_levels.empty(); }
+    [[nodiscard]] int getWidth() const { return m_levels.empty() ? 0 : m_levels[0].width; }
+    [[nodiscard]] int getHeight() const { return m_levels.empty() ? 0 : m_levels[0].height; }
+    [[nodiscard]] int getChannels() const { return m_channels; }
+    [[nodiscard]] MipPixelType getType() const { return m_type; }
+    [[nodiscard]] size_t getLevelCount() const { return m_levels.size(); }
+    [[nodiscard]] const MipLevel& getLevel(const size_t level) const { return m_levels[level]; }
+    [[nodiscard]] const unsigned char* levelData(const size_t level) const { return _base() + m_levels[level].offset; }
+    [[nodiscard]] size_t getByteSize() const { return m_levels.empty() ? 0 : m_levels.back().offset + m_levels.back().size; }
+
+private:
+    friend class MipCache;
+    friend MipChain generateMipChain(const unsigned char*, int, int, int, bool, MipFilter, JobPool*, size_t);
+    friend MipChain generateMipChain(const float*, int, int, int, MipFilter, JobPool*, size_t);
+
+    int m_channels = 0;
+    MipPixelType m_type = MipPixelType::UnsignedByte;
+    std::vector<MipLevel> m_levels;
+    std::vector<unsigned char> m_storage;
+    FileData m_file;
+    size_t m_fileOffset = 0;
+
+    [[nodiscard]] const unsigned char* _base() const { return m_file ? m_file.bytes() + m_fileOffset : m_storage.data(); }
+    // Fills in the level table for a chain starting at width x height, returns the total size in bytes. maxLevels
+    // 0 goes all the way down to 1x1.
+    size_t _layout(int width, int height, int channels, MipPixelType type, size_t maxLevels = 0);
+};
+
+// Builds the chain on the CPU, filtering in linear light: 8 bit colour channels are treated as sRGB when srgb is set,
+// alpha never is. Rows of each level are split across pool when one is given, otherwise it all runs on the caller.
+// The inner loops use SSE2 on x86-64, and AVX2 as well when the build targets it.
+// maxLevels stops the chain early for callers that only keep the top few levels, 0 builds it down to 1x1.
+MipChain generateMipChain(const unsigned char* pixels, int width, int height, int channels, bool srgb, MipFilter filter = MipFilter::Box, JobPool* pool = nullptr, size_t maxLevels = 0);
+MipChain generateMipChain(const float* pixels, int width, int height, int channels, MipFilter filter = MipFilter::Box, JobPool* pool = nullptr, size_t maxLevels = 0);
+
+class MipCache;
+
+// Decodes an image file (anything stb_image reads) to channels 8 bit channels and builds its chain, or maps the chain
+// straight back in from cache when it was built before. Returns an invalid chain if the file can't be decoded.
+MipChain loadMipChain(const FileData& file, int channels, bool srgb, bool flip, MipFilter filter, MipCache* cache, JobPool* pool);
+
+// On disk cache of generated chains, so the next run skips decoding and filtering altogether.
+// Files are mapped back in when large enough, the levels then upload straight from the mapping.
+// Safe to use from several threads, entries are written to a temporary and renamed into place.
+class MipCache {
+public:
+    explicit MipCache(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+    // Key for a chain built from sourceHash (e.g. FileData::hash) with the given options. Changing the generator
+    // bumps VERSION, so old entries simply miss.
+    [[nodiscard]] static uint64_t makeKey(uint64_t sourceHash, int channels, bool srgb, bool flip, MipFilter filter);
+
+    // Returns false on a miss. Damaged entries are removed.
+    bool load(uint64_t key, MipChain& chain) const;
+    void store(uint64_t key, const MipChain& chain) const;
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t width;
+        uint32_t height;
+        uint32_t channels;
+        uint32_t type;
+    };
+
+    static constexpr uint32_t MAGIC = 0x50494D45; // "EMIP"
+    static constexpr uint32_t VERSION = 1;
+
+    std::filesystem::path m_directory;
+
+    [[nodiscard]] std::filesystem::path _pathFor(uint64_t key) const;
+};
+
+#endif //MIPGENERATOR_H
@@ -3,11 +3,16 @@
 #include <glm/glm.hpp>
 
 #include "Mesh.h"
+#include "SamplerCache.h"
 #include "Texture.h"
+#include "TextureAtlas.h"
 #include "Shader.h"
+#include "MathHeaders/Trig.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 constexpr int MAX_TEXTURE_UNITS = 16;
+// Atlases get a unit of their own, so an array sampler never shares one with a 2D sampler in the same program.
+constexpr int ATLAS_TEXTURE_UNIT = MAX_TEXTURE_UNITS - 1;
 
 class Object3D {
 public:
@@ -16,17 +21,39 @@ public:
     glm::vec3 scale = {1, 1, 1};
 
     std::shared_ptr<Mesh> mesh = {};
-    std::vector<Texture*> textures;
+    std::vector<std::shared_ptr<Texture>> textures;
+    // How textures are filtered and wrapped, before the renderer's SamplerOverride for the pass.
+    SamplerState sampler = {};
     Shader* shader = {};
 
+    // Set instead of textures to draw with an image out of an atlas, the shader needs the ATLAS feature.
+    const TextureAtlas* atlas = {};
+    AtlasRegion atlasRegion = {};
+
     explicit Object3D(Mesh* mesh) : mesh(mesh) {}
 
+    // Points the object at a packed image. Returns false and leaves it unchanged if the atlas doesn't have it.
+    bool useAtlasImage(const TextureAtlas& source, const std::string& name) {
+        const AtlasRegion* region = source.find(name);
+        if (!region) { return false; }
+
+        atlas = &source;
+        atlasRegion = *region;
+        return true;
+    }
+
     [[nodiscard]] glm::mat4 getModelMatrix() const {
-        glm::mat4 mat = translate(glm::mat4(1.0), {position.x, position.y, position.z});
-        mat = rotate(mat, glm::radians(rotation.x), glm::vec3(1, 0, 0));
-        mat = rotate(mat, glm::radians(rotation.y), glm::vec3(0, 1, 0));
-        mat = rotate(mat, glm::radians(rotation.z), glm::vec3(0, 0, 1));
-        mat = glm::scale(mat, {scale.x, scale.y, scale.z});
+        // Same result as translate * rotate(x) * rotate(y) * rotate(z) * scale, built directly
+        // so that each angle only goes through one sincos.
+        const float angles[3] = { glm::radians(rotation.x), glm::radians(rotation.y), glm::radians(rotation.z) };
+        float s[3], c[3];
+        emc::SinCosBatch(angles, s, c, 3);
+
+        glm::mat4 mat(1.0f);
+        mat[0] = glm::vec4(c[1] * c[2], s[0] * s[1] * c[2] + c[0] * s[2], -c[0] * s[1] * c[2] + s[0] * s[2], 0.0f) * scale.x;
+        mat[1] = glm::vec4(-c[1] * s[2], -s[0] * s[1] * s[2] + c[0] * c[2], c[0] * s[1] * s[2] + s[0] * c[2], 0.0f) * scale.y;
+        mat[2] = glm::vec4(s[1], -s[0] * c[1], c[0] * c[1], 0.0f) * scale.z;
+        mat[3] = glm::vec4(position, 1.0f);
         return mat;
     }
 };
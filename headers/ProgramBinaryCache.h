@@ -0,0 +1,198 @@
+#ifndef PROGRAMBINARYCACHE_H
+#define PROGRAMBINARYCACHE_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Entries are keyed by a hash of the shader sources, defines and the driver identification strings,
+// so a driver update or any source edit simply misses and the caller compiles as normal.
+class ProgramBinaryCache {
+public:
+    explicit ProgramBinaryCache(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+    // Needs a current GL context. Program binaries are core in 4.1, glad leaves the entry points null below that.
+    [[nodiscard]] bool isSupported() {
+        if (m_supported < 0) {
+            GLint formats = 0;
+            if (glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri) {
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            }
+            m_supported = formats > 0 ? 1 : 0;
+        }
+        return m_supported == 1;
+    }
+
+    [[nodiscard]] uint64_t makeKey(const std::string_view vertexSource, const std::string_view fragmentSource, const std::string_view defines) {
+        uint64_t hash = FNV_OFFSET;
+        hash = _hash(hash, _driverString());
+        hash = _hash(hash, vertexSource);
+        hash = _hash(hash, fragmentSource);
+        hash = _hash(hash, defines);
+        return hash;
+    }
+
+    // Same key as above for sources split into segments, without joining them first.
+    [[nodiscard]] uint64_t makeKey(const std::span<const std::string_view> vertexSegments, const std::span<const std::string_view> fragmentSegments, const std::string_view defines) {
+        uint64_t hash = FNV_OFFSET;
+        hash = _hash(hash, _driverString());
+        for (const std::string_view segment : vertexSegments) { hash = _hashBytes(hash, segment); }
+        hash = _separate(hash);
+        for (const std::string_view segment : fragmentSegments) { hash = _hashBytes(hash, segment); }
+        hash = _separate(hash);
+        hash = _hash(hash, defines);
+        return hash;
+    }
+
+    // Call on a program before glLinkProgram so the driver keeps a retrievable binary around.
+    void prepareForLink(const unsigned int program) {
+        if (isSupported()) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+    // Tries to restore a cached binary into program. Returns false on a miss or when the driver rejects the binary,
+    // in which case the stale entry is removed and the caller should compile from source.
+    bool load(const uint64_t key, const unsigned int program) {
+        if (!isSupported()) { return false; }
+
+        const std::filesystem::path path = _pathFor(key);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { return false; }
+
+        Header header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != MAGIC || header.version != VERSION || header.key != key) {
+            file.close();
+            _remove(path);
+            return false;
+        }
+
+        std::vector<char> binary(header.length);
+        file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!file) {
+            file.close();
+            _remove(path);
+            return false;
+        }
+
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            file.close();
+            _remove(path);
+            return false;
+        }
+        return true;
+    }
+
+    // Saves the binary of a successfully linked program.
+    void store(const uint64_t key, const unsigned int program) {
+        if (!isSupported()) { return; }
+
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) { return; }
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(m_directory, error);
+
+        // Write to a temporary and rename, so a crash mid write never leaves a truncated entry behind.
+        const std::filesystem::path path = _pathFor(key);
+        std::filesystem::path temp = path;
+        temp += ".tmp";
+
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        const Header header = { MAGIC, VERSION, key, format, static_cast<uint32_t>(length) };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        file.close();
+
+        if (!file) {
+            std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << temp.string() << std::endl;
+            _remove(temp);
+            return;
+        }
+
+        std::filesystem::rename(temp, path, error);
+        if (error) {
+            _remove(temp);
+        }
+    }
+
+private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    static constexpr uint32_t MAGIC = 0x43425045; // "EPBC"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    std::filesystem::path m_directory;
+    std::string m_driver;
+    int m_supported = -1;
+
+    static uint64_t _hash(const uint64_t hash, const std::string_view data) {
+        return _separate(_hashBytes(hash, data));
+    }
+
+    static uint64_t _hashBytes(uint64_t hash, const std::string_view data) {
+        for (const char c : data) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    // Separator, so ("ab", "c") and ("a", "bc") hash differently.
+    static uint64_t _separate(uint64_t hash) {
+        hash ^= 0xFF;
+        hash *= FNV_PRIME;
+        return hash;
+    }
+
+    const std::string& _driverString() {
+        if (m_driver.empty()) {
+            for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+                const auto* value = reinterpret_cast<const char*>(glGetString(name));
+                m_driver += value ? value : "";
+                m_driver += '\n';
+            }
+        }
+        return m_driver;
+    }
+
+    [[nodiscard]] std::filesystem::path _pathFor(const uint64_t key) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return m_directory / name;
+    }
+
+    static void _remove(const std::filesystem::path& path) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+};
+
+#endif //PROGRAMBINARYCACHE_H
@@ -1,12 +1,17 @@
 #ifndef RENDERAPI_H
 
 #define RENDERAPI_H
+#include <array>
 #include <memory>
 
+#include "BindlessTextures.h"
 #include "Object3d.h"
+#include "SamplerCache.h"
+#include "ShaderUniforms.h"
 #include "Window.h"
 #include "GLFW/glfw3.h"
 #include "MathHeaders/Colour.h"
+#include "MathHeaders/ColourSpace.h"
 
 class RenderAPI {
 public:
@@ -14,9 +19,12 @@ public:
     virtual ~RenderAPI() = default;
 
     virtual void init() = 0;
+    // Frees the GPU objects the API owns. Call once after the last frame, while the context is still current, and
+    // after every GpuBuffer it made is gone.
+    virtual void shutdown() = 0;
     virtual void registerObject(const Object3D* object) = 0;
 
-    virtual std::unique_ptr<GpuBuffer> CreateGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) = 0;
+    virtual std::unique_ptr<GpuBuffer> CreateGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const VertexLayout& layout) = 0;
 
     virtual void startDrawing() = 0;
     virtual void endDrawing(Window* window) = 0;
@@ -24,6 +32,17 @@ public:
     virtual void drawObject(const Object3D &object) = 0;
     virtual void drawRegisteredObjects() = 0;
 
+    // Objects whose shader has the BINDLESS feature then sample their textures through bindless handles rather than
+    // texture units. Returns whether it is on, which it can't be without driver support.
+    virtual bool setBindlessTextures(bool enabled) = 0;
+
+    // Applies to every object drawn until it is changed, so set it at the start of each pass.
+    virtual void setSamplerOverride(const SamplerOverride& samplerOverride) = 0;
+
+    // For depth only passes: objects draw through VAOs reading nothing but positions, so meshes whose layout keeps
+    // positions in a stream of their own only fetch that stream. Also holds until changed.
+    virtual void setPositionsOnly(bool positionsOnly) = 0;
+
     virtual void setClearColour(emc::Colour colour) = 0;
     virtual void setClearColour(float r, float g, float b, float a) = 0;
 
@@ -46,8 +65,31 @@ public:
         glEnable(GL_DEPTH_TEST);
     }
 
-    void startDrawing() override { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); }
+    void shutdown() override {
+        if (m_bindless) {
+            m_bindless->destroy();
+            m_bindless.reset();
+        }
+        m_geometry.destroy();
+        m_vertexArrays.destroy();
+        m_samplers.destroy();
+    }
+
+    void startDrawing() override {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Anything may have bound textures between frames, so the atlas is bound again on its first use.
+        m_boundAtlas = 0;
+        m_boundSamplers.fill(UNKNOWN_SAMPLER);
+        m_boundVertexArray = 0;
+        if (m_bindless) {
+            m_bindless->beginFrame();
+        }
+        // Meshes streamed out leave holes, close a few each frame rather than stalling on all of them at once.
+        m_geometry.defragment(DEFRAGMENT_BYTES_PER_FRAME);
+    }
     void endDrawing(Window* window) override {
+        glBindVertexArray(0);
+
         float currentFrameTime = static_cast<float>(glfwGetTime());
         m_DeltaTime = currentFrameTime - m_LastFrame;
         m_LastFrame = currentFrameTime;
@@ -55,8 +97,10 @@ public:
         window->swapBuffers();
     }
 
-    std::unique_ptr<GpuBuffer> CreateGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) override {
-        return std::make_unique<OpenGLGpuBuffer>(vertices, indices);
+    std::unique_ptr<GpuBuffer> CreateGpuBuffer(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const VertexLayout& layout) override {
+        // Growing the heap deletes the VAOs over its old buffers, and their names can be handed out again.
+        m_boundVertexArray = 0;
+        return std::make_unique<OpenGLGpuBuffer>(vertices, indices, layout, m_geometry);
     }
 
     void registerObject(const Object3D* object) override { m_RegisteredObjects.push_back(object); }
@@ -73,30 +117,101 @@ public:
 
         object.shader->use();
 
-        if (!object.textures.empty()) {
-            for (int i = 0; i < object.textures.size(); ++i) {
-                if (i < MAX_TEXTURE_UNITS) {
-                    object.textures[i]->bind(GL_TEXTURE0 + i);
-                    object.shader->setInt("texture" + std::to_string(i + 1), i);
+        if (object.atlas) {
+            // Objects sharing an atlas share the binding, only the region changes from draw to draw.
+            if (m_boundAtlas != object.atlas->ID) {
+                object.atlas->bind(GL_TEXTURE0 + ATLAS_TEXTURE_UNIT);
+                m_boundAtlas = object.atlas->ID;
+            }
+            const AtlasRegion& region = object.atlasRegion;
+            object.shader->setUniforms(uniforms::Atlas{
+                ATLAS_TEXTURE_UNIT, glm::vec4(region.u, region.v, region.width, region.height), static_cast<float>(region.layer)
+            });
+        } else if (!object.textures.empty()) {
+            // With a bindless slot the draw binds nothing, otherwise (textures still loading or streamed, or a
+            // shader without BINDLESS) it falls back to units.
+            const GLuint sampler = m_samplers.get(m_samplerOverride.applyTo(object.sampler));
+            const bool bindless = m_bindless && object.shader->isReady() && object.shader->hasDefine("BINDLESS");
+            const int material = bindless ? m_bindless->materialFor(object.textures, sampler) : -1;
+            if (material < 0) {
+                for (int i = 0; i < object.textures.size(); ++i) {
+                    // The last unit stays the atlas's, see ATLAS_TEXTURE_UNIT.
+                    if (i < ATLAS_TEXTURE_UNIT) {
+                        object.textures[i]->bind(GL_TEXTURE0 + i);
+                        if (m_boundSamplers[i] != sampler) {
+                            glBindSampler(i, sampler);
+                            m_boundSamplers[i] = sampler;
+                        }
+                    }
                 }
             }
+            // Samplers read textures[0] and textures[1] from units 0 and 1 when not reading the slot.
+            object.shader->setUniforms(uniforms::Material{ 0, 1, material });
         }
 
-        object.shader->setMatrix4("model", object.getModelMatrix());
+        object.shader->setUniforms(uniforms::Object{ object.getModelMatrix() });
 
         const OpenGLGpuBuffer* buffer = dynamic_cast<const OpenGLGpuBuffer*>(object.mesh->gpuBuffer.get());
 
-        glBindVertexArray(buffer->VAO);
-        glDrawElements(GL_TRIANGLES, buffer->indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        // Meshes of one layout share the heap's buffers and so a VAO, which stays bound between their draws.
+        const GLuint vertexArray = buffer->getVertexArray(m_positionsOnly);
+        if (m_boundVertexArray != vertexArray) {
+            glBindVertexArray(vertexArray);
+            m_boundVertexArray = vertexArray;
+        }
+        for (const IndexRange& range : buffer->ranges) {
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), buffer->indexType,
+                                     reinterpret_cast<void*>(buffer->getFirstIndex(range) * buffer->getIndexSize()), buffer->getBaseVertex(range));
+        }
     }
 
-    void setClearColour(const emc::Colour colour) override { setClearColour(colour.GetRed(), colour.GetGreen(), colour.GetBlue(), 0); }
+    bool setBindlessTextures(const bool enabled) override {
+        if (!enabled) {
+            // Handles stay resident, they are freed along with their textures.
+            if (m_bindless) {
+                m_bindless->destroy();
+                m_bindless.reset();
+            }
+            return false;
+        }
+
+        if (!m_bindless) {
+            m_bindless = std::make_unique<BindlessTextures>(reinterpret_cast<GLADloadproc>(glfwGetProcAddress));
+            if (!m_bindless->isSupported()) {
+                m_bindless.reset();
+            }
+        }
+        return m_bindless != nullptr;
+    }
+
+    void setSamplerOverride(const SamplerOverride& samplerOverride) override { m_samplerOverride = samplerOverride; }
+    void setPositionsOnly(const bool positionsOnly) override { m_positionsOnly = positionsOnly; }
+
+    void setClearColour(const emc::Colour colour) override {
+        const emc::Vector4 normalised = emc::ColourToVector4(colour);
+        setClearColour(normalised.x, normalised.y, normalised.z, normalised.w);
+    }
     void setClearColour(const float r, const float g, const float b, const float a) override { glClearColor(r, g, b, a); }
 
     [[nodiscard]] float getFrameTime() override { return m_DeltaTime; }
 private:
     std::vector<const Object3D*> m_RegisteredObjects;
+    unsigned int m_boundAtlas = 0;
+    std::unique_ptr<BindlessTextures> m_bindless;
+
+    static constexpr GLuint UNKNOWN_SAMPLER = ~0u;
+    SamplerCache m_samplers;
+    SamplerOverride m_samplerOverride;
+    // What each texture unit has bound, so a draw with the same sampler as the last skips glBindSampler.
+    std::array<GLuint, MAX_TEXTURE_UNITS> m_boundSamplers{};
+
+    // Outlive every buffer made by CreateGpuBuffer, since meshes are freed before the API.
+    VertexArrayCache m_vertexArrays;
+    GeometryHeap m_geometry{ m_vertexArrays };
+    GLuint m_boundVertexArray = 0;
+    bool m_positionsOnly = false;
+
+    static constexpr size_t DEFRAGMENT_BYTES_PER_FRAME = 1024 * 1024;
 };
 class VulkanRenderAPI : public RenderAPI {};
 
@@ -0,0 +1,113 @@
+#ifndef SAMPLERCACHE_H
+#define SAMPLERCACHE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+
+#include "GLExtensions.h"
+
+// How a texture is filtered and wrapped, kept apart from the texture itself so the same image can be sampled
+// differently from pass to pass without touching its state.
+struct SamplerState {
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLenum magFilter = GL_LINEAR;
+    GLenum wrapS = GL_REPEAT;
+    GLenum wrapT = GL_REPEAT;
+    // 1 is off. Clamped to what the driver supports.
+    float maxAnisotropy = 1.0f;
+    float lodBias = 0.0f;
+
+    bool operator==(const SamplerState& other) const = default;
+};
+
+// Changes a pass makes on top of every object's own SamplerState, e.g. point sampling for a depth pre-pass, or
+// anisotropic filtering for the main pass. Anything left empty keeps the object's setting.
+struct SamplerOverride {
+    std::optional<GLenum> minFilter;
+    std::optional<GLenum> magFilter;
+    std::optional<float> maxAnisotropy;
+    std::optional<float> lodBias;
+
+    // Only raises anisotropic filtering, e.g. for a main pass.
+    static SamplerOverride anisotropic(const float maxAnisotropy) {
+        SamplerOverride samplerOverride;
+        samplerOverride.maxAnisotropy = maxAnisotropy;
+        return samplerOverride;
+    }
+
+    [[nodiscard]] SamplerState applyTo(SamplerState state) const {
+        state.minFilter = minFilter.value_or(state.minFilter);
+        state.magFilter = magFilter.value_or(state.magFilter);
+        state.maxAnisotropy = maxAnisotropy.value_or(state.maxAnisotropy);
+        state.lodBias = lodBias.value_or(state.lodBias);
+        return state;
+    }
+};
+
+// Hands out one GL sampler object per distinct SamplerState. Samplers are created once and never modified, so
+// binding one is the only work left on the draw path and texture objects keep their state.
+class SamplerCache {
+public:
+    // Needs a current context the first time.
+    GLuint get(const SamplerState& requested) {
+        if (m_maxAnisotropy == 0.0f) {
+            m_maxAnisotropy = 1.0f;
+            if (hasGlExtension("GL_ARB_texture_filter_anisotropic") || hasGlExtension("GL_EXT_texture_filter_anisotropic")) {
+                glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &m_maxAnisotropy);
+            }
+        }
+
+        // Clamp first, so asking for 16x on an 8x driver shares the 8x sampler.
+        SamplerState state = requested;
+        state.maxAnisotropy = std::clamp(state.maxAnisotropy, 1.0f, m_maxAnisotropy);
+
+        if (const auto it = m_samplers.find(state); it != m_samplers.end()) {
+            return it->second;
+        }
+
+        GLuint sampler;
+        glGenSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(state.minFilter));
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(state.magFilter));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, static_cast<GLint>(state.wrapS));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, static_cast<GLint>(state.wrapT));
+        glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, state.lodBias);
+        if (m_maxAnisotropy > 1.0f) {
+            glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, state.maxAnisotropy);
+        }
+
+        m_samplers.emplace(state, sampler);
+        return sampler;
+    }
+
+    [[nodiscard]] size_t size() const { return m_samplers.size(); }
+
+    void destroy() {
+        for (const auto& [state, sampler] : m_samplers) {
+            glDeleteSamplers(1, &sampler);
+        }
+        m_samplers.clear();
+    }
+
+private:
+    struct StateHash {
+        size_t operator()(const SamplerState& state) const {
+            size_t hash = std::hash<GLenum>()(state.minFilter);
+            for (const size_t value : { std::hash<GLenum>()(state.magFilter), std::hash<GLenum>()(state.wrapS), std::hash<GLenum>()(state.wrapT),
+                                        std::hash<float>()(state.maxAnisotropy), std::hash<float>()(state.lodBias) }) {
+                hash = hash * 31 + value;
+            }
+            return hash;
+        }
+    };
+
+    std::unordered_map<SamplerState, GLuint, StateHash> m_samplers;
+    // 0 until queried.
+    float m_maxAnisotropy = 0.0f;
+};
+
+#endif //SAMPLERCACHE_H
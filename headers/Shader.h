@@ -3,29 +3,97 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp> 
 
+#include "ProgramBinaryCache.h"
+#include "ShaderPreprocessor.h"
+#include "UniformBinding.h"
+
 class Shader {
 public:
-    // The Program ID
-    unsigned int ID;
+    enum class Status { Pending, Ready, Failed };
+
+    // The Program ID. While an asynchronous build is pending this is the build queue's fallback program.
+    unsigned int ID = 0;
 
-    // Constructor reads and builds the shader
-    Shader(const char* vertexPath, const char* fragmentPath);
+    // Constructor reads, preprocesses and builds the shader, restoring it from the binary cache when one is given and has an entry.
+    // Includes are only resolved relative to the including file here, ShaderBuildQueue has the configurable preprocessor.
+    Shader(const char* vertexPath, const char* fragmentPath, ProgramBinaryCache* binaryCache = nullptr);
     void use() const;
 
-    // Utility uniform functions
+    [[nodiscard]] Status getStatus() const { return m_status; }
+    [[nodiscard]] bool isReady() const { return m_status == Status::Ready; }
+
+    [[nodiscard]] const std::string& getVertexPath() const { return m_vertexPath; }
+    [[nodiscard]] const std::string& getFragmentPath() const { return m_fragmentPath; }
+    // Defines injected into both stages. Fixed for the lifetime of the shader.
+    [[nodiscard]] const std::vector<std::string>& getDefines() const { return m_defines; }
+    [[nodiscard]] bool hasDefine(const std::string_view name) const { return std::find(m_defines.begin(), m_defines.end(), name) != m_defines.end(); }
+    // Every file the current program was built from, includes too. Only touch on the GL thread, rebuilds update it.
+    [[nodiscard]] const std::vector<std::string>& getDependencies() const { return m_dependencies; }
+
+    // Utility uniform functions. Every setter compares against the program's shadow copy and skips the GL call when
+    // the value is unchanged. They upload to the bound program, so call use() first.
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
     void setVector3(const std::string& name, const glm::vec3& value) const;
     void setMatrix4(const std::string& name, const glm::mat4& value) const;
+
+    // Pushes a struct generated into ShaderUniforms.h, e.g. setUniforms(uniforms::Camera{ view, projection }).
+    // Locations are looked up the first time a struct type is used with the current program and reused after that.
+    template <typename T>
+    void setUniforms(const T& values) const {
+        applyUniforms(getUniformLocations(T::fields()), T::fields(), &values, _shadow());
+    }
+    const std::vector<int>& getUniformLocations(std::span<const UniformField> fields) const;
+
+    // Skipped and issued uploads for the current program. Counts are shared by every Shader drawing with it.
+    [[nodiscard]] const UniformStats& getUniformStats() const { return _shadow().getStats(); }
+
+    // Build steps shared with ShaderBuildQueue.
+    static std::string readSource(const char* path);
+    // Creates a shader object and issues the compile without waiting on it.
+    static unsigned int createStage(GLenum type, const std::string& code);
+    // Same, handing the preprocessed segments to the driver as they are.
+    static unsigned int createStage(GLenum type, const ShaderSource& source);
+    // These query status, which blocks until the driver is done unless it reported completion already.
+    static bool checkStage(unsigned int stage, const char* stageName);
+    static bool checkProgram(unsigned int program);
+
+private:
+    friend class ShaderBuildQueue;
+
+    Status m_status = Status::Ready;
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::vector<std::string> m_defines;
+    std::vector<std::string> m_dependencies;
+    // Bumped for every build queued, so a build finishing after a newer one was queued is dropped rather than swapped in.
+    uint64_t m_buildGeneration = 0;
+
+    // Keyed by the generated struct's field table. Cleared when ID changes, a rebuilt program has new locations.
+    mutable std::unordered_map<const UniformField*, std::vector<int>> m_uniformLocations;
+    mutable unsigned int m_uniformLocationsProgram = 0;
+    mutable UniformShadow* m_shadow = nullptr;
+    mutable unsigned int m_shadowProgram = 0;
+
+    Shader() = default;
+
+    UniformShadow& _shadow() const;
+    void _setDependencies(const ShaderSource& vertex, const ShaderSource& fragment);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,70 @@
+#ifndef SHADERBUILDQUEUE_H
+#define SHADERBUILDQUEUE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "ProgramBinaryCache.h"
+#include "Shader.h"
+#include "ShaderPreprocessor.h"
+
+// Builds shaders without stalling the frame.
+// submit() reads the sources and issues every compile and the link straight away, then hands back a Shader that
+// renders with a flat fallback program until poll() sees the driver has finished. With KHR_parallel_shader_compile
+// the driver compiles on its own threads and poll() never blocks; without it poll() falls back to finishing
+// everything outstanding in one go, which still lets drivers that thread internally overlap the submitted work.
+class ShaderBuildQueue {
+public:
+    explicit ShaderBuildQueue(GLADloadproc loader, ProgramBinaryCache* binaryCache = nullptr);
+
+    ShaderBuildQueue(const ShaderBuildQueue&) = delete;
+    ShaderBuildQueue& operator=(const ShaderBuildQueue&) = delete;
+
+    // Sources go through the queue's preprocessor, defines are injected into both stages.
+    // A shader whose sources fail to preprocess comes back Failed and keeps the fallback program.
+    std::shared_ptr<Shader> submit(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {});
+
+    // Rebuilds an existing shader from new preprocessed sources. It keeps its current program until the new one links,
+    // and keeps it for good if the new one fails.
+    void rebuild(const std::shared_ptr<Shader>& shader, const ShaderSource& vertexSource, const ShaderSource& fragmentSource);
+
+    // Call once per frame. Swaps finished programs into their shaders.
+    void poll();
+    // Blocks until everything submitted so far is finished.
+    void finishAll();
+
+    [[nodiscard]] size_t getPendingCount() const { return m_jobs.size(); }
+    [[nodiscard]] bool hasParallelCompile() const { return m_parallelCompile; }
+    [[nodiscard]] unsigned int getFallbackProgram() const { return m_fallbackProgram; }
+
+    // Add include directories before submitting anything, the watcher thread reads it without locking.
+    [[nodiscard]] ShaderPreprocessor& getPreprocessor() { return m_preprocessor; }
+
+private:
+    struct Job {
+        std::shared_ptr<Shader> shader;
+        unsigned int program;
+        unsigned int vertex;
+        unsigned int fragment;
+        uint64_t cacheKey;
+        uint64_t generation;
+    };
+
+    ProgramBinaryCache* m_binaryCache;
+    ShaderPreprocessor m_preprocessor;
+    std::vector<Job> m_jobs;
+    unsigned int m_fallbackProgram = 0;
+    bool m_parallelCompile = false;
+
+    void _enqueue(const std::shared_ptr<Shader>& shader, const ShaderSource& vertexSource, const ShaderSource& fragmentSource);
+    static std::string _joinDefines(const std::vector<std::string>& defines);
+    [[nodiscard]] bool _isComplete(const Job& job) const;
+    void _finish(Job& job) const;
+    // Frees a job's stages and program without touching its shader.
+    static void _discard(const Job& job);
+    void _buildFallback();
+};
+
+#endif //SHADERBUILDQUEUE_H
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "Shader.h"
+#include "ShaderUniforms.h"
 
 class ShaderManager {
     std::pmr::vector<Shader*> shaders;
@@ -13,10 +14,10 @@ public:
     }
 
     void injectGlobals(const glm::mat4& view, const glm::mat4& proj) const {
+        const uniforms::Camera camera = { view, proj };
         for (int i = 0; i < shaders.size(); ++i) {
             shaders[i]->use();
-            shaders[i]->setMatrix4("view", view);
-            shaders[i]->setMatrix4("projection", proj);
+            shaders[i]->setUniforms(camera);
         }
     }
 
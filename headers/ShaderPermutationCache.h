@@ -0,0 +1,167 @@
+#ifndef SHADERPERMUTATIONCACHE_H
+#define SHADERPERMUTATIONCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+#include "ShaderBuildQueue.h"
+#include "ShaderWatcher.h"
+
+// Builds shader variants on demand. A shader is declared once with the feature defines it supports, and a variant
+// is picked with a bitmask over those features (bit i enables features[i]). Each variant is compiled once through the
+// build queue, so it renders with the fallback program until ready, and every later get() is a map lookup.
+// prewarm() reads a manifest of the variants a level needs so they can start compiling during load.
+class ShaderPermutationCache {
+public:
+    static constexpr size_t MAX_FEATURES = 32;
+
+    explicit ShaderPermutationCache(ShaderBuildQueue& buildQueue, ShaderWatcher* watcher = nullptr) : m_buildQueue(buildQueue), m_watcher(watcher) {}
+
+    void declare(const std::string& name, std::string vertexPath, std::string fragmentPath, std::vector<std::string> features) {
+        if (features.size() > MAX_FEATURES) {
+            std::cout << "ERROR::SHADER_PERMUTATIONS::TOO_MANY_FEATURES " << name << std::endl;
+            features.resize(MAX_FEATURES);
+        }
+        m_families[name] = { std::move(vertexPath), std::move(fragmentPath), std::move(features), {} };
+    }
+
+    // Builds a mask from feature names. Unknown names are reported and ignored.
+    [[nodiscard]] uint32_t maskFor(const std::string& name, const std::initializer_list<std::string_view> features) const {
+        return maskFor(name, std::vector<std::string_view>(features));
+    }
+
+    [[nodiscard]] uint32_t maskFor(const std::string& name, const std::vector<std::string_view>& features) const {
+        const auto it = m_families.find(name);
+        if (it == m_families.end()) {
+            std::cout << "ERROR::SHADER_PERMUTATIONS::UNKNOWN_SHADER " << name << std::endl;
+            return 0;
+        }
+
+        uint32_t mask = 0;
+        for (const std::string_view feature : features) {
+            const std::vector<std::string>& known = it->second.features;
+            bool found = false;
+            for (size_t i = 0; i < known.size(); ++i) {
+                if (known[i] == feature) {
+                    mask |= 1u << i;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                std::cout << "ERROR::SHADER_PERMUTATIONS::UNKNOWN_FEATURE " << feature << " in " << name << std::endl;
+            }
+        }
+        return mask;
+    }
+
+    // Returns the variant, submitting it to the build queue the first time it is asked for. Null for unknown shaders.
+    std::shared_ptr<Shader> get(const std::string& name, const uint32_t mask) {
+        const auto it = m_families.find(name);
+        if (it == m_families.end()) {
+            std::cout << "ERROR::SHADER_PERMUTATIONS::UNKNOWN_SHADER " << name << std::endl;
+            return nullptr;
+        }
+
+        Family& family = it->second;
+        if (const auto variant = family.variants.find(mask); variant != family.variants.end()) {
+            return variant->second;
+        }
+
+        std::vector<std::string> defines;
+        for (size_t i = 0; i < family.features.size(); ++i) {
+            if (mask & (1u << i)) {
+                defines.push_back(family.features[i]);
+            }
+        }
+
+        std::shared_ptr<Shader> shader = m_buildQueue.submit(family.vertexPath.c_str(), family.fragmentPath.c_str(), defines);
+        if (m_watcher) {
+            m_watcher->watch(shader);
+        }
+        family.variants.emplace(mask, shader);
+        return shader;
+    }
+
+    // Reads a manifest and submits every variant in it. Blank lines and lines starting with # are skipped.
+    //   shader <name> <vertex path> <fragment path> [FEATURE...]   declares a shader, paths relative to the manifest
+    //   variant <name> [FEATURE...]                                 requests a variant of an already declared shader
+    // Returns the number of variants requested.
+    size_t prewarm(const std::filesystem::path& manifestPath) {
+        std::ifstream manifest(manifestPath);
+        if (!manifest) {
+            std::cout << "ERROR::SHADER_PERMUTATIONS::MANIFEST_NOT_READ " << manifestPath.string() << std::endl;
+            return 0;
+        }
+
+        const std::filesystem::path base = manifestPath.parent_path();
+        size_t requested = 0;
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::istringstream words(line);
+            std::string kind;
+            if (!(words >> kind) || kind[0] == '#') { continue; }
+
+            std::string name;
+            words >> name;
+
+            if (kind == "shader") {
+                std::string vertexPath, fragmentPath;
+                words >> vertexPath >> fragmentPath;
+
+                std::vector<std::string> features;
+                for (std::string feature; words >> feature;) {
+                    features.push_back(std::move(feature));
+                }
+                declare(name, (base / vertexPath).string(), (base / fragmentPath).string(), std::move(features));
+            } else if (kind == "variant") {
+                std::vector<std::string> features;
+                for (std::string feature; words >> feature;) {
+                    features.push_back(std::move(feature));
+                }
+                if (m_families.find(name) == m_families.end()) {
+                    std::cout << "ERROR::SHADER_PERMUTATIONS::UNKNOWN_SHADER " << name << std::endl;
+                    continue;
+                }
+
+                get(name, maskFor(name, std::vector<std::string_view>(features.begin(), features.end())));
+                ++requested;
+            } else {
+                std::cout << "ERROR::SHADER_PERMUTATIONS::BAD_MANIFEST_LINE " << line << std::endl;
+            }
+        }
+        return requested;
+    }
+
+    [[nodiscard]] size_t getVariantCount() const {
+        size_t count = 0;
+        for (const auto& [name, family] : m_families) {
+            count += family.variants.size();
+        }
+        return count;
+    }
+
+private:
+    struct Family {
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::vector<std::string> features;
+        std::unordered_map<uint32_t, std::shared_ptr<Shader>> variants;
+    };
+
+    ShaderBuildQueue& m_buildQueue;
+    ShaderWatcher* m_watcher;
+    std::unordered_map<std::string, Family> m_families;
+};
+
+#endif //SHADERPERMUTATIONCACHE_H
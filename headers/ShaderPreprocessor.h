@@ -0,0 +1,58 @@
+#ifndef SHADERPREPROCESSOR_H
+#define SHADERPREPROCESSOR_H
+
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FileData.h"
+
+// Result of preprocessing one shader stage. The source is never joined into one string: segments point straight
+// into the loaded files and the few generated lines, and go to glShaderSource as pointer and length arrays.
+// Move only, moving keeps every segment valid.
+struct ShaderSource {
+    ShaderSource() = default;
+    ShaderSource(ShaderSource&&) = default;
+    ShaderSource& operator=(ShaderSource&&) = default;
+    ShaderSource(const ShaderSource&) = delete;
+    ShaderSource& operator=(const ShaderSource&) = delete;
+
+    std::vector<std::string_view> segments;
+    // Every file that went into the source, root first. Used by the watcher to know what to reload.
+    std::vector<std::string> dependencies;
+    bool success = true;
+
+    // Storage the segments point into.
+    std::vector<FileData> files;
+    std::deque<std::string> generated;
+
+    // Joined copy of the segments, for logging and debugging.
+    [[nodiscard]] std::string code() const;
+};
+
+// Resolves #include "file" and injects #define lines right after #version, before the source reaches the driver.
+// Includes are looked up next to the including file first, then in the search directories, and each file is only
+// included once per stage. #line directives keep driver error messages pointing at the right file and line:
+// the source string number in the message is the index into ShaderSource::dependencies.
+// Stateless once configured, so it is safe to share with the watcher thread.
+class ShaderPreprocessor {
+public:
+    ShaderPreprocessor() = default;
+    explicit ShaderPreprocessor(std::vector<std::filesystem::path> includeDirectories) : m_includeDirectories(std::move(includeDirectories)) {}
+
+    void addIncludeDirectory(const std::filesystem::path& directory) { m_includeDirectories.push_back(directory); }
+
+    // defines are NAME or NAME=VALUE, each becomes #define NAME VALUE (VALUE defaults to 1).
+    [[nodiscard]] ShaderSource process(const std::string& path, const std::vector<std::string>& defines = {}) const;
+
+private:
+    std::vector<std::filesystem::path> m_includeDirectories;
+
+    bool _append(const std::filesystem::path& path, ShaderSource& result, const std::string& defineBlock) const;
+    static void _pushGenerated(ShaderSource& result, std::string text);
+    [[nodiscard]] std::filesystem::path _resolve(const std::string& name, const std::filesystem::path& includer) const;
+};
+
+#endif //SHADERPREPROCESSOR_H
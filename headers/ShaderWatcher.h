@@ -0,0 +1,62 @@
+#ifndef SHADERWATCHER_H
+#define SHADERWATCHER_H
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+#include "ShaderBuildQueue.h"
+
+// Watches shader source files, includes too, and rebuilds the shaders that use them when they change on disk.
+// A background thread waits on inotify and re-preprocesses the sources of affected shaders, applyPendingReloads() then
+// hands them to the build queue on the GL thread. The queue swaps the new program in at its next poll(), and a
+// shader whose new source fails to compile keeps drawing with its previous program.
+// Only implemented on Linux, elsewhere watch() does nothing.
+class ShaderWatcher {
+public:
+    explicit ShaderWatcher(ShaderBuildQueue& buildQueue);
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Starts watching every file the shader was built from. Call again after a rebuild to pick up new includes.
+    void watch(const std::shared_ptr<Shader>& shader);
+
+    // Call on the GL thread at a frame boundary, before the build queue's poll().
+    void applyPendingReloads();
+
+private:
+    struct Reload {
+        std::shared_ptr<Shader> shader;
+        ShaderSource vertexSource;
+        ShaderSource fragmentSource;
+    };
+
+    ShaderBuildQueue& m_buildQueue;
+
+    int m_inotifyFd = -1;
+    int m_wakeFd = -1;
+    std::thread m_thread;
+    std::atomic<bool> m_running = false;
+
+    // Guarded by m_mutex, the watcher thread reads them while watch() may add to them.
+    std::mutex m_mutex;
+    std::unordered_map<int, std::filesystem::path> m_directories;
+    std::unordered_map<std::string, std::vector<std::weak_ptr<Shader>>> m_shadersByFile;
+    std::vector<Reload> m_pending;
+
+    void _run();
+    void _reloadFiles(const std::vector<std::string>& changedFiles);
+    void _watchFile(const std::filesystem::path& file, const std::shared_ptr<Shader>& shader);
+    [[nodiscard]] bool _isWatching(const std::string& file, const std::shared_ptr<Shader>& shader);
+    static std::string _normalise(const std::filesystem::path& path);
+};
+
+#endif //SHADERWATCHER_H
@@ -1,39 +1,87 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <cstring>
 #include <iostream>
+#include <vector>
 #include <glad/glad.h>
 
+#include "FileData.h"
+#include "MipGenerator.h"
 #include "stb_image/stb_image.h"
 
+// Number of 8 bit channels to decode for a GL pixel format.
+inline int channelsForFormat(const GLenum format) {
+    switch (format) {
+        case GL_RED: return 1;
+        case GL_RG: return 2;
+        case GL_RGB: return 3;
+        default: return 4;
+    }
+}
+
+// Whether the colour channels of an internal format are stored as sRGB, so mips have to be filtered in linear space.
+inline bool isSrgbFormat(const GLint internalFormat) {
+    switch (internalFormat) {
+        case GL_SRGB: case GL_SRGB8: case GL_SRGB_ALPHA: case GL_SRGB8_ALPHA8: return true;
+        default: return false;
+    }
+}
+
+// Uploads every level of a CPU built chain into the bound texture.
+inline void uploadMipChain(const MipChain& chain, const GLint internalFormat, const GLenum format, const GLenum type) {
+    // Rows of 1 and 3 channel images aren't 4 byte aligned in general.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < chain.getLevelCount(); ++level) {
+        const MipLevel& info = chain.getLevel(level);
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat, info.width, info.height, 0, format, type, chain.levelData(level));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 class Texture {
 public:
+    enum class Status { Pending, Ready, Failed };
+
+    // While an asynchronous load is pending this is the TextureLoader's placeholder.
     unsigned int ID = {};
 
-    Texture(const char* path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip) {
+    Texture(const char* path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip) :
+        Texture(FileData::open(path), internalFormat, format, type, flip) {}
+
+    // Decodes straight from already loaded file bytes.
+    Texture(const FileData& file, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip) {
         glGenTextures(1, &ID);
         glBindTexture(GL_TEXTURE_2D, ID);
 
+        // Only used when no sampler object is bound, the renderer draws with samplers from its SamplerCache.
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        if (flip) {
-            stbi_set_flip_vertically_on_load(true);
-        }
-
+        const int channels = channelsForFormat(format);
         int width, height, nrChannels;
-        unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+        unsigned char *data = nullptr;
+        if (file) {
+            data = stbi_load_from_memory(file.bytes(), static_cast<int>(file.size()), &width, &height, &nrChannels, channels);
+        }
         if (data) {
-            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
-            glGenerateMipmap(GL_TEXTURE_2D);
+            if (flip) {
+                flipImageVertically(data, width, height, channels);
+            }
+            // Mips are built on the CPU rather than with glGenerateMipmap, which filters sRGB images in gamma space.
+            uploadMipChain(generateMipChain(data, width, height, channels, isSrgbFormat(internalFormat)), internalFormat, format, type);
         } else {
             std::cout << "Failed to load texture" << std::endl;
+            m_status = Status::Failed;
         }
         stbi_image_free(data);
     }
 
+    [[nodiscard]] Status getStatus() const { return m_status; }
+    [[nodiscard]] bool isReady() const { return m_status == Status::Ready; }
+
     void bind(const GLenum textureUnit = GL_TEXTURE0) const {
         glActiveTexture(textureUnit);
         glBindTexture(GL_TEXTURE_2D, ID);
@@ -46,6 +94,19 @@ public:
     void destroy() const {
         glDeleteTextures(1, &ID);
     }
+
+private:
+    friend class TextureLoader;
+    friend class TextureStreamer;
+    friend class BindlessTextures;
+
+    Status m_status = Status::Ready;
+    // Streamed textures keep changing their levels, which a bindless handle would forbid.
+    bool m_streamed = false;
+    // Bindless handles by sampler, 0 for the texture's own parameters.
+    mutable std::vector<std::pair<GLuint, GLuint64>> m_bindlessHandles;
+
+    Texture() = default;
 };
 
 #endif //TEXTURE_H
@@ -0,0 +1,63 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "AtlasBuilder.h"
+
+// A PackedAtlas uploaded as one GL_TEXTURE_2D_ARRAY, one layer per page.
+// Objects sampling from the same atlas share a single binding, an image is picked in the shader from its layer and
+// UV rectangle (see shaders/include/atlas.glsl) rather than by binding its own texture.
+class TextureAtlas {
+public:
+    unsigned int ID = {};
+
+    explicit TextureAtlas(const PackedAtlas& atlas) : m_regions(atlas.getRegions()), m_layerCount(atlas.getLayerCount()) {
+        glGenTextures(1, &ID);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, atlas.getLevelCount() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(atlas.getLevelCount()) - 1);
+
+        const GLint internalFormat = atlas.isSrgb() ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        const auto layers = static_cast<GLsizei>(std::max<size_t>(1, atlas.getLayerCount()));
+        for (size_t level = 0; level < atlas.getLevelCount(); ++level) {
+            const int size = atlas.levelSize(level);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), internalFormat, size, size, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            for (size_t layer = 0; layer < atlas.getLayerCount(); ++layer) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, static_cast<GLint>(layer), size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, atlas.levelData(layer, level));
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    // Null if no image of that name was packed.
+    [[nodiscard]] const AtlasRegion* find(const std::string& name) const {
+        const auto it = m_regions.find(name);
+        return it == m_regions.end() ? nullptr : &it->second;
+    }
+
+    [[nodiscard]] size_t getLayerCount() const { return m_layerCount; }
+
+    void bind(const GLenum textureUnit = GL_TEXTURE0) const {
+        glActiveTexture(textureUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    }
+
+    void destroy() const {
+        glDeleteTextures(1, &ID);
+    }
+
+private:
+    std::unordered_map<std::string, AtlasRegion> m_regions;
+    size_t m_layerCount;
+};
+
+#endif //TEXTUREATLAS_H
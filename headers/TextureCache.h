@@ -0,0 +1,152 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileData.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+
+// Hands out shared textures so every object using the same image shares one copy in VRAM.
+// Lookups go by canonical path plus load parameters first. On a miss the file's bytes are hashed, so the same image
+// under another name or path is still shared. Handles are reference counted, once the last one is dropped collect()
+// frees the GL texture on the next frame.
+class TextureCache {
+public:
+    struct Stats {
+        uint64_t pathHits = 0;
+        uint64_t contentHits = 0;
+        uint64_t misses = 0;
+    };
+
+    explicit TextureCache(TextureLoader& loader) : TextureCache([&loader](const std::string& path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip, FileData file) {
+        return loader.load(path, internalFormat, format, type, flip, std::move(file));
+    }, true) {}
+
+    // Textures stay the streamer's to free, it lets go of them once the cache no longer holds them.
+    explicit TextureCache(TextureStreamer& streamer) : TextureCache([&streamer](const std::string& path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip, FileData file) {
+        return streamer.load(path, internalFormat, format, type, flip, std::move(file));
+    }, false) {}
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    std::shared_ptr<Texture> get(const std::string& path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip) {
+        const std::string parameters = _parameterKey(internalFormat, format, type, flip);
+
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+        if (error) { canonical = std::filesystem::path(path).lexically_normal(); }
+        const std::string pathKey = canonical.string() + parameters;
+
+        if (const auto it = m_byPath.find(pathKey); it != m_byPath.end()) {
+            ++m_stats.pathHits;
+            return _handle(*it->second);
+        }
+
+        // Hashing reads the file, but it is mapped or read in one go and only happens once per new path. On a miss the
+        // open file goes on to the loader, so the job doesn't read it again.
+        FileData file = FileData::open(path);
+        const std::string contentKey = std::to_string(file.hash()) + parameters;
+        if (file) {
+            if (const auto it = m_byContent.find(contentKey); it != m_byContent.end()) {
+                ++m_stats.contentHits;
+                m_byPath[pathKey] = it->second;
+                it->second->pathKeys.push_back(pathKey);
+                return _handle(*it->second);
+            }
+        }
+
+        ++m_stats.misses;
+        auto entry = std::make_shared<Entry>();
+        if (file) {
+            entry->contentKey = contentKey;
+            m_byContent[contentKey] = entry;
+        }
+        entry->texture = m_load(path, internalFormat, format, type, flip, std::move(file));
+        entry->pathKeys.push_back(pathKey);
+        m_byPath[pathKey] = entry;
+        return _handle(*entry);
+    }
+
+    // Call once per frame on the GL thread. Frees textures nobody holds a handle to anymore.
+    void collect() {
+        if (!m_released->exchange(false)) { return; }
+
+        std::vector<std::shared_ptr<Entry>> dead;
+        for (const auto& [key, entry] : m_byPath) {
+            if (entry->handle.expired() && std::find(dead.begin(), dead.end(), entry) == dead.end()) {
+                dead.push_back(entry);
+            }
+        }
+
+        for (const std::shared_ptr<Entry>& entry : dead) {
+            for (const std::string& key : entry->pathKeys) {
+                m_byPath.erase(key);
+            }
+            if (!entry->contentKey.empty()) {
+                m_byContent.erase(entry->contentKey);
+            }
+
+            // A pending load is dropped by the loader once we let go of it, failed ones only ever had the placeholder.
+            if (m_destroyReleased && entry->texture->isReady()) {
+                entry->texture->destroy();
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return m_byContent.size(); }
+    [[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+private:
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        // Tracks the handles given out, separately from texture which the cache always holds.
+        std::weak_ptr<Texture> handle;
+        std::vector<std::string> pathKeys;
+        std::string contentKey;
+    };
+
+    using LoadFunction = std::function<std::shared_ptr<Texture>(const std::string&, GLint, GLenum, GLenum, bool, FileData)>;
+
+    LoadFunction m_load;
+    bool m_destroyReleased;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> m_byPath;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> m_byContent;
+    std::shared_ptr<std::atomic<bool>> m_released;
+    Stats m_stats;
+
+    TextureCache(LoadFunction load, const bool destroyReleased) :
+        m_load(std::move(load)), m_destroyReleased(destroyReleased), m_released(std::make_shared<std::atomic<bool>>(false)) {}
+
+    // Every user shares one handle whose count is the number of users. Dropping the last one only flags the cache,
+    // the GL texture is freed in collect() on the GL thread. The flag is shared so late handles can outlive the cache.
+    std::shared_ptr<Texture> _handle(Entry& entry) {
+        if (std::shared_ptr<Texture> handle = entry.handle.lock()) {
+            return handle;
+        }
+
+        std::shared_ptr<Texture> handle(entry.texture.get(), [released = m_released](Texture*) {
+            released->store(true);
+        });
+        entry.handle = handle;
+        return handle;
+    }
+
+    static std::string _parameterKey(const GLint internalFormat, const GLenum format, const GLenum type, const bool flip) {
+        return "|" + std::to_string(internalFormat) + "|" + std::to_string(format) + "|" + std::to_string(type) + (flip ? "|f" : "|n");
+    }
+};
+
+#endif //TEXTURECACHE_H
@@ -0,0 +1,141 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CompressedTexture.h"
+#include "JobPool.h"
+#include "MipGenerator.h"
+#include "Texture.h"
+#include "TexturePack.h"
+
+// Loads textures without stalling the frame.
+// load() hands back a Texture that binds a small placeholder straight away. Jobs on the loader's pool read and decode
+// the file and build its mip chain on the CPU, then update() on the GL thread copies the pixels into pixel unpack
+// buffers and uploads them level by level in row bands, stopping once its time budget for the frame is spent.
+// A texture only swaps to its real ID once every level is in, and one that fails to load keeps the placeholder.
+// With a MipCache, chains are saved after generation and later loads of the same image skip decoding entirely.
+// .dds and .ktx2 files are block compressed and upload level by level with their own mips. They are stored top down
+// already, so the flip argument is ignored for them: bake it in with TextureCompressor --flip instead.
+// Textures out of a TexturePack skip the workers altogether, their levels go from the mapped file into the buffers.
+class TextureLoader {
+public:
+    // Bytes copied and uploaded per band. Large images spread over several frames at this granularity.
+    static constexpr size_t BAND_SIZE = 1024 * 1024;
+
+    // workerCount 0 picks one less than the hardware thread count, at least one.
+    explicit TextureLoader(MipCache* mipCache = nullptr, unsigned int workerCount = 0);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // file is path already opened, when the caller had to open it anyway. The job then reads that rather than the
+    // file a second time.
+    std::shared_ptr<Texture> load(const std::string& path, GLint internalFormat, GLenum format, GLenum type, bool flip, FileData file = {});
+    // Formats and mips come from the pack, which is kept alive until the upload is done. A name the pack doesn't have
+    // prints ERROR::TEXTURE_PACK::NOT_FOUND and fails like a missing file.
+    std::shared_ptr<Texture> load(const std::shared_ptr<const TexturePack>& pack, const std::string& name);
+
+    // Call once per frame on the GL thread. Always makes some progress, then stops once budget has passed.
+    void update(std::chrono::microseconds budget = std::chrono::microseconds(2000));
+    // Blocks until everything requested so far is uploaded.
+    void finishAll();
+
+    [[nodiscard]] size_t getPendingCount() const;
+    [[nodiscard]] unsigned int getPlaceholder() const { return m_placeholder; }
+    [[nodiscard]] JobPool& getJobPool() { return m_pool; }
+    [[nodiscard]] MipCache* getMipCache() const { return m_mipCache; }
+    [[nodiscard]] MipFilter getMipFilter() const { return m_mipFilter; }
+
+    // Applies to loads requested afterwards.
+    void setMipFilter(const MipFilter filter) { m_mipFilter = filter; }
+
+private:
+    struct Request {
+        std::shared_ptr<Texture> texture;
+        std::string path;
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+        bool flip;
+        MipFilter mipFilter;
+        // Opened by the caller, or invalid for the job to open path itself.
+        FileData file;
+    };
+
+    // A level to upload, wherever it came from. Rows are tightly packed.
+    struct LevelView {
+        const unsigned char* data;
+        size_t size;
+        int width;
+        int height;
+    };
+
+    struct Decoded {
+        Request request;
+        MipChain mips;
+        // Set instead of mips for block compressed files.
+        CompressedImage compressed;
+        // Set instead of either for textures out of a pack.
+        std::shared_ptr<const TexturePack> pack;
+        const TexturePackEntry* packEntry = nullptr;
+
+        [[nodiscard]] bool isValid() const { return mips.isValid() || !compressed.levels.empty() || (packEntry && !packEntry->levels.empty()); }
+        // 0 for raw pixels.
+        [[nodiscard]] GLenum compressedFormat() const;
+        [[nodiscard]] size_t levelCount() const;
+        [[nodiscard]] LevelView level(size_t index) const;
+    };
+
+    struct Upload {
+        Decoded image;
+        unsigned int texture = 0;
+        size_t level = 0;
+        int rowsDone = 0;
+    };
+
+    MipCache* m_mipCache;
+    MipFilter m_mipFilter = MipFilter::Box;
+    bool m_stopping = false;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_decodedReady;
+    std::deque<Request> m_requests;
+    std::deque<Decoded> m_decoded;
+    size_t m_decoding = 0;
+
+    // GL thread only.
+    std::deque<Upload> m_uploads;
+    std::vector<unsigned int> m_freeBuffers;
+    unsigned int m_placeholder = 0;
+    std::unordered_map<GLenum, bool> m_formatSupport;
+
+    void _work();
+    [[nodiscard]] Decoded _decode(Request request);
+
+    void _createTexture(Upload& upload);
+    bool _uploadBand(Upload& upload);
+    bool _uploadLevel(Upload& upload);
+    // Copies bytes into a pooled pixel unpack buffer and leaves it bound. Returns the pointer to pass to glTex*Image,
+    // null for the buffer's start, or source itself if the buffer couldn't be mapped.
+    const void* _stage(const unsigned char* source, size_t bytes, unsigned int& buffer);
+    void _unstage(unsigned int buffer);
+    void _finish(Upload& upload) const;
+    void _fail(Upload& upload) const;
+    void _buildPlaceholder();
+
+    // Last, so it is destroyed first and no job outlives the state above.
+    JobPool m_pool;
+};
+
+#endif //TEXTURELOADER_H
@@ -0,0 +1,113 @@
+#ifndef TEXTUREPACK_H
+#define TEXTUREPACK_H
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CompressedTexture.h"
+#include "FileData.h"
+#include "MipGenerator.h"
+
+// One mip level of a pack entry, offset from the start of the pack file.
+struct TexturePackLevel {
+    size_t offset;
+    size_t size;
+    int width;
+    int height;
+};
+
+// A texture inside a TexturePack, stored the way it will be uploaded.
+struct TexturePackEntry {
+    GLint internalFormat;
+    // Pixel format and type for glTexImage2D, 0 for block compressed entries which go through glCompressedTexImage2D.
+    GLenum format;
+    GLenum type;
+    std::vector<TexturePackLevel> levels;
+
+    [[nodiscard]] bool isCompressed() const { return format == 0; }
+    [[nodiscard]] int getWidth() const { return levels.empty() ? 0 : levels[0].width; }
+    [[nodiscard]] int getHeight() const { return levels.empty() ? 0 : levels[0].height; }
+};
+
+// Archive of textures cooked ahead of time by TexturePacker: full mip chains, either raw 8 bit pixels or block
+// compressed, behind an index of names. The file is mapped in and levels upload straight out of the mapping,
+// so loading is bound by reading the file rather than by decoding images.
+class TexturePack {
+public:
+    // Prints ERROR::TEXTURE_PACK::... and returns false if the file is missing, from another version or damaged.
+    static bool load(const std::filesystem::path& path, TexturePack& pack);
+
+    // Null if the pack has nothing of that name.
+    [[nodiscard]] const TexturePackEntry* find(const std::string& name) const;
+    [[nodiscard]] const unsigned char* levelData(const TexturePackLevel& level) const { return m_file.bytes() + level.offset; }
+    [[nodiscard]] size_t size() const { return m_entries.size(); }
+
+    // True if pack exists and is newer than every file under directory.
+    static bool isUpToDate(const std::filesystem::path& directory, const std::filesystem::path& packPath);
+
+private:
+    friend class TexturePackWriter;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t levelCount;
+    };
+
+    // Followed in the file by the entry's levels in the level table, then its name in the name block.
+    struct EntryRecord {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t firstLevel;
+        uint32_t levelCount;
+        uint32_t internalFormat;
+        uint32_t format;
+        uint32_t type;
+        uint32_t reserved;
+    };
+
+    struct LevelRecord {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static constexpr uint32_t MAGIC = 0x4B505445; // "ETPK"
+    static constexpr uint32_t VERSION = 1;
+    // Level data starts on this boundary, so copies out of the mapping stay aligned.
+    static constexpr size_t DATA_ALIGNMENT = 16;
+    // Levels claiming to be bigger than this either side are treated as damage, well past any texture GL accepts.
+    static constexpr uint32_t MAX_DIMENSION = 65536;
+
+    FileData m_file;
+    std::unordered_map<std::string, TexturePackEntry> m_entries;
+};
+
+// Collects textures and writes them out as a TexturePack.
+class TexturePackWriter {
+public:
+    // Raw 8 bit chain. sRGB only applies to 3 and 4 channel images.
+    void add(const std::string& name, const MipChain& chain, bool srgb);
+    void add(const std::string& name, const CompressedImage& image);
+
+    bool save(const std::filesystem::path& path) const;
+    [[nodiscard]] size_t size() const { return m_textures.size(); }
+
+private:
+    struct Pending {
+        std::string name;
+        TexturePackEntry entry;
+        std::vector<unsigned char> data;
+    };
+
+    std::vector<Pending> m_textures;
+};
+
+#endif //TEXTUREPACK_H
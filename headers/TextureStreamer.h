@@ -0,0 +1,138 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include "MipGenerator.h"
+#include "Object3d.h"
+#include "Texture.h"
+#include "TextureLoader.h"
+
+// Keeps textures within a VRAM budget by only holding the mip levels they are actually drawn at.
+// load() works like TextureLoader::load, but once decoded only the small tail of the chain is uploaded. Each frame the
+// objects using a texture report how many pixels tall they appear on screen, which picks the finest level worth
+// having, and update() streams levels in one at a time towards that, most blurry texture first.
+// When everything wanted won't fit, textures give up their finest level in turn, whichever has the most texels per
+// pixel on screen first, so all of them lose sharpness gradually rather than some dropping to the tail.
+// Levels stay resident while there is room, and are only evicted when space is needed, longest unseen first.
+// Decoded chains are kept in memory (or mapped from the MipCache) so evicted levels can come back without decoding.
+class TextureStreamer {
+public:
+    struct Stats {
+        size_t residentBytes = 0;
+        size_t budgetBytes = 0;
+        size_t textureCount = 0;
+        size_t levelsStreamed = 0;
+        size_t levelsEvicted = 0;
+    };
+
+    // Levels this size and smaller go in as soon as a texture is decoded and are never evicted.
+    static constexpr int TAIL_SIZE = 64;
+    // A texture not asked for in this many frames is treated as off screen and only needs its tail.
+    static constexpr unsigned int UNSEEN_FRAMES = 60;
+
+    // Decodes on the loader's pool, with its placeholder, mip cache and filter.
+    TextureStreamer(TextureLoader& loader, size_t budgetBytes);
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Only uncompressed images (anything stb_image reads) are streamed.
+    // file as for TextureLoader::load.
+    std::shared_ptr<Texture> load(const std::string& path, GLint internalFormat, GLenum format, GLenum type, bool flip, FileData file = {});
+
+    // Reports that texture is drawn pixels tall this frame. The largest report of the frame wins.
+    void requestScreenSize(const Texture& texture, float pixels);
+    // Reports every texture of object from the projected size of its mesh's bounding sphere.
+    void requestObject(const Object3D& object, const glm::mat4& view, const glm::mat4& projection, float viewportHeight);
+
+    // Call once per frame on the GL thread, after the frame's requests. Evicts straight away when over budget, then
+    // uploads levels in row bands until budget has passed, always making some progress.
+    void update(std::chrono::microseconds budget = std::chrono::microseconds(1000));
+
+    // Takes effect on the next update().
+    void setBudget(size_t bytes) { m_budget = bytes; }
+    [[nodiscard]] Stats getStats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        std::string path;
+        GLint internalFormat;
+        GLenum format;
+        GLenum type;
+
+        MipChain mips;
+        size_t tailLevel = 0;
+        // Finest level that is fully uploaded, GL_TEXTURE_BASE_LEVEL. Everything from here down is resident.
+        size_t baseLevel = 0;
+        // Finest level wanted this frame once the budget is taken into account.
+        size_t targetLevel = 0;
+
+        size_t residentBytes = 0;
+
+        // Largest request so far this frame, the last frame it was seen, and what the targets were picked from.
+        float screenSize = 0.0f;
+        float lastScreenSize = 0.0f;
+        float drawnSize = 0.0f;
+        unsigned int framesUnseen = UNSEEN_FRAMES;
+    };
+
+    struct Decoded {
+        std::weak_ptr<Entry> entry;
+        MipChain mips;
+    };
+
+    // Shared with the decode jobs, so one finishing after the streamer is gone has somewhere to go.
+    struct Completed {
+        std::mutex mutex;
+        std::deque<Decoded> decoded;
+    };
+
+    // The level being uploaded band by band. Below baseLevel, so not sampled until it is complete.
+    struct Upload {
+        std::shared_ptr<Entry> entry;
+        size_t level = 0;
+        int rowsDone = 0;
+    };
+
+    TextureLoader& m_loader;
+    size_t m_budget;
+    size_t m_resident = 0;
+    size_t m_levelsStreamed = 0;
+    size_t m_levelsEvicted = 0;
+
+    std::shared_ptr<Completed> m_completed;
+    std::unordered_map<const Texture*, std::shared_ptr<Entry>> m_entries;
+    Upload m_upload;
+
+    // Bytes level takes in VRAM. An estimate, 3 channel formats are assumed padded to 4 as most drivers do.
+    [[nodiscard]] static size_t _levelBytes(const Entry& entry, size_t level);
+    // How many texels of level fall on each screen pixel. Textures that are off screen come out as the largest.
+    [[nodiscard]] static float _oversampling(const Entry& entry, size_t level);
+
+    void _receiveDecoded();
+    void _releaseUnused();
+    void _chooseTargets();
+    // Frees the finest resident level of the entry with the most to spare. Returns false if nothing can go.
+    bool _evictOne();
+    // Starts the next level of the blurriest texture, or returns false when nothing wanted fits.
+    bool _beginUpload();
+    // Uploads one band of m_upload. Returns true once the level is complete.
+    bool _uploadBand();
+    // Drops the partly uploaded level.
+    void _cancelUpload();
+    void _evictLevel(Entry& entry);
+    void _destroy(Entry& entry);
+};
+
+#endif //TEXTURESTREAMER_H
@@ -0,0 +1,132 @@
+#ifndef UNIFORMBINDING_H
+#define UNIFORMBINDING_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Runtime side of the structs ShaderReflect generates into ShaderUniforms.h.
+// Each generated struct lists its fields with a type and byte offset, so pushing a struct is one loop over
+// pre-resolved locations rather than a name lookup per uniform.
+
+enum class UniformType { Float, Int, UInt, Vec2, Vec3, Vec4, IVec2, IVec3, IVec4, Mat3, Mat4 };
+
+struct UniformField {
+    const char* name;
+    UniformType type;
+    size_t offset;
+    int count; // Array length, 1 for plain uniforms.
+};
+
+inline size_t uniformTypeSize(const UniformType type) {
+    switch (type) {
+        case UniformType::Float: case UniformType::Int: case UniformType::UInt: return 4;
+        case UniformType::Vec2: case UniformType::IVec2: return 8;
+        case UniformType::Vec3: case UniformType::IVec3: return 12;
+        case UniformType::Vec4: case UniformType::IVec4: return 16;
+        case UniformType::Mat3: return 36;
+        case UniformType::Mat4: return 64;
+    }
+    return 0;
+}
+
+struct UniformStats {
+    uint64_t hits = 0;   // Uploads skipped because the program already held the value.
+    uint64_t misses = 0; // Uploads that reached the driver.
+};
+
+// Shadow copy of the uniform values last uploaded to one program. Programs are shared between shaders (every
+// pending shader draws with the build queue's fallback), so shadows live per program ID rather than per Shader.
+// Only valid while every upload to the program goes through here, and only touched on the GL thread.
+class UniformShadow {
+public:
+    // Records value for location and returns whether it differs from what the program already holds.
+    bool update(const int location, const void* value, const size_t size) {
+        Slot& slot = m_slots[location];
+        if (slot.size == size && std::memcmp(m_bytes.data() + slot.offset, value, size) == 0) {
+            ++m_stats.hits;
+            ++s_totalStats.hits;
+            return false;
+        }
+
+        if (slot.size != size) {
+            slot.offset = m_bytes.size();
+            slot.size = size;
+            m_bytes.resize(m_bytes.size() + size);
+        }
+        std::memcpy(m_bytes.data() + slot.offset, value, size);
+        ++m_stats.misses;
+        ++s_totalStats.misses;
+        return true;
+    }
+
+    [[nodiscard]] const UniformStats& getStats() const { return m_stats; }
+    void resetStats() { m_stats = {}; }
+
+    static UniformShadow& forProgram(const unsigned int program) { return s_shadows[program]; }
+    // Call when a program is deleted, GL may hand the same ID out again.
+    static void release(const unsigned int program) { s_shadows.erase(program); }
+
+    [[nodiscard]] static const UniformStats& getTotalStats() { return s_totalStats; }
+    static void resetTotalStats() { s_totalStats = {}; }
+
+private:
+    struct Slot {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    std::unordered_map<int, Slot> m_slots;
+    std::vector<unsigned char> m_bytes;
+    UniformStats m_stats;
+
+    static inline std::unordered_map<unsigned int, UniformShadow> s_shadows;
+    static inline UniformStats s_totalStats;
+};
+
+// Looks up a location per field. Fields the program doesn't use (optimised out or in another permutation) get -1,
+// which glUniform ignores.
+inline std::vector<int> resolveUniformLocations(const unsigned int program, const std::span<const UniformField> fields) {
+    std::vector<int> locations(fields.size());
+    for (size_t i = 0; i < fields.size(); ++i) {
+        locations[i] = glGetUniformLocation(program, fields[i].name);
+    }
+    return locations;
+}
+
+// Pushes the fields of a generated struct that changed to the currently bound program, shadow must be that program's.
+inline void applyUniforms(const std::vector<int>& locations, const std::span<const UniformField> fields, const void* values, UniformShadow& shadow) {
+    const auto* bytes = static_cast<const unsigned char*>(values);
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const int location = locations[i];
+        if (location < 0) { continue; }
+
+        const UniformField& field = fields[i];
+        if (!shadow.update(location, bytes + field.offset, uniformTypeSize(field.type) * field.count)) { continue; }
+
+        const auto* f = reinterpret_cast<const GLfloat*>(bytes + field.offset);
+        const auto* n = reinterpret_cast<const GLint*>(bytes + field.offset);
+
+        switch (field.type) {
+            case UniformType::Float: glUniform1fv(location, field.count, f); break;
+            case UniformType::Int: glUniform1iv(location, field.count, n); break;
+            case UniformType::UInt: glUniform1uiv(location, field.count, reinterpret_cast<const GLuint*>(n)); break;
+            case UniformType::Vec2: glUniform2fv(location, field.count, f); break;
+            case UniformType::Vec3: glUniform3fv(location, field.count, f); break;
+            case UniformType::Vec4: glUniform4fv(location, field.count, f); break;
+            case UniformType::IVec2: glUniform2iv(location, field.count, n); break;
+            case UniformType::IVec3: glUniform3iv(location, field.count, n); break;
+            case UniformType::IVec4: glUniform4iv(location, field.count, n); break;
+            case UniformType::Mat3: glUniformMatrix3fv(location, field.count, GL_FALSE, f); break;
+            case UniformType::Mat4: glUniformMatrix4fv(location, field.count, GL_FALSE, f); break;
+        }
+    }
+}
+
+#endif //UNIFORMBINDING_H
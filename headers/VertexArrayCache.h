@@ -0,0 +1,78 @@
+#ifndef VERTEXARRAYCACHE_H
+#define VERTEXARRAYCACHE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+#include "VertexLayout.h"
+
+// Hands out one VAO per vertex layout and set of buffers it reads, built from the layout the first time it is asked
+// for. Buffers sharing a layout then never touch attribute state again, and a pass reading fewer attributes (a
+// VertexLayout::only) gets its own VAO over the same buffers.
+// Core 3.3 has no separate vertex formats, so the buffers are part of what a VAO is cached under. Call release()
+// before deleting a buffer, or a new buffer given the same name would be drawn through a stale VAO.
+class VertexArrayCache {
+public:
+    // buffers holds one name per layout stream. Needs a current context.
+    GLuint get(const VertexLayout& layout, const GLuint* buffers, const GLuint indexBuffer) {
+        Key key = { layout, {}, indexBuffer };
+        std::copy_n(buffers, layout.getStreamCount(), key.buffers.begin());
+
+        if (const auto it = m_vertexArrays.find(key); it != m_vertexArrays.end()) {
+            return it->second;
+        }
+
+        GLuint vertexArray;
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+        layout.apply(buffers);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        glBindVertexArray(0);
+
+        m_vertexArrays.emplace(std::move(key), vertexArray);
+        return vertexArray;
+    }
+
+    // Deletes every VAO reading from buffer.
+    void release(const GLuint buffer) {
+        std::erase_if(m_vertexArrays, [&](const auto& entry) {
+            const Key& key = entry.first;
+            if (key.indexBuffer != buffer && std::find(key.buffers.begin(), key.buffers.end(), buffer) == key.buffers.end()) { return false; }
+            glDeleteVertexArrays(1, &entry.second);
+            return true;
+        });
+    }
+
+    [[nodiscard]] size_t size() const { return m_vertexArrays.size(); }
+
+    void destroy() {
+        for (const auto& [key, vertexArray] : m_vertexArrays) {
+            glDeleteVertexArrays(1, &vertexArray);
+        }
+        m_vertexArrays.clear();
+    }
+
+private:
+    struct Key {
+        VertexLayout layout;
+        std::array<GLuint, VertexLayout::MAX_STREAMS> buffers;
+        GLuint indexBuffer;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            size_t hash = key.layout.hash();
+            for (const GLuint buffer : key.buffers) { hash = hash * 31 + buffer; }
+            return hash * 31 + key.indexBuffer;
+        }
+    };
+
+    std::unordered_map<Key, GLuint, KeyHash> m_vertexArrays;
+};
+
+#endif //VERTEXARRAYCACHE_H
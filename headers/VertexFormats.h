@@ -0,0 +1,39 @@
+#ifndef VERTEXFORMATS_H
+#define VERTEXFORMATS_H
+
+#include <cstddef>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "MathHeaders/Packed.h"
+
+// Describes how one vertex attribute is laid out, in the terms glVertexAttribPointer wants.
+struct VertexAttributeFormat {
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    GLsizei size;
+};
+
+// Maps a C++ attribute type to its GL format, so buffers can be set up straight from the struct member type.
+template <typename T>
+struct VertexFormatOf;
+
+template <> struct VertexFormatOf<float> { static constexpr VertexAttributeFormat value = {1, GL_FLOAT, GL_FALSE, sizeof(float)}; };
+template <> struct VertexFormatOf<glm::vec2> { static constexpr VertexAttributeFormat value = {2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2)}; };
+template <> struct VertexFormatOf<glm::vec3> { static constexpr VertexAttributeFormat value = {3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3)}; };
+template <> struct VertexFormatOf<glm::vec4> { static constexpr VertexAttributeFormat value = {4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4)}; };
+
+template <> struct VertexFormatOf<emc::Half2> { static constexpr VertexAttributeFormat value = {2, GL_HALF_FLOAT, GL_FALSE, sizeof(emc::Half2)}; };
+template <> struct VertexFormatOf<emc::Half4> { static constexpr VertexAttributeFormat value = {4, GL_HALF_FLOAT, GL_FALSE, sizeof(emc::Half4)}; };
+template <> struct VertexFormatOf<emc::Snorm16x4> { static constexpr VertexAttributeFormat value = {4, GL_SHORT, GL_TRUE, sizeof(emc::Snorm16x4)}; };
+template <> struct VertexFormatOf<emc::Unorm16x2> { static constexpr VertexAttributeFormat value = {2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(emc::Unorm16x2)}; };
+template <> struct VertexFormatOf<emc::Snorm1010102> { static constexpr VertexAttributeFormat value = {4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(emc::Snorm1010102)}; };
+
+// Enables and points attribute `index` at `offset` bytes into the bound GL_ARRAY_BUFFER.
+inline void setVertexAttribute(const GLuint index, const VertexAttributeFormat& format, const GLsizei stride, const size_t offset) {
+    glEnableVertexAttribArray(index);
+    glVertexAttribPointer(index, format.components, format.type, format.normalized, stride, reinterpret_cast<void *>(offset));
+}
+
+#endif //VERTEXFORMATS_H
@@ -0,0 +1,154 @@
+#ifndef VERTEXLAYOUT_H
+#define VERTEXLAYOUT_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <vector>
+
+#include "VertexFormats.h"
+
+// What an attribute holds. Each has a fixed location every shader declares it at.
+enum class VertexSemantic : uint8_t {
+    Position,
+    TexCoord,
+};
+
+constexpr GLuint locationOf(const VertexSemantic semantic) {
+    switch (semantic) {
+        case VertexSemantic::Position: return 0;
+        case VertexSemantic::TexCoord: return 1;
+    }
+    return 0;
+}
+
+struct VertexLayoutAttribute {
+    VertexSemantic semantic;
+    VertexAttributeFormat format;
+    // Which vertex buffer it is read from, and where in each of that buffer's vertices.
+    uint32_t stream;
+    uint32_t offset;
+
+    bool operator==(const VertexLayoutAttribute& other) const {
+        return semantic == other.semantic && stream == other.stream && offset == other.offset && format.components == other.format.components &&
+               format.type == other.format.type && format.normalized == other.format.normalized && format.size == other.format.size;
+    }
+};
+
+// How a mesh's vertices are stored on the GPU: which attributes there are, in what format, and split across which
+// streams (separate vertex buffers). Meshes can leave out attributes they don't use, store them compactly, and keep
+// positions in a stream of their own so passes that only need positions fetch nothing else.
+class VertexLayout {
+public:
+    // One vertex buffer per stream.
+    static constexpr uint32_t MAX_STREAMS = 4;
+
+    // Appends an attribute after whatever stream already holds. Semantics can only be added once.
+    VertexLayout& add(const VertexSemantic semantic, const VertexAttributeFormat& format, const uint32_t stream = 0) {
+        if (stream >= MAX_STREAMS || has(semantic)) {
+            std::cout << "ERROR::VERTEX_LAYOUT::ATTRIBUTE_NOT_ADDED " << locationOf(semantic) << std::endl;
+            return *this;
+        }
+        m_attributes.push_back({ semantic, format, stream, m_strides[stream] });
+        m_strides[stream] += static_cast<uint32_t>(format.size);
+        m_streamCount = std::max(m_streamCount, stream + 1);
+        return *this;
+    }
+
+    // Float position and texture coordinate interleaved in one stream, byte for byte the Vertex struct.
+    static VertexLayout standard() {
+        VertexLayout layout;
+        layout.add(VertexSemantic::Position, VertexFormatOf<glm::vec3>::value);
+        layout.add(VertexSemantic::TexCoord, VertexFormatOf<glm::vec2>::value);
+        return layout;
+    }
+
+    // Half float positions alone in stream 0 and 16 bit texture coordinates in stream 1, 12 bytes a vertex instead of
+    // 20. Positions lose precision away from the origin, and texture coordinates must stay within [0, 1].
+    static VertexLayout compact() {
+        VertexLayout layout;
+        layout.add(VertexSemantic::Position, VertexFormatOf<emc::Half4>::value, 0);
+        layout.add(VertexSemantic::TexCoord, VertexFormatOf<emc::Unorm16x2>::value, 1);
+        return layout;
+    }
+
+    // The same layout with only semantics left, strides and offsets unchanged, for reading fewer attributes out of the
+    // same buffers (e.g. positions for a depth only pass).
+    [[nodiscard]] VertexLayout only(const std::initializer_list<VertexSemantic> semantics) const {
+        VertexLayout layout = *this;
+        std::erase_if(layout.m_attributes, [&](const VertexLayoutAttribute& attribute) {
+            return std::find(semantics.begin(), semantics.end(), attribute.semantic) == semantics.end();
+        });
+        return layout;
+    }
+
+    [[nodiscard]] bool has(const VertexSemantic semantic) const {
+        return std::any_of(m_attributes.begin(), m_attributes.end(), [&](const VertexLayoutAttribute& attribute) { return attribute.semantic == semantic; });
+    }
+
+    [[nodiscard]] const std::vector<VertexLayoutAttribute>& getAttributes() const { return m_attributes; }
+    [[nodiscard]] uint32_t getStreamCount() const { return m_streamCount; }
+    [[nodiscard]] uint32_t getStride(const uint32_t stream) const { return stream < MAX_STREAMS ? m_strides[stream] : 0; }
+    // Bytes per vertex over every stream.
+    [[nodiscard]] uint32_t getVertexSize() const {
+        uint32_t size = 0;
+        for (uint32_t stream = 0; stream < m_streamCount; ++stream) { size += m_strides[stream]; }
+        return size;
+    }
+
+    bool operator==(const VertexLayout& other) const {
+        return m_attributes == other.m_attributes && m_strides == other.m_strides && m_streamCount == other.m_streamCount;
+    }
+
+    [[nodiscard]] size_t hash() const {
+        size_t hash = m_streamCount;
+        for (const VertexLayoutAttribute& attribute : m_attributes) {
+            for (const size_t value : { static_cast<size_t>(attribute.semantic), static_cast<size_t>(attribute.format.type),
+                                        static_cast<size_t>(attribute.format.components), static_cast<size_t>(attribute.stream),
+                                        static_cast<size_t>(attribute.offset) }) {
+                hash = hash * 31 + value;
+            }
+        }
+        for (const uint32_t stride : m_strides) { hash = hash * 31 + stride; }
+        return hash;
+    }
+
+    // Points every attribute at its stream in buffers, which must hold getStreamCount() buffer names. Needs the VAO
+    // to fill in bound.
+    void apply(const GLuint* buffers) const {
+        for (const VertexLayoutAttribute& attribute : m_attributes) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffers[attribute.stream]);
+            setVertexAttribute(locationOf(attribute.semantic), attribute.format, static_cast<GLsizei>(m_strides[attribute.stream]), attribute.offset);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    std::vector<VertexLayoutAttribute> m_attributes;
+    std::array<uint32_t, MAX_STREAMS> m_strides{};
+    uint32_t m_streamCount = 0;
+};
+
+// Writes one attribute's components in format's type. Integer types are always written normalized, which is all
+// VertexFormatOf describes.
+inline void encodeVertexAttribute(const float* values, const VertexAttributeFormat& format, unsigned char* out) {
+    for (int c = 0; c < format.components; ++c) {
+        switch (format.type) {
+            case GL_FLOAT: std::memcpy(out + c * 4, &values[c], 4); break;
+            case GL_HALF_FLOAT: { const uint16_t half = emc::FloatToHalf(values[c]); std::memcpy(out + c * 2, &half, 2); break; }
+            case GL_SHORT: { const int16_t snorm = emc::FloatToSnorm16(values[c]); std::memcpy(out + c * 2, &snorm, 2); break; }
+            case GL_UNSIGNED_SHORT: { const uint16_t unorm = emc::FloatToUnorm16(values[c]); std::memcpy(out + c * 2, &unorm, 2); break; }
+            case GL_INT_2_10_10_10_REV: {
+                const uint32_t bits = emc::Snorm1010102::Encode(values[0], values[1], values[2], values[3]);
+                std::memcpy(out, &bits, 4);
+                return;
+            }
+            default: break;
+        }
+    }
+}
+
+#endif //VERTEXLAYOUT_H
@@ -1,12 +1,20 @@
 #version 330 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
 
-out vec4 FragColor;
-
-in vec2 TexCoord;
-
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+#include "fragment_common.glsl"
+#include "material.glsl"
+#ifdef ATLAS
+#include "atlas.glsl"
+#endif
 
 void main() {
-    FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.6);
+#if defined(ATLAS)
+    FragColor = sampleAtlas(TexCoord);
+#elif defined(SINGLE_TEXTURE)
+    FragColor = sampleTexture1(TexCoord);
+#else
+    FragColor = mix(sampleTexture1(TexCoord), sampleTexture2(TexCoord), 0.6);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+// Image inside a TextureAtlas: the array layer and the UV rectangle as offset in xy, size in zw.
+uniform sampler2DArray atlasPages;
+uniform vec4 atlasRect;
+uniform float atlasLayer;
+
+// Wraps uv inside the image so repeating UVs behave like GL_REPEAT. Gradients come from the unwrapped coordinates,
+// otherwise every wrap would drop to the smallest mip for a pixel.
+vec4 sampleAtlas(vec2 uv) {
+    vec2 scaled = uv * atlasRect.zw;
+    return textureGrad(atlasPages, vec3(atlasRect.xy + fract(uv) * atlasRect.zw, atlasLayer), dFdx(scaled), dFdy(scaled));
+}
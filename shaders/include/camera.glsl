@@ -0,0 +1,2 @@
+uniform mat4 view;
+uniform mat4 projection;
@@ -0,0 +1,3 @@
+out vec4 FragColor;
+
+in vec2 TexCoord;
@@ -0,0 +1,24 @@
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+
+#ifdef BINDLESS
+// Handles of every material's textures, texture1 in xy and texture2 in zw. See BindlessTextures.h.
+layout(std140) uniform BindlessMaterials {
+    uvec4 materialHandles[1024];
+};
+// Slot of this draw's material, or -1 to sample the textures bound to texture1 and texture2 instead.
+uniform int materialIndex;
+
+vec4 sampleTexture1(vec2 uv) {
+    if (materialIndex < 0) { return texture(texture1, uv); }
+    return texture(sampler2D(materialHandles[materialIndex].xy), uv);
+}
+
+vec4 sampleTexture2(vec2 uv) {
+    if (materialIndex < 0) { return texture(texture2, uv); }
+    return texture(sampler2D(materialHandles[materialIndex].zw), uv);
+}
+#else
+vec4 sampleTexture1(vec2 uv) { return texture(texture1, uv); }
+vec4 sampleTexture2(vec2 uv) { return texture(texture2, uv); }
+#endif
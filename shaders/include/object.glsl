@@ -0,0 +1 @@
+uniform mat4 model;
@@ -5,9 +5,8 @@ layout (location = 1) in vec2 aTexCoord;
 
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "camera.glsl"
+#include "object.glsl"
 
 void main() {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
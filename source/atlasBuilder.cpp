@@ -0,0 +1,408 @@
+#include "../headers/AtlasBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "stb_image/stb_image.h"
+
+namespace {
+    int alignUp(const int value, const int alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Levels whose gutter is still at least a texel wide.
+    size_t levelCountFor(const int pageSize, const int padding) {
+        size_t levels = 1;
+        while ((padding >> levels) >= 1 && (pageSize >> levels) >= 1) { ++levels; }
+        return levels;
+    }
+
+    // Levels in a full chain down to 1x1, the most a page can have whatever its padding.
+    size_t fullLevelCount(const int pageSize) {
+        return levelCountFor(pageSize, pageSize);
+    }
+
+    size_t levelBytes(const int pageSize, const size_t level) {
+        const size_t size = std::max(1, pageSize >> level);
+        return size * size * 4;
+    }
+}
+
+SkylinePacker::SkylinePacker(const int width, const int height) : m_width(width), m_height(height) {
+    m_skyline.push_back({ 0, 0, width });
+}
+
+std::optional<AtlasRect> SkylinePacker::insert(const int width, const int height) {
+    if (width <= 0 || height <= 0) { return std::nullopt; }
+
+    // Lowest top edge wins, ties go to the narrowest segment so wide gaps are kept for wide images.
+    size_t bestIndex = 0;
+    int bestTop = m_height + 1;
+    int bestWidth = m_width + 1;
+    for (size_t i = 0; i < m_skyline.size(); ++i) {
+        const int y = _fit(i, width, height);
+        if (y < 0) { continue; }
+        if (y + height < bestTop || (y + height == bestTop && m_skyline[i].width < bestWidth)) {
+            bestIndex = i;
+            bestTop = y + height;
+            bestWidth = m_skyline[i].width;
+        }
+    }
+    if (bestTop > m_height) { return std::nullopt; }
+
+    const AtlasRect rect = { m_skyline[bestIndex].x, bestTop - height, width, height };
+    m_skyline.insert(m_skyline.begin() + static_cast<std::ptrdiff_t>(bestIndex), { rect.x, bestTop, width });
+
+    // Trim the segments the new one now covers.
+    for (size_t i = bestIndex + 1; i < m_skyline.size();) {
+        const Segment& previous = m_skyline[i - 1];
+        Segment& segment = m_skyline[i];
+        const int overlap = previous.x + previous.width - segment.x;
+        if (overlap <= 0) { break; }
+
+        segment.x += overlap;
+        segment.width -= overlap;
+        if (segment.width > 0) { break; }
+        m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    // Merge neighbours left at the same height.
+    for (size_t i = 0; i + 1 < m_skyline.size();) {
+        if (m_skyline[i].y == m_skyline[i + 1].y) {
+            m_skyline[i].width += m_skyline[i + 1].width;
+            m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    m_usedArea += static_cast<size_t>(width) * height;
+    return rect;
+}
+
+float SkylinePacker::getOccupancy() const {
+    return static_cast<float>(m_usedArea) / (static_cast<float>(m_width) * static_cast<float>(m_height));
+}
+
+int SkylinePacker::_fit(size_t index, const int width, const int height) const {
+    if (m_skyline[index].x + width > m_width) { return -1; }
+
+    int y = 0;
+    for (int remaining = width; remaining > 0; ++index) {
+        y = std::max(y, m_skyline[index].y);
+        if (y + height > m_height) { return -1; }
+        remaining -= m_skyline[index].width;
+    }
+    return y;
+}
+
+const unsigned char* PackedAtlas::levelData(const size_t layer, const size_t level) const {
+    if (!m_file) {
+        return m_pages[layer].levelData(level);
+    }
+
+    size_t layerBytes = 0;
+    for (size_t i = 0; i < m_levelCount; ++i) { layerBytes += levelBytes(m_pageSize, i); }
+    size_t offset = m_pixelOffset + layer * layerBytes;
+    for (size_t i = 0; i < level; ++i) { offset += levelBytes(m_pageSize, i); }
+    return m_file.bytes() + offset;
+}
+
+bool PackedAtlas::save(const std::filesystem::path &path) const {
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+
+    const Header header = {
+        MAGIC, VERSION, static_cast<uint32_t>(m_pageSize), static_cast<uint32_t>(m_layerCount),
+        static_cast<uint32_t>(m_levelCount), static_cast<uint32_t>(m_regions.size()), m_srgb ? 1u : 0u, 0,
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    size_t written = sizeof(header);
+    for (const auto& [name, region] : m_regions) {
+        const auto length = static_cast<uint32_t>(name.size());
+        const float rect[4] = { region.u, region.v, region.width, region.height };
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(name.data(), length);
+        file.write(reinterpret_cast<const char*>(&region.layer), sizeof(region.layer));
+        file.write(reinterpret_cast<const char*>(rect), sizeof(rect));
+        written += sizeof(length) + length + sizeof(region.layer) + sizeof(rect);
+    }
+
+    // Pixels start 16 byte aligned.
+    const char zeros[16] = {};
+    file.write(zeros, static_cast<std::streamsize>((16 - written % 16) % 16));
+
+    for (size_t layer = 0; layer < m_layerCount; ++layer) {
+        for (size_t level = 0; level < m_levelCount; ++level) {
+            file.write(reinterpret_cast<const char*>(levelData(layer, level)), static_cast<std::streamsize>(levelBytes(m_pageSize, level)));
+        }
+    }
+    file.close();
+
+    if (!file) {
+        std::cout << "ERROR::ATLAS::WRITE_FAILED " << temp.string() << std::endl;
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+bool PackedAtlas::load(const std::filesystem::path &path, PackedAtlas &atlas) {
+    FileData file = FileData::open(path);
+    if (!file) { return false; }
+
+    Header header{};
+    if (file.size() < sizeof(header)) {
+        std::cout << "ERROR::ATLAS::DAMAGED " << path.string() << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        std::cout << "ERROR::ATLAS::WRONG_VERSION " << path.string() << std::endl;
+        return false;
+    }
+    if (header.pageSize == 0 || header.pageSize > MAX_PAGE_SIZE || header.levelCount == 0 ||
+        header.levelCount > fullLevelCount(static_cast<int>(header.pageSize))) {
+        std::cout << "ERROR::ATLAS::DAMAGED " << path.string() << std::endl;
+        return false;
+    }
+
+    PackedAtlas loaded;
+    loaded.m_pageSize = static_cast<int>(header.pageSize);
+    loaded.m_layerCount = header.layerCount;
+    loaded.m_levelCount = header.levelCount;
+    loaded.m_srgb = header.srgb != 0;
+
+    size_t offset = sizeof(header);
+    const auto read = [&](void* destination, const size_t bytes) {
+        if (offset + bytes > file.size()) { return false; }
+        std::memcpy(destination, file.data() + offset, bytes);
+        offset += bytes;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < header.regionCount; ++i) {
+        uint32_t length = 0;
+        AtlasRegion region;
+        float rect[4];
+        if (!read(&length, sizeof(length)) || offset + length > file.size()) {
+            std::cout << "ERROR::ATLAS::DAMAGED " << path.string() << std::endl;
+            return false;
+        }
+        std::string name(file.data() + offset, length);
+        offset += length;
+        if (!read(&region.layer, sizeof(region.layer)) || !read(rect, sizeof(rect))) {
+            std::cout << "ERROR::ATLAS::DAMAGED " << path.string() << std::endl;
+            return false;
+        }
+        region.u = rect[0];
+        region.v = rect[1];
+        region.width = rect[2];
+        region.height = rect[3];
+        loaded.m_regions.emplace(std::move(name), region);
+    }
+
+    offset += (16 - offset % 16) % 16;
+    size_t layerBytes = 0;
+    for (size_t level = 0; level < loaded.m_levelCount; ++level) { layerBytes += levelBytes(loaded.m_pageSize, level); }
+    // Divided rather than multiplied, the layer count comes from the file.
+    if (offset > file.size() || (file.size() - offset) % layerBytes != 0 || (file.size() - offset) / layerBytes != loaded.m_layerCount) {
+        std::cout << "ERROR::ATLAS::DAMAGED " << path.string() << std::endl;
+        return false;
+    }
+
+    file.prefetch();
+    loaded.m_pixelOffset = offset;
+    loaded.m_file = std::move(file);
+    atlas = std::move(loaded);
+    return true;
+}
+
+bool AtlasBuilder::add(const std::string &name, const unsigned char *rgba, const int width, const int height) {
+    if (!m_names.insert(name).second) {
+        std::cout << "ERROR::ATLAS::DUPLICATE_NAME " << name << std::endl;
+        return false;
+    }
+    m_images.push_back({ name, width, height, std::vector<unsigned char>(rgba, rgba + static_cast<size_t>(width) * height * 4) });
+    return true;
+}
+
+bool AtlasBuilder::addFile(const std::string &name, const std::filesystem::path &path) {
+    if (m_names.contains(name)) {
+        std::cout << "ERROR::ATLAS::DUPLICATE_NAME " << name << std::endl;
+        return false;
+    }
+
+    const FileData file = FileData::open(path);
+    if (!file) { return false; }
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(file.bytes(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cout << "ERROR::ATLAS::DECODE_FAILED " << path.string() << std::endl;
+        return false;
+    }
+
+    if (m_options.flip) {
+        flipImageVertically(pixels, width, height, 4);
+    }
+
+    const bool added = add(name, pixels, width, height);
+    stbi_image_free(pixels);
+    return added;
+}
+
+bool AtlasBuilder::addManifest(const std::filesystem::path &manifestPath) {
+    bool success = true;
+    for (const auto& [name, path] : _readManifest(manifestPath)) {
+        success = addFile(name, path) && success;
+    }
+    return success;
+}
+
+bool AtlasBuilder::build(PackedAtlas &atlas, JobPool* pool) const {
+    const int pageSize = m_options.pageSize;
+    const int padding = std::max(0, m_options.padding);
+    const size_t levels = levelCountFor(pageSize, padding);
+    const int alignment = 1 << (levels - 1);
+
+    // Tallest first packs a skyline best.
+    std::vector<size_t> order(m_images.size());
+    for (size_t i = 0; i < order.size(); ++i) { order[i] = i; }
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+        return m_images[a].height != m_images[b].height ? m_images[a].height > m_images[b].height : m_images[a].width > m_images[b].width;
+    });
+
+    struct Placement {
+        size_t image;
+        size_t page;
+        AtlasRect rect;
+    };
+    std::vector<SkylinePacker> packers;
+    std::vector<Placement> placements;
+
+    for (const size_t index : order) {
+        const Image& image = m_images[index];
+        const int width = alignUp(image.width + padding * 2, alignment);
+        const int height = alignUp(image.height + padding * 2, alignment);
+        if (width > pageSize || height > pageSize) {
+            std::cout << "ERROR::ATLAS::IMAGE_TOO_LARGE " << image.name << std::endl;
+            return false;
+        }
+
+        std::optional<AtlasRect> rect;
+        size_t page = 0;
+        for (; page < packers.size() && !rect; ++page) {
+            rect = packers[page].insert(width, height);
+        }
+        if (!rect) {
+            packers.emplace_back(pageSize, pageSize);
+            rect = packers.back().insert(width, height);
+            page = packers.size();
+        }
+        placements.push_back({ index, page - 1, *rect });
+    }
+
+    PackedAtlas result;
+    result.m_pageSize = pageSize;
+    result.m_layerCount = packers.size();
+    result.m_levelCount = levels;
+    result.m_srgb = m_options.srgb;
+
+    std::vector<std::vector<unsigned char>> pages(packers.size(), std::vector<unsigned char>(static_cast<size_t>(pageSize) * pageSize * 4));
+    for (const Placement& placement : placements) {
+        const Image& image = m_images[placement.image];
+        std::vector<unsigned char>& page = pages[placement.page];
+
+        // The whole padded rectangle, the gutter wrapping round to the opposite edge of the image.
+        const int originX = placement.rect.x + padding;
+        const int originY = placement.rect.y + padding;
+        for (int y = placement.rect.y; y < placement.rect.y + placement.rect.height; ++y) {
+            const int sourceY = ((y - originY) % image.height + image.height) % image.height;
+            for (int x = placement.rect.x; x < placement.rect.x + placement.rect.width; ++x) {
+                const int sourceX = ((x - originX) % image.width + image.width) % image.width;
+                std::memcpy(&page[(static_cast<size_t>(y) * pageSize + x) * 4], &image.pixels[(static_cast<size_t>(sourceY) * image.width + sourceX) * 4], 4);
+            }
+        }
+
+        const auto size = static_cast<float>(pageSize);
+        result.m_regions[image.name] = {
+            static_cast<uint32_t>(placement.page),
+            originX / size, originY / size, image.width / size, image.height / size,
+        };
+    }
+
+    for (const std::vector<unsigned char>& page : pages) {
+        result.m_pages.push_back(generateMipChain(page.data(), pageSize, pageSize, 4, m_options.srgb, m_options.filter, pool, levels));
+    }
+
+    atlas = std::move(result);
+    return true;
+}
+
+bool AtlasBuilder::isUpToDate(const std::filesystem::path &manifestPath, const std::filesystem::path &cookedPath) {
+    std::error_code error;
+    const auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+    if (error) { return false; }
+
+    const auto manifestTime = std::filesystem::last_write_time(manifestPath, error);
+    if (error || manifestTime > cookedTime) { return false; }
+
+    for (const auto& [name, path] : _readManifest(manifestPath)) {
+        const auto time = std::filesystem::last_write_time(path, error);
+        if (error || time > cookedTime) { return false; }
+    }
+    return true;
+}
+
+bool AtlasBuilder::loadOrBuild(const std::filesystem::path &manifestPath, const std::filesystem::path &cookedPath, PackedAtlas &atlas, const AtlasOptions &options, JobPool* pool) {
+    if (isUpToDate(manifestPath, cookedPath) && PackedAtlas::load(cookedPath, atlas)) {
+        return true;
+    }
+
+    AtlasBuilder builder(options);
+    if (!builder.addManifest(manifestPath) || !builder.build(atlas, pool)) {
+        return false;
+    }
+    atlas.save(cookedPath);
+    return true;
+}
+
+std::vector<std::pair<std::string, std::filesystem::path>> AtlasBuilder::_readManifest(const std::filesystem::path &manifestPath) {
+    std::vector<std::pair<std::string, std::filesystem::path>> entries;
+    const FileData manifest = FileData::open(manifestPath);
+    if (!manifest) { return entries; }
+
+    std::istringstream lines{ std::string(manifest.view()) };
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (const size_t comment = line.find('#'); comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream tokens(line);
+        std::string first, second;
+        if (!(tokens >> first)) { continue; }
+        tokens >> second;
+
+        const std::string& file = second.empty() ? first : second;
+        entries.emplace_back(first, manifestPath.parent_path() / file);
+    }
+    return entries;
+}
@@ -0,0 +1,249 @@
+#include "../headers/CompressedTexture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "../headers/GLExtensions.h"
+
+namespace {
+    constexpr uint32_t fourCC(const char a, const char b, const char c, const char d) {
+        return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+    }
+
+    template <typename T>
+    T readAt(const FileData& file, const size_t offset) {
+        T value;
+        std::memcpy(&value, file.bytes() + offset, sizeof(T));
+        return value;
+    }
+
+    size_t blockBytes(const GLenum internalFormat) {
+        switch (internalFormat) {
+            case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            case GL_COMPRESSED_RED_RGTC1:
+                return 8;
+            default:
+                return 16;
+        }
+    }
+
+    // Levels in a full chain down to 1x1, the most a file can sensibly list.
+    uint32_t maxLevelCount(const int width, const int height) {
+        uint32_t levels = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2) { ++levels; }
+        return levels;
+    }
+
+    // Whether [offset, offset + size) lies inside the file. Both come from the file, so the sum is never formed.
+    bool inFile(const FileData& file, const uint64_t offset, const uint64_t size) {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+
+    // Lays out a full mip chain starting at offset, the way DDS stores it.
+    bool layoutLevels(CompressedImage& image, size_t offset, const uint32_t levelCount) {
+        if (image.width <= 0 || image.height <= 0 || levelCount > maxLevelCount(image.width, image.height)) { return false; }
+
+        int width = image.width;
+        int height = image.height;
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            const size_t size = static_cast<size_t>(std::max(1, (width + 3) / 4)) * std::max(1, (height + 3) / 4) * blockBytes(image.internalFormat);
+            if (!inFile(image.file, offset, size)) { return false; }
+
+            image.levels.push_back({ offset, size, width, height });
+            offset += size;
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+
+    GLenum formatFromDxgi(const uint32_t dxgiFormat) {
+        switch (dxgiFormat) {
+            case 70: case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+            case 76: case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+            case 79: case 80: return GL_COMPRESSED_RED_RGTC1;
+            case 82: case 83: return GL_COMPRESSED_RG_RGTC2;
+            case 97: case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+            default: return 0;
+        }
+    }
+
+    GLenum formatFromFourCC(const uint32_t code) {
+        switch (code) {
+            case fourCC('D', 'X', 'T', '1'): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case fourCC('D', 'X', 'T', '5'): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case fourCC('A', 'T', 'I', '1'): case fourCC('B', 'C', '4', 'U'): return GL_COMPRESSED_RED_RGTC1;
+            case fourCC('A', 'T', 'I', '2'): case fourCC('B', 'C', '5', 'U'): return GL_COMPRESSED_RG_RGTC2;
+            default: return 0;
+        }
+    }
+
+    GLenum formatFromVk(const uint32_t vkFormat) {
+        switch (vkFormat) {
+            case 131: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case 132: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+            case 133: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            case 134: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+            case 137: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case 138: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+            case 139: return GL_COMPRESSED_RED_RGTC1;
+            case 141: return GL_COMPRESSED_RG_RGTC2;
+            case 145: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+            case 146: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+            default: return 0;
+        }
+    }
+
+    bool loadDds(CompressedImage& image) {
+        constexpr size_t HEADER_SIZE = 4 + 124;
+        constexpr size_t DX10_HEADER_SIZE = 20;
+        constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+        constexpr uint32_t DDPF_FOURCC = 0x4;
+
+        const FileData& file = image.file;
+        if (file.size() < HEADER_SIZE || readAt<uint32_t>(file, 4) != 124) { return false; }
+
+        const auto flags = readAt<uint32_t>(file, 8);
+        image.height = static_cast<int>(readAt<uint32_t>(file, 12));
+        image.width = static_cast<int>(readAt<uint32_t>(file, 16));
+        const auto mipCount = readAt<uint32_t>(file, 28);
+        const auto pixelFlags = readAt<uint32_t>(file, 80);
+        const auto code = readAt<uint32_t>(file, 84);
+
+        if (!(pixelFlags & DDPF_FOURCC)) {
+            std::cout << "ERROR::TEXTURE::DDS_NOT_BLOCK_COMPRESSED" << std::endl;
+            return false;
+        }
+
+        size_t offset = HEADER_SIZE;
+        if (code == fourCC('D', 'X', '1', '0')) {
+            if (file.size() < HEADER_SIZE + DX10_HEADER_SIZE) { return false; }
+            const auto dxgiFormat = readAt<uint32_t>(file, HEADER_SIZE);
+            const auto dimension = readAt<uint32_t>(file, HEADER_SIZE + 4);
+            const auto arraySize = readAt<uint32_t>(file, HEADER_SIZE + 12);
+            if (dimension != 3 || arraySize > 1) {
+                std::cout << "ERROR::TEXTURE::DDS_NOT_2D" << std::endl;
+                return false;
+            }
+            image.internalFormat = formatFromDxgi(dxgiFormat);
+            offset += DX10_HEADER_SIZE;
+        } else {
+            image.internalFormat = formatFromFourCC(code);
+        }
+
+        if (image.internalFormat == 0) {
+            std::cout << "ERROR::TEXTURE::UNSUPPORTED_FORMAT" << std::endl;
+            return false;
+        }
+
+        const uint32_t levels = (flags & DDSD_MIPMAPCOUNT) ? std::max(1u, mipCount) : 1u;
+        return layoutLevels(image, offset, levels);
+    }
+
+    bool loadKtx2(CompressedImage& image) {
+        constexpr size_t HEADER_SIZE = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+        constexpr size_t LEVEL_ENTRY_SIZE = 3 * 8;
+
+        const FileData& file = image.file;
+        if (file.size() < HEADER_SIZE) { return false; }
+
+        const auto vkFormat = readAt<uint32_t>(file, 12);
+        image.width = static_cast<int>(readAt<uint32_t>(file, 20));
+        image.height = static_cast<int>(readAt<uint32_t>(file, 24));
+        const auto depth = readAt<uint32_t>(file, 28);
+        const auto layers = readAt<uint32_t>(file, 32);
+        const auto faces = readAt<uint32_t>(file, 36);
+        const uint32_t levelCount = std::max(1u, readAt<uint32_t>(file, 40));
+        const auto supercompression = readAt<uint32_t>(file, 44);
+
+        if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0) {
+            std::cout << "ERROR::TEXTURE::KTX2_UNSUPPORTED_LAYOUT" << std::endl;
+            return false;
+        }
+
+        image.internalFormat = formatFromVk(vkFormat);
+        if (image.internalFormat == 0) {
+            std::cout << "ERROR::TEXTURE::UNSUPPORTED_FORMAT" << std::endl;
+            return false;
+        }
+        if (image.width <= 0 || image.height <= 0 || levelCount > maxLevelCount(image.width, image.height)) { return false; }
+        if (!inFile(file, HEADER_SIZE, static_cast<uint64_t>(levelCount) * LEVEL_ENTRY_SIZE)) { return false; }
+
+        int width = image.width;
+        int height = image.height;
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            const size_t entry = HEADER_SIZE + level * LEVEL_ENTRY_SIZE;
+            const auto offset = readAt<uint64_t>(file, entry);
+            const auto size = readAt<uint64_t>(file, entry + 8);
+            if (!inFile(file, offset, size)) { return false; }
+
+            image.levels.push_back({ static_cast<size_t>(offset), static_cast<size_t>(size), width, height });
+            width = std::max(1, width / 2);
+            height = std::max(1, height / 2);
+        }
+        return true;
+    }
+}
+
+bool isCompressedTexturePath(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+bool loadCompressedImage(FileData file, CompressedImage &image) {
+    static constexpr unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    image = {};
+    image.file = std::move(file);
+    if (!image.file) { return false; }
+
+    bool loaded = false;
+    if (image.file.size() >= 4 && std::memcmp(image.file.data(), "DDS ", 4) == 0) {
+        loaded = loadDds(image);
+    } else if (image.file.size() >= 12 && std::memcmp(image.file.data(), KTX2_IDENTIFIER, 12) == 0) {
+        loaded = loadKtx2(image);
+    } else {
+        std::cout << "ERROR::TEXTURE::UNKNOWN_CONTAINER" << std::endl;
+        return false;
+    }
+
+    if (!loaded || image.width <= 0 || image.height <= 0 || image.levels.empty()) {
+        if (loaded) { std::cout << "ERROR::TEXTURE::TRUNCATED" << std::endl; }
+        image.levels.clear();
+        return false;
+    }
+    return true;
+}
+
+bool isCompressedFormatSupported(const GLenum internalFormat) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+    switch (internalFormat) {
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+            return true; // Core since 3.0.
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return major > 4 || (major == 4 && minor >= 2) || hasGlExtension("GL_ARB_texture_compression_bptc");
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            return hasGlExtension("GL_EXT_texture_compression_s3tc")
+                && (hasGlExtension("GL_EXT_texture_sRGB") || hasGlExtension("GL_EXT_texture_compression_s3tc_srgb"));
+        default:
+            return hasGlExtension("GL_EXT_texture_compression_s3tc");
+    }
+}
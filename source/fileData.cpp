@@ -0,0 +1,212 @@
+#include "../headers/FileData.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FILEDATA_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Buffers handed back by closed FileData, reused by the next read that fits.
+    // Shared between the GL thread and the shader watcher thread, hence the lock.
+    class BufferPool {
+    public:
+        std::vector<char> acquire(const size_t size) {
+            std::lock_guard lock(m_mutex);
+
+            // Smallest free buffer that fits.
+            auto best = m_free.end();
+            for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+                if (it->capacity() >= size && (best == m_free.end() || it->capacity() < best->capacity())) {
+                    best = it;
+                }
+            }
+            if (best == m_free.end()) {
+                std::vector<char> buffer;
+                buffer.reserve(size);
+                return buffer;
+            }
+
+            std::vector<char> buffer = std::move(*best);
+            m_free.erase(best);
+            return buffer;
+        }
+
+        void release(std::vector<char>&& buffer) {
+            if (buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_SIZE) { return; }
+
+            std::lock_guard lock(m_mutex);
+            if (m_free.size() >= MAX_POOLED_BUFFERS) {
+                // Drop the smallest, big buffers are the expensive ones to reallocate.
+                const auto smallest = std::min_element(m_free.begin(), m_free.end(), [](const auto& a, const auto& b) {
+                    return a.capacity() < b.capacity();
+                });
+                if (smallest->capacity() >= buffer.capacity()) { return; }
+                m_free.erase(smallest);
+            }
+            buffer.clear();
+            m_free.push_back(std::move(buffer));
+        }
+
+    private:
+        static constexpr size_t MAX_POOLED_BUFFERS = 16;
+        static constexpr size_t MAX_POOLED_SIZE = 16 * 1024 * 1024;
+
+        std::mutex m_mutex;
+        std::vector<std::vector<char>> m_free;
+    };
+
+    BufferPool& bufferPool() {
+        static BufferPool pool;
+        return pool;
+    }
+}
+
+FileData::~FileData() {
+    _release();
+}
+
+FileData::FileData(FileData &&other) noexcept {
+    *this = std::move(other);
+}
+
+FileData& FileData::operator=(FileData &&other) noexcept {
+    if (this != &other) {
+        _release();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_valid = other.m_valid;
+        m_mapped = other.m_mapped;
+        m_buffer = std::move(other.m_buffer);
+
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_valid = false;
+        other.m_mapped = false;
+    }
+    return *this;
+}
+
+FileData FileData::open(const std::filesystem::path &path) {
+    FileData file;
+
+#ifdef FILEDATA_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cout << "ERROR::FILE::NOT_READ " << path.string() << std::endl;
+        return file;
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(fd);
+        std::cout << "ERROR::FILE::NOT_READ " << path.string() << std::endl;
+        return file;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+
+    if (size >= MAP_THRESHOLD) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            close(fd);
+            file.m_data = static_cast<const char*>(mapping);
+            file.m_size = size;
+            file.m_valid = true;
+            file.m_mapped = true;
+            return file;
+        }
+        // Fall through and read it instead.
+    }
+
+    file.m_buffer = bufferPool().acquire(size);
+    file.m_buffer.resize(size);
+
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t got = read(fd, file.m_buffer.data() + done, size - done);
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) { continue; }
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+    close(fd);
+
+    // A file that shrank between fstat and read just comes back shorter.
+    file.m_buffer.resize(done);
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        std::cout << "ERROR::FILE::NOT_READ " << path.string() << std::endl;
+        return file;
+    }
+
+    const auto size = static_cast<size_t>(stream.tellg());
+    stream.seekg(0);
+
+    file.m_buffer = bufferPool().acquire(size);
+    file.m_buffer.resize(size);
+    stream.read(file.m_buffer.data(), static_cast<std::streamsize>(size));
+    file.m_buffer.resize(static_cast<size_t>(stream.gcount()));
+#endif
+
+    file.m_data = file.m_buffer.data();
+    file.m_size = file.m_buffer.size();
+    file.m_valid = true;
+    return file;
+}
+
+void FileData::prefetch() const {
+#ifdef FILEDATA_MMAP
+    if (m_mapped) {
+        madvise(const_cast<char*>(m_data), m_size, MADV_WILLNEED);
+    }
+#endif
+}
+
+// Multiply xor over eight bytes at a time, plenty to tell files apart.
+uint64_t FileData::hash() const {
+    if (!m_valid) { return 0; }
+
+    constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = m_size * PRIME;
+
+    const unsigned char* data = bytes();
+    size_t i = 0;
+    for (; i + 8 <= m_size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * PRIME;
+        hash ^= hash >> 29;
+    }
+    for (; i < m_size; ++i) {
+        hash = (hash ^ data[i]) * PRIME;
+    }
+    return hash ^ (hash >> 32);
+}
+
+void FileData::_release() {
+#ifdef FILEDATA_MMAP
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    if (m_buffer.capacity() > 0) {
+        bufferPool().release(std::move(m_buffer));
+        m_buffer = {};
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_valid = false;
+    m_mapped = false;
+}
@@ -0,0 +1,308 @@
+#include "../headers/GeometryHeap.h"
+
+#include <algorithm>
+
+namespace {
+    // Copies size bytes of a buffer into a new one of newSize, and deletes the old one.
+    GLuint regrowBuffer(const GLuint buffer, const size_t size, const size_t newSize) {
+        GLuint grown;
+        glGenBuffers(1, &grown);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newSize), nullptr, GL_STATIC_DRAW);
+        if (buffer != 0 && size > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(size));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        if (buffer != 0) {
+            glDeleteBuffers(1, &buffer);
+        }
+        return grown;
+    }
+
+    void upload(const GLuint buffer, const size_t offset, const void* data, const size_t size) {
+        if (size == 0) { return; }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+// ---- FreeListAllocator ----
+
+FreeListAllocator::FreeListAllocator(const size_t capacity) {
+    grow(capacity);
+}
+
+size_t FreeListAllocator::allocate(const size_t size) {
+    if (size == 0) { return INVALID; }
+
+    const auto fit = m_bySize.lower_bound({ size, 0 });
+    if (fit == m_bySize.end()) { return INVALID; }
+
+    const size_t offset = fit->second;
+    allocateAt(offset, size);
+    return offset;
+}
+
+void FreeListAllocator::allocateAt(const size_t offset, const size_t size) {
+    auto block = m_byOffset.upper_bound(offset);
+    if (block == m_byOffset.begin()) { return; }
+    --block;
+
+    const size_t blockOffset = block->first;
+    const size_t blockSize = block->second;
+    if (offset + size > blockOffset + blockSize) { return; }
+
+    _erase(block);
+    if (offset > blockOffset) { _insert(blockOffset, offset - blockOffset); }
+    if (offset + size < blockOffset + blockSize) { _insert(offset + size, blockOffset + blockSize - offset - size); }
+    m_used += size;
+}
+
+void FreeListAllocator::free(size_t offset, size_t size) {
+    if (size == 0) { return; }
+    m_used -= size;
+
+    // Merge with the free blocks on either side.
+    auto next = m_byOffset.lower_bound(offset);
+    if (next != m_byOffset.begin()) {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            _erase(previous);
+        }
+    }
+    if (next != m_byOffset.end() && offset + size == next->first) {
+        size += next->second;
+        _erase(next);
+    }
+    _insert(offset, size);
+}
+
+void FreeListAllocator::grow(const size_t newCapacity) {
+    if (newCapacity <= m_capacity) { return; }
+    const size_t added = newCapacity - m_capacity;
+    const size_t offset = m_capacity;
+    m_capacity = newCapacity;
+    // Counted as used for a moment so free() can merge it like any other block.
+    m_used += added;
+    free(offset, added);
+}
+
+void FreeListAllocator::_insert(const size_t offset, const size_t size) {
+    m_byOffset.emplace(offset, size);
+    m_bySize.emplace(size, offset);
+}
+
+void FreeListAllocator::_erase(const std::map<size_t, size_t>::iterator block) {
+    m_bySize.erase({ block->second, block->first });
+    m_byOffset.erase(block);
+}
+
+// ---- GeometryHeap ----
+
+GeometryHeap::Handle GeometryHeap::allocate(const VertexLayout &layout, const std::array<std::vector<unsigned char>, VertexLayout::MAX_STREAMS> &streams,
+                                            const size_t vertexCount, const std::vector<unsigned char> &indices) {
+    const uint32_t poolIndex = _poolFor(layout);
+    Pool& pool = m_pools[poolIndex];
+    Allocation allocation = { poolIndex, 0, vertexCount, 0, (indices.size() + 3) / 4 };
+
+    if (vertexCount > 0) {
+        allocation.vertexOffset = pool.vertices.allocate(vertexCount);
+        if (allocation.vertexOffset == FreeListAllocator::INVALID) {
+            _growVertices(pool, vertexCount);
+            allocation.vertexOffset = pool.vertices.allocate(vertexCount);
+        }
+    }
+    if (allocation.indexWords > 0) {
+        allocation.indexOffset = pool.indices.allocate(allocation.indexWords);
+        if (allocation.indexOffset == FreeListAllocator::INVALID) {
+            _growIndices(pool, allocation.indexWords);
+            allocation.indexOffset = pool.indices.allocate(allocation.indexWords);
+        }
+    }
+
+    for (uint32_t stream = 0; stream < layout.getStreamCount(); ++stream) {
+        upload(pool.vertexBuffers[stream], allocation.vertexOffset * layout.getStride(stream), streams[stream].data(), vertexCount * layout.getStride(stream));
+    }
+    upload(pool.indexBuffer, allocation.indexOffset * 4, indices.data(), indices.size());
+
+    Handle handle;
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+        m_allocations[handle] = allocation;
+    } else {
+        handle = static_cast<Handle>(m_allocations.size());
+        m_allocations.push_back(allocation);
+    }
+    if (vertexCount > 0) { pool.vertexOwners.emplace(allocation.vertexOffset, handle); }
+    if (allocation.indexWords > 0) { pool.indexOwners.emplace(allocation.indexOffset, handle); }
+    return handle;
+}
+
+void GeometryHeap::free(const Handle handle) {
+    // Handles from before destroy() are gone along with the buffers.
+    if (handle >= m_allocations.size()) { return; }
+
+    const Allocation& allocation = m_allocations[handle];
+    Pool& pool = m_pools[allocation.pool];
+    if (allocation.vertexCount > 0) {
+        pool.vertices.free(allocation.vertexOffset, allocation.vertexCount);
+        pool.vertexOwners.erase(allocation.vertexOffset);
+    }
+    if (allocation.indexWords > 0) {
+        pool.indices.free(allocation.indexOffset, allocation.indexWords);
+        pool.indexOwners.erase(allocation.indexOffset);
+    }
+    m_freeHandles.push_back(handle);
+}
+
+GLuint GeometryHeap::getVertexArray(const Handle handle, const bool positionsOnly) const {
+    const Pool& pool = m_pools[m_allocations[handle].pool];
+    return m_vertexArrays.get(positionsOnly ? pool.positionLayout : pool.layout, pool.vertexBuffers.data(), pool.indexBuffer);
+}
+
+size_t GeometryHeap::defragment(const size_t budgetBytes) {
+    size_t moved = 0;
+    for (Pool& pool : m_pools) {
+        if (moved >= budgetBytes) { break; }
+        moved += _compact(pool.vertices, pool.vertexOwners, &Allocation::vertexOffset, &Allocation::vertexCount, pool.layout.getVertexSize(), budgetBytes - moved,
+                          [&](const size_t from, const size_t to, const size_t count) {
+                              for (uint32_t stream = 0; stream < pool.layout.getStreamCount(); ++stream) {
+                                  const size_t stride = pool.layout.getStride(stream);
+                                  _moveWithin(pool.vertexBuffers[stream], from * stride, to * stride, count * stride);
+                              }
+                          });
+        if (moved >= budgetBytes) { break; }
+        moved += _compact(pool.indices, pool.indexOwners, &Allocation::indexOffset, &Allocation::indexWords, 4, budgetBytes - moved,
+                          [&](const size_t from, const size_t to, const size_t count) {
+                              _moveWithin(pool.indexBuffer, from * 4, to * 4, count * 4);
+                          });
+    }
+    m_bytesMoved += moved;
+    return moved;
+}
+
+GeometryHeap::Stats GeometryHeap::getStats() const {
+    Stats stats;
+    stats.pools = m_pools.size();
+    stats.allocations = m_allocations.size() - m_freeHandles.size();
+    stats.bytesMoved = m_bytesMoved;
+    for (const Pool& pool : m_pools) {
+        stats.vertexBytes += pool.vertices.getCapacity() * pool.layout.getVertexSize();
+        stats.vertexBytesUsed += pool.vertices.getUsed() * pool.layout.getVertexSize();
+        stats.indexBytes += pool.indices.getCapacity() * 4;
+        stats.indexBytesUsed += pool.indices.getUsed() * 4;
+    }
+    return stats;
+}
+
+void GeometryHeap::destroy() {
+    for (Pool& pool : m_pools) {
+        for (uint32_t stream = 0; stream < pool.layout.getStreamCount(); ++stream) {
+            m_vertexArrays.release(pool.vertexBuffers[stream]);
+            glDeleteBuffers(1, &pool.vertexBuffers[stream]);
+        }
+        m_vertexArrays.release(pool.indexBuffer);
+        glDeleteBuffers(1, &pool.indexBuffer);
+    }
+    if (m_scratch != 0) {
+        glDeleteBuffers(1, &m_scratch);
+        m_scratch = 0;
+        m_scratchSize = 0;
+    }
+    m_pools.clear();
+    m_allocations.clear();
+    m_freeHandles.clear();
+}
+
+uint32_t GeometryHeap::_poolFor(const VertexLayout &layout) {
+    for (uint32_t i = 0; i < m_pools.size(); ++i) {
+        if (m_pools[i].layout == layout) { return i; }
+    }
+
+    Pool& pool = m_pools.emplace_back();
+    pool.layout = layout;
+    pool.positionLayout = layout.only({ VertexSemantic::Position });
+    _growVertices(pool, INITIAL_VERTICES);
+    _growIndices(pool, INITIAL_INDEX_BYTES / 4);
+    return static_cast<uint32_t>(m_pools.size() - 1);
+}
+
+void GeometryHeap::_growVertices(Pool &pool, const size_t minimum) {
+    const size_t capacity = pool.vertices.getCapacity();
+    const size_t newCapacity = std::max(capacity * 2, capacity + minimum);
+    for (uint32_t stream = 0; stream < pool.layout.getStreamCount(); ++stream) {
+        const size_t stride = pool.layout.getStride(stream);
+        // The VAOs over the old buffer go with it, the next draw builds one over the new buffer.
+        m_vertexArrays.release(pool.vertexBuffers[stream]);
+        pool.vertexBuffers[stream] = regrowBuffer(pool.vertexBuffers[stream], capacity * stride, newCapacity * stride);
+    }
+    pool.vertices.grow(newCapacity);
+}
+
+void GeometryHeap::_growIndices(Pool &pool, const size_t minimum) {
+    const size_t capacity = pool.indices.getCapacity();
+    const size_t newCapacity = std::max(capacity * 2, capacity + minimum);
+    m_vertexArrays.release(pool.indexBuffer);
+    pool.indexBuffer = regrowBuffer(pool.indexBuffer, capacity * 4, newCapacity * 4);
+    pool.indices.grow(newCapacity);
+}
+
+void GeometryHeap::_moveWithin(const GLuint buffer, const size_t from, const size_t to, const size_t size) {
+    if (size > m_scratchSize) {
+        if (m_scratch == 0) { glGenBuffers(1, &m_scratch); }
+        m_scratchSize = size;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_scratch);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(m_scratchSize), nullptr, GL_DYNAMIC_COPY);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_scratch);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(from), 0, static_cast<GLsizeiptr>(size));
+    glBindBuffer(GL_COPY_READ_BUFFER, m_scratch);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, static_cast<GLintptr>(to), static_cast<GLsizeiptr>(size));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+size_t GeometryHeap::_compact(FreeListAllocator &space, std::map<size_t, Handle> &owners, size_t Allocation::* const offset, size_t Allocation::* const count,
+                              const size_t unitBytes, const size_t budgetBytes, const std::function<void(size_t from, size_t to, size_t count)> &move) {
+    size_t moved = 0;
+    size_t searchFrom = 0;
+    while (moved < budgetBytes) {
+        // The next hole, and whatever sits right above it. Free blocks are always merged, so nothing above a hole
+        // means it runs to the end and everything before it is packed.
+        const auto hole = space.getFreeBlocks().lower_bound(searchFrom);
+        if (hole == space.getFreeBlocks().end()) { break; }
+        const size_t holeOffset = hole->first;
+        const size_t holeEnd = hole->first + hole->second;
+        const auto owner = owners.find(holeEnd);
+        if (owner == owners.end()) { break; }
+
+        const Handle handle = owner->second;
+        Allocation& allocation = m_allocations[handle];
+        const size_t bytes = allocation.*count * unitBytes;
+        if (bytes > budgetBytes - moved) {
+            // Too big for what's left this time, try the hole above it.
+            searchFrom = holeEnd + allocation.*count;
+            continue;
+        }
+
+        move(allocation.*offset, holeOffset, allocation.*count);
+        space.free(allocation.*offset, allocation.*count);
+        space.allocateAt(holeOffset, allocation.*count);
+        owners.erase(owner);
+        owners.emplace(holeOffset, handle);
+        allocation.*offset = holeOffset;
+        moved += bytes;
+        // The hole now starts just above the allocation, merged with whatever was free above that.
+        searchFrom = holeOffset;
+    }
+    return moved;
+}
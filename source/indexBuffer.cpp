@@ -0,0 +1,80 @@
+#include "../headers/IndexBuffer.h"
+
+#include <cstdint>
+
+namespace {
+    template <typename T>
+    void writeIndices(const std::vector<unsigned int>& indices, std::vector<unsigned char>& data) {
+        data.resize(indices.size() * sizeof(T));
+        T* out = reinterpret_cast<T*>(data.data());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            out[i] = static_cast<T>(indices[i]);
+        }
+    }
+
+    PackedIndexBuffer packWhole(const std::vector<unsigned int>& indices, const bool shortIndices) {
+        PackedIndexBuffer packed;
+        packed.type = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        if (shortIndices) {
+            writeIndices<uint16_t>(indices, packed.data);
+        } else {
+            writeIndices<uint32_t>(indices, packed.data);
+        }
+        packed.ranges.push_back({ 0, indices.size(), 0 });
+        return packed;
+    }
+}
+
+PackedIndexBuffer packIndexBuffer(const std::vector<unsigned int> &indices, const size_t vertexCount, const size_t vertexSize) {
+    if (vertexCount <= MAX_SHORT_INDEX_VERTICES) {
+        return packWhole(indices, true);
+    }
+
+    // Ranges take triangles in order, which keeps whatever vertex cache order the indices already have. Each range
+    // numbers its vertices by first use, so they are also fetched in order.
+    constexpr unsigned int UNSEEN = ~0u;
+    std::vector<unsigned int> localIndex(vertexCount, UNSEEN);
+    std::vector<unsigned int> rangeOf(vertexCount, UNSEEN);
+    std::vector<unsigned int> localIndices(indices.size());
+    PackedIndexBuffer packed;
+    packed.type = GL_UNSIGNED_SHORT;
+
+    size_t rangeStart = 0;
+    size_t rangeVertices = 0;
+    for (size_t triangle = 0; triangle * 3 + 2 < indices.size(); ++triangle) {
+        const unsigned int range = static_cast<unsigned int>(packed.ranges.size());
+        size_t added = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            added += rangeOf[indices[triangle * 3 + corner]] != range;
+        }
+
+        if (rangeVertices + added > MAX_SHORT_INDEX_VERTICES) {
+            packed.ranges.push_back({ rangeStart, triangle * 3 - rangeStart, static_cast<GLint>(packed.vertexRemap.size() - rangeVertices) });
+            rangeStart = triangle * 3;
+            rangeVertices = 0;
+        }
+
+        const unsigned int current = static_cast<unsigned int>(packed.ranges.size());
+        for (int corner = 0; corner < 3; ++corner) {
+            const unsigned int vertex = indices[triangle * 3 + corner];
+            if (rangeOf[vertex] != current) {
+                rangeOf[vertex] = current;
+                localIndex[vertex] = static_cast<unsigned int>(rangeVertices++);
+                packed.vertexRemap.push_back(vertex);
+            }
+            localIndices[triangle * 3 + corner] = localIndex[vertex];
+        }
+    }
+    const size_t triangleIndices = indices.size() / 3 * 3;
+    packed.ranges.push_back({ rangeStart, triangleIndices - rangeStart, static_cast<GLint>(packed.vertexRemap.size() - rangeVertices) });
+
+    const size_t splitBytes = triangleIndices * 2 + packed.vertexRemap.size() * vertexSize;
+    const size_t wholeBytes = indices.size() * 4 + vertexCount * vertexSize;
+    if (splitBytes >= wholeBytes) {
+        return packWhole(indices, false);
+    }
+
+    localIndices.resize(triangleIndices);
+    writeIndices<uint16_t>(localIndices, packed.data);
+    return packed;
+}
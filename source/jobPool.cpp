@@ -0,0 +1,101 @@
+#include "../headers/JobPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+JobPool::JobPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&JobPool::_work, this);
+    }
+}
+
+JobPool::~JobPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+        m_jobs.clear();
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void JobPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_stopping) { return; }
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+}
+
+void JobPool::parallelFor(const size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body) {
+    grain = std::max<size_t>(1, grain);
+    const size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 0) { return; }
+    if (chunks == 1) {
+        body(0, count);
+        return;
+    }
+
+    // Helpers can start after every chunk is claimed and the caller has returned, so the shared state outlives the
+    // call. They only touch body once they have claimed a chunk, which can't happen after that point.
+    struct State {
+        const std::function<void(size_t, size_t)>* body;
+        size_t count;
+        size_t grain;
+        size_t chunks;
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> finished = 0;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    const auto state = std::make_shared<State>();
+    state->body = &body;
+    state->count = count;
+    state->grain = grain;
+    state->chunks = chunks;
+
+    const auto run = [](State& shared) {
+        for (size_t chunk = shared.next++; chunk < shared.chunks; chunk = shared.next++) {
+            const size_t begin = chunk * shared.grain;
+            (*shared.body)(begin, std::min(shared.count, begin + shared.grain));
+
+            if (++shared.finished == shared.chunks) {
+                std::lock_guard lock(shared.mutex);
+                shared.done.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min<size_t>(m_threads.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([state, run] { run(*state); });
+    }
+    run(*state);
+
+    std::unique_lock lock(state->mutex);
+    state->done.wait(lock, [&] { return state->finished == state->chunks; });
+}
+
+void JobPool::_work() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            if (m_stopping) { return; }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
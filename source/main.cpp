@@ -12,11 +12,19 @@
 #include "../headers/Camera.h"
 #include "../headers/Mesh.h"
 #include "../headers/Object3d.h"
+#include "../headers/ProgramBinaryCache.h"
 #include "../headers/RenderAPI.h"
 #include "../headers/Shader.h"
+#include "../headers/ShaderBuildQueue.h"
 #include "../headers/ShaderManager.h"
+#include "../headers/ShaderPermutationCache.h"
+#include "../headers/ShaderWatcher.h"
 #include "../headers/Window.h"
 #include "../headers/Texture.h"
+#include "../headers/TextureCache.h"
+#include "../headers/TextureLoader.h"
+#include "../headers/TexturePack.h"
+#include "../headers/TextureStreamer.h"
 
 constexpr int windowWidth = 1200;
 constexpr int windowHeight = 800;
@@ -43,12 +51,24 @@ int main() {
 	api->init();
 
 	ShaderManager shaderManager;
+	ProgramBinaryCache shaderCache("shader_cache");
+	ShaderBuildQueue shaderQueue(reinterpret_cast<GLADloadproc>(glfwGetProcAddress), &shaderCache);
+	shaderQueue.getPreprocessor().addIncludeDirectory("../shaders/include");
 
-    Shader ourShader("../shaders/vertex.vs", "../shaders/fragment.fs");
-	Shader testShader("../shaders/vertex.vs", "../Shaders/fragment2.fs");
+	// Saving a watched shader file or one of its includes rebuilds just the shaders using it, no restart needed.
+	ShaderWatcher shaderWatcher(shaderQueue);
 
-	shaderManager.registerShader(&testShader);
-	shaderManager.registerShader(&ourShader);
+	// Every variant in the manifest compiles in the background, objects draw with the fallback program until they're ready.
+	ShaderPermutationCache shaderVariants(shaderQueue, &shaderWatcher);
+	shaderVariants.prewarm("../shaders/permutations.manifest");
+
+	// Loaded textures are sampled through bindless handles where the driver allows, streamed ones stay on units.
+	const bool bindlessTextures = api->setBindlessTextures(true);
+	const std::shared_ptr<Shader> ourShader = shaderVariants.get("textured", bindlessTextures ? shaderVariants.maskFor("textured", {"BINDLESS"}) : 0);
+	const std::shared_ptr<Shader> testShader = shaderVariants.get("light", 0);
+
+	shaderManager.registerShader(testShader.get());
+	shaderManager.registerShader(ourShader.get());
 
 	Mesh* cubeMesh = new Mesh();
 	cubeMesh->vertices = {
@@ -103,24 +123,49 @@ int main() {
 		20,21,22, 22,23,20
 	};
 
-	cubeMesh->gpuBuffer = api->CreateGpuBuffer(cubeMesh->vertices, cubeMesh->indices);
+	// Half float positions and 16 bit texture coordinates are exact for the cube, and positions get a stream of their own.
+	cubeMesh->layout = VertexLayout::compact();
+	cubeMesh->gpuBuffer = api->CreateGpuBuffer(cubeMesh->vertices, cubeMesh->indices, cubeMesh->layout);
 
 	Object3D cube = Object3D(cubeMesh);
 	Object3D lightCube = Object3D(cubeMesh);
 
-    Texture texture1("../assets/serble_logo.png", GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, true);
-    Texture texture2("../assets/aXR5PTgw.png", GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, true);
+    // Decoded on worker threads and uploaded a little each frame, the cube shows a placeholder until then.
+    // Mip chains are built on the CPU and kept on disk, so later runs skip decoding. Only the mips the cube is drawn
+    // at are kept in VRAM, within the streamer's budget. Objects asking for the same image share one texture.
+    MipCache mipCache("texture_cache");
+    TextureLoader textureLoader(&mipCache);
+    TextureStreamer textureStreamer(textureLoader, 128 * 1024 * 1024);
+    TextureCache textureCache(textureStreamer);
+
+    // Textures cooked with the pack_textures target upload straight from the mapped pack, anything not in it is loaded
+    // from assets/ as before.
+    auto texturePack = std::make_shared<TexturePack>();
+    if (!std::filesystem::exists("textures.pack") || !TexturePack::load("textures.pack", *texturePack)) {
+        texturePack.reset();
+    }
+    const auto loadTexture = [&](const std::string& name, const GLint internalFormat, const GLenum format) {
+        if (texturePack && texturePack->find(name)) {
+            return textureLoader.load(texturePack, name);
+        }
+        return textureCache.get("../assets/" + name, internalFormat, format, GL_UNSIGNED_BYTE, true);
+    };
 
-	cube.textures.push_back(&texture1);
-	cube.textures.push_back(&texture2);
+	cube.textures.push_back(loadTexture("serble_logo.png", GL_RGB, GL_RGB));
+	cube.textures.push_back(loadTexture("aXR5PTgw.png", GL_RGBA, GL_RGBA));
 
-	cube.shader = &ourShader;
-	lightCube.shader = &testShader;
+	cube.shader = ourShader.get();
+	lightCube.shader = testShader.get();
 
 	api->registerObject(&cube);
 	api->registerObject(&lightCube);
 
 	while(!window->shouldWindowClose()) {
+		shaderWatcher.applyPendingReloads();
+		shaderQueue.poll();
+		textureLoader.update();
+		textureCache.collect();
+
 		api->startDrawing();
 		api->setClearColour(0.11f, 0.11f, 0.12f, 1.0f);
 
@@ -135,13 +180,21 @@ int main() {
         glm::mat4 view = camera.GetViewMatrix();
 		shaderManager.injectGlobals(view, projection);
 
+		textureStreamer.requestObject(cube, view, projection, static_cast<float>(windowHeight));
+		textureStreamer.update();
+
 		cube.rotation = {0, (glfwGetTime() * 5.0f) * 50.0f, 0};
 		lightCube.position = {-2, 0, 0};
 
+		// Main pass, every texture gets anisotropic filtering on top of its object's sampler.
+		api->setSamplerOverride(SamplerOverride::anisotropic(8.0f));
 		api->drawRegisteredObjects();
 		api->endDrawing(window);
     }
 
+    // GPU objects go while the context is still alive, the mesh's buffer first since it lives in the API's heap.
+    cubeMesh->gpuBuffer.reset();
+    api->shutdown();
     glfwTerminate();
     return 0;
 }
@@ -152,7 +205,9 @@ void countFrames() {
 	frames++;
 
 	if (const double time = glfwGetTime(); time - prevTime >= 1.0) {
-		std::cout << "FPS: " << frames << "\n";
+		const UniformStats& uniformStats = UniformShadow::getTotalStats();
+		std::cout << "FPS: " << frames << " | uniform uploads: " << uniformStats.misses << " sent, " << uniformStats.hits << " skipped\n";
+		UniformShadow::resetTotalStats();
 		frames = 0;
 		prevTime = time;
 	}
@@ -0,0 +1,908 @@
+#include "../headers/MeshImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string_view>
+
+namespace {
+    // Enough work for a chunk to be worth handing to another thread.
+    constexpr size_t OBJ_CHUNK_BYTES = 1024 * 1024;
+    constexpr size_t CORNER_GRAIN = 64 * 1024;
+    // Accessors are bounded by the file, but instancing can repeat them. Past this many corners a glTF scene is
+    // refused rather than allocated.
+    constexpr size_t MAX_GLTF_CORNERS = static_cast<size_t>(1) << 28;
+    // Nodes can list the same child more than once, so a small file can describe a huge scene. The walk stops after
+    // visiting this many nodes and primitives.
+    constexpr size_t MAX_GLTF_INSTANCES = static_cast<size_t>(1) << 20;
+
+    void forRanges(JobPool* pool, const size_t count, const size_t grain, const std::function<void(size_t, size_t)>& body) {
+        if (pool) {
+            pool->parallelFor(count, grain, body);
+        } else {
+            body(0, count);
+        }
+    }
+
+    // ---- Vertex dedupe ----
+
+    uint64_t hashVertex(const Vertex& vertex) {
+        uint32_t bits[5];
+        std::memcpy(&bits[0], &vertex.position, sizeof(vertex.position));
+        std::memcpy(&bits[3], &vertex.texCoord, sizeof(vertex.texCoord));
+
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const uint32_t value : bits) {
+            hash = (hash ^ value) * 0x100000001B3ull;
+        }
+        return hash ^ hash >> 29;
+    }
+
+    bool sameVertex(const Vertex& a, const Vertex& b) {
+        return std::memcmp(&a.position, &b.position, sizeof(a.position)) == 0 && std::memcmp(&a.texCoord, &b.texCoord, sizeof(a.texCoord)) == 0;
+    }
+
+    // Open addressed set of vertices stored in a separate array, so a lookup never allocates. Grows as it fills.
+    class VertexTable {
+    public:
+        explicit VertexTable(const size_t expected) { _resize(expected * 2); }
+
+        // Index of vertex in vertices, appended if it isn't there yet. Vertices must only grow through here.
+        uint32_t insert(const Vertex& vertex, std::vector<Vertex>& vertices) {
+            for (size_t slot = hashVertex(vertex) & m_mask;; slot = (slot + 1) & m_mask) {
+                const uint32_t index = m_slots[slot];
+                if (index == EMPTY) {
+                    m_slots[slot] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                    // Kept at most half full, so probes stay short.
+                    if (vertices.size() * 2 > m_slots.size()) {
+                        _resize(m_slots.size() * 2);
+                        _rehash(vertices);
+                    }
+                    return static_cast<uint32_t>(vertices.size() - 1);
+                }
+                if (sameVertex(vertices[index], vertex)) { return index; }
+            }
+        }
+
+    private:
+        static constexpr uint32_t EMPTY = ~0u;
+        std::vector<uint32_t> m_slots;
+        size_t m_mask = 0;
+
+        void _resize(const size_t minimum) {
+            size_t capacity = 16;
+            while (capacity < minimum) { capacity *= 2; }
+            m_slots.assign(capacity, EMPTY);
+            m_mask = capacity - 1;
+        }
+
+        void _rehash(const std::vector<Vertex>& vertices) {
+            for (uint32_t index = 0; index < vertices.size(); ++index) {
+                size_t slot = hashVertex(vertices[index]) & m_mask;
+                while (m_slots[slot] != EMPTY) { slot = (slot + 1) & m_mask; }
+                m_slots[slot] = index;
+            }
+        }
+    };
+
+    // Turns one vertex per triangle corner into an indexed mesh. Each chunk of corners is deduped on its own in
+    // parallel, then only the chunks' unique vertices are merged on one thread, and the indices remapped in parallel.
+    void buildIndexedMesh(const std::vector<Vertex>& corners, Mesh& mesh, JobPool* pool) {
+        const size_t chunkCount = pool ? std::max<size_t>(1, std::min<size_t>(pool->getThreadCount() * 4, corners.size() / CORNER_GRAIN)) : 1;
+        std::vector<std::vector<Vertex>> chunkVertices(chunkCount);
+        std::vector<unsigned int> indices(corners.size());
+
+        const auto chunkBegin = [&](const size_t chunk) { return corners.size() * chunk / chunkCount; };
+        forRanges(pool, chunkCount, 1, [&](const size_t begin, const size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                const size_t first = chunkBegin(chunk), last = chunkBegin(chunk + 1);
+                // Closed meshes share each vertex between about six corners, the table grows if that's too few.
+                VertexTable table((last - first) / 6);
+                for (size_t i = first; i < last; ++i) {
+                    indices[i] = table.insert(corners[i], chunkVertices[chunk]);
+                }
+            }
+        });
+
+        size_t uniqueCount = 0;
+        for (const std::vector<Vertex>& vertices : chunkVertices) { uniqueCount += vertices.size(); }
+
+        std::vector<Vertex> vertices;
+        vertices.reserve(uniqueCount);
+        VertexTable table(uniqueCount);
+        std::vector<std::vector<uint32_t>> remap(chunkCount);
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            remap[chunk].reserve(chunkVertices[chunk].size());
+            for (const Vertex& vertex : chunkVertices[chunk]) {
+                remap[chunk].push_back(table.insert(vertex, vertices));
+            }
+        }
+
+        forRanges(pool, chunkCount, 1, [&](const size_t begin, const size_t end) {
+            for (size_t chunk = begin; chunk < end; ++chunk) {
+                for (size_t i = chunkBegin(chunk), last = chunkBegin(chunk + 1); i < last; ++i) {
+                    indices[i] = remap[chunk][indices[i]];
+                }
+            }
+        });
+
+        mesh.vertices = std::move(vertices);
+        mesh.indices = std::move(indices);
+    }
+
+    // ---- OBJ ----
+
+    const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) { ++p; }
+        return p;
+    }
+
+    template <typename T>
+    bool parseNumber(const char*& p, const char* end, T& value) {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+') { ++p; }
+        const auto [next, error] = std::from_chars(p, end, value);
+        if (error != std::errc()) { return false; }
+        p = next;
+        return true;
+    }
+
+    enum class ObjLine { Other, Position, TexCoord, Face };
+
+    // Works out what a line holds and moves p past the keyword.
+    ObjLine classify(const char*& p, const char* end) {
+        p = skipSpaces(p, end);
+        if (end - p < 2) { return ObjLine::Other; }
+
+        const auto keyword = [&](const std::string_view name) {
+            if (static_cast<size_t>(end - p) <= name.size() || std::string_view(p, name.size()) != name) { return false; }
+            if (p[name.size()] != ' ' && p[name.size()] != '\t') { return false; }
+            p += name.size();
+            return true;
+        };
+        if (keyword("v")) { return ObjLine::Position; }
+        if (keyword("vt")) { return ObjLine::TexCoord; }
+        if (keyword("f")) { return ObjLine::Face; }
+        return ObjLine::Other;
+    }
+
+    const char* lineEnd(const char* p, const char* end) {
+        const void* newline = std::memchr(p, '\n', end - p);
+        return newline ? static_cast<const char*>(newline) : end;
+    }
+
+    // One slice of the file, always starting at the beginning of a line.
+    struct ObjChunk {
+        const char* begin;
+        const char* end;
+        size_t positions = 0;
+        size_t texCoords = 0;
+        size_t triangles = 0;
+    };
+
+    // Where a triangle corner reads from, as 0 based indices into the whole file's arrays. -1 for no texture coordinate.
+    struct ObjCorner {
+        int64_t position;
+        int64_t texCoord;
+    };
+
+    int cornersOnLine(const char* p, const char* end) {
+        int corners = 0;
+        while (true) {
+            p = skipSpaces(p, end);
+            if (p >= end || *p == '\r' || *p == '#') { return corners; }
+            ++corners;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r') { ++p; }
+        }
+    }
+
+    // OBJ indices count from 1, negative ones count back from the last element read so far.
+    int64_t resolveIndex(const int64_t index, const size_t countSoFar) {
+        return index > 0 ? index - 1 : static_cast<int64_t>(countSoFar) + index;
+    }
+
+    bool parseCorner(const char*& p, const char* end, const ObjChunk& chunk, const size_t positions, const size_t texCoords, ObjCorner& corner) {
+        int64_t position;
+        if (!parseNumber(p, end, position)) { return false; }
+        corner = { resolveIndex(position, chunk.positions + positions), -1 };
+
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                int64_t texCoord;
+                if (!parseNumber(p, end, texCoord)) { return false; }
+                corner.texCoord = resolveIndex(texCoord, chunk.texCoords + texCoords);
+            }
+            // Normal indices are skipped.
+            if (p < end && *p == '/') {
+                ++p;
+                int64_t normal;
+                if (p < end && *p != ' ' && *p != '\t' && *p != '\r' && !parseNumber(p, end, normal)) { return false; }
+            }
+        }
+        return true;
+    }
+
+    // Chunk positions and counts hold where its elements start in the whole file's arrays by the time this runs.
+    bool parseObjChunk(const ObjChunk& chunk, std::vector<glm::vec3>& positions, std::vector<glm::vec2>& texCoords, std::vector<ObjCorner>& corners) {
+        size_t positionCount = 0, texCoordCount = 0;
+        size_t corner = chunk.triangles * 3;
+
+        for (const char* line = chunk.begin; line < chunk.end;) {
+            const char* end = lineEnd(line, chunk.end);
+            const char* p = line;
+            line = end + 1;
+
+            switch (classify(p, end)) {
+                case ObjLine::Position: {
+                    glm::vec3& position = positions[chunk.positions + positionCount++];
+                    if (!parseNumber(p, end, position.x) || !parseNumber(p, end, position.y) || !parseNumber(p, end, position.z)) { return false; }
+                    break;
+                }
+                case ObjLine::TexCoord: {
+                    glm::vec2& texCoord = texCoords[chunk.texCoords + texCoordCount++];
+                    // The second coordinate is optional.
+                    if (!parseNumber(p, end, texCoord.x)) { return false; }
+                    if (!parseNumber(p, end, texCoord.y)) { texCoord.y = 0.0f; }
+                    break;
+                }
+                case ObjLine::Face: {
+                    ObjCorner first{}, previous{}, current{};
+                    const int count = cornersOnLine(p, end);
+                    for (int i = 0; i < count; ++i) {
+                        if (!parseCorner(p, end, chunk, positionCount, texCoordCount, current)) { return false; }
+                        if (i == 0) { first = current; }
+                        if (i >= 2) {
+                            corners[corner++] = first;
+                            corners[corner++] = previous;
+                            corners[corner++] = current;
+                        }
+                        previous = current;
+                    }
+                    break;
+                }
+                case ObjLine::Other:
+                    break;
+            }
+        }
+        return true;
+    }
+
+    // ---- JSON, for the glTF header ----
+
+    // Flat tree of values pointing into the source text. Strings are left escaped, which is fine for glTF's own names.
+    struct JsonValue {
+        enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+        static constexpr uint32_t NONE = ~0u;
+
+        Type type = Type::Null;
+        std::string_view key;
+        std::string_view text;
+        double number = 0.0;
+        uint32_t firstChild = NONE;
+        uint32_t nextSibling = NONE;
+    };
+
+    class JsonDocument {
+    public:
+        bool parse(const std::string_view text) {
+            m_text = text;
+            m_position = 0;
+            m_values.clear();
+            m_values.reserve(text.size() / 8);
+            return _parseValue(0) != JsonValue::NONE && (_skipSpaces(), m_position == m_text.size());
+        }
+
+        [[nodiscard]] const JsonValue& root() const { return m_values[0]; }
+
+        [[nodiscard]] const JsonValue* find(const JsonValue* object, const std::string_view key) const {
+            if (!object || object->type != JsonValue::Type::Object) { return nullptr; }
+            for (uint32_t child = object->firstChild; child != JsonValue::NONE; child = m_values[child].nextSibling) {
+                if (m_values[child].key == key) { return &m_values[child]; }
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] const JsonValue* at(const JsonValue* array, const size_t index) const {
+            if (!array || array->type != JsonValue::Type::Array) { return nullptr; }
+            size_t i = 0;
+            for (uint32_t child = array->firstChild; child != JsonValue::NONE; child = m_values[child].nextSibling, ++i) {
+                if (i == index) { return &m_values[child]; }
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] size_t count(const JsonValue* array) const {
+            size_t count = 0;
+            if (array && array->type == JsonValue::Type::Array) {
+                for (uint32_t child = array->firstChild; child != JsonValue::NONE; child = m_values[child].nextSibling) { ++count; }
+            }
+            return count;
+        }
+
+        // Calls body for each element of an array, or does nothing for anything else.
+        void forEach(const JsonValue* array, const std::function<void(const JsonValue&)>& body) const {
+            if (!array || array->type != JsonValue::Type::Array) { return; }
+            for (uint32_t child = array->firstChild; child != JsonValue::NONE; child = m_values[child].nextSibling) {
+                body(m_values[child]);
+            }
+        }
+
+        [[nodiscard]] double number(const JsonValue* object, const std::string_view key, const double fallback) const {
+            const JsonValue* value = find(object, key);
+            return value && value->type == JsonValue::Type::Number ? value->number : fallback;
+        }
+
+        // Reads a count, offset or index: false unless value is a whole number in [0, limit].
+        static bool toSize(const JsonValue* value, const size_t limit, size_t& out) {
+            if (!value || value->type != JsonValue::Type::Number) { return false; }
+            const double number = value->number;
+            if (!(number >= 0.0) || number != std::floor(number) || number > static_cast<double>(limit)) { return false; }
+            out = static_cast<size_t>(number);
+            return true;
+        }
+
+        // As toSize, for a key of object. A missing key gives fallback.
+        bool size(const JsonValue* object, const std::string_view key, const size_t fallback, const size_t limit, size_t& out) const {
+            const JsonValue* value = find(object, key);
+            if (!value) {
+                out = fallback;
+                return true;
+            }
+            return toSize(value, limit, out);
+        }
+
+    private:
+        static constexpr int MAX_DEPTH = 64;
+
+        std::string_view m_text;
+        size_t m_position = 0;
+        std::vector<JsonValue> m_values;
+
+        void _skipSpaces() {
+            while (m_position < m_text.size() && (m_text[m_position] == ' ' || m_text[m_position] == '\t' || m_text[m_position] == '\n' || m_text[m_position] == '\r')) {
+                ++m_position;
+            }
+        }
+
+        bool _parseString(std::string_view& out) {
+            if (m_position >= m_text.size() || m_text[m_position] != '"') { return false; }
+            const size_t start = ++m_position;
+            while (m_position < m_text.size() && m_text[m_position] != '"') {
+                m_position += m_text[m_position] == '\\' ? 2 : 1;
+            }
+            if (m_position >= m_text.size()) { return false; }
+            out = m_text.substr(start, m_position++ - start);
+            return true;
+        }
+
+        bool _consume(const std::string_view word) {
+            if (m_text.substr(m_position, word.size()) != word) { return false; }
+            m_position += word.size();
+            return true;
+        }
+
+        // Index of the new value, NONE on a syntax error.
+        uint32_t _parseValue(const int depth) {
+            _skipSpaces();
+            if (depth > MAX_DEPTH || m_position >= m_text.size()) { return JsonValue::NONE; }
+
+            const uint32_t index = static_cast<uint32_t>(m_values.size());
+            m_values.emplace_back();
+
+            const char c = m_text[m_position];
+            if (c == '{' || c == '[') {
+                const bool object = c == '{';
+                m_values[index].type = object ? JsonValue::Type::Object : JsonValue::Type::Array;
+                ++m_position;
+
+                uint32_t previous = JsonValue::NONE;
+                _skipSpaces();
+                if (m_position < m_text.size() && m_text[m_position] == (object ? '}' : ']')) {
+                    ++m_position;
+                    return index;
+                }
+                while (true) {
+                    std::string_view key;
+                    if (object) {
+                        _skipSpaces();
+                        if (!_parseString(key)) { return JsonValue::NONE; }
+                        _skipSpaces();
+                        if (!_consume(":")) { return JsonValue::NONE; }
+                    }
+
+                    const uint32_t child = _parseValue(depth + 1);
+                    if (child == JsonValue::NONE) { return JsonValue::NONE; }
+                    m_values[child].key = key;
+                    (previous == JsonValue::NONE ? m_values[index].firstChild : m_values[previous].nextSibling) = child;
+                    previous = child;
+
+                    _skipSpaces();
+                    if (_consume(",")) { continue; }
+                    if (_consume(object ? "}" : "]")) { return index; }
+                    return JsonValue::NONE;
+                }
+            }
+
+            if (c == '"') {
+                m_values[index].type = JsonValue::Type::String;
+                return _parseString(m_values[index].text) ? index : JsonValue::NONE;
+            }
+            if (_consume("true") || _consume("false")) {
+                m_values[index].type = JsonValue::Type::Bool;
+                m_values[index].number = m_text[m_position - 1] == 'e' && m_text[m_position - 2] == 'u' ? 1.0 : 0.0;
+                return index;
+            }
+            if (_consume("null")) { return index; }
+
+            m_values[index].type = JsonValue::Type::Number;
+            const auto [next, error] = std::from_chars(m_text.data() + m_position, m_text.data() + m_text.size(), m_values[index].number);
+            if (error != std::errc()) { return JsonValue::NONE; }
+            m_position = next - m_text.data();
+            return index;
+        }
+    };
+
+    // ---- glTF ----
+
+    constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+    constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+    // Largest array index a glTF file may use, anything bigger is malformed.
+    constexpr size_t MAX_JSON_INDEX = 0xFFFFFFFF;
+
+    constexpr int GLTF_BYTE = 5120;
+    constexpr int GLTF_UNSIGNED_BYTE = 5121;
+    constexpr int GLTF_SHORT = 5122;
+    constexpr int GLTF_UNSIGNED_SHORT = 5123;
+    constexpr int GLTF_UNSIGNED_INT = 5125;
+    constexpr int GLTF_FLOAT = 5126;
+    constexpr int GLTF_TRIANGLES = 4;
+
+    // A validated view of one accessor's elements inside the BIN chunk.
+    struct Accessor {
+        const unsigned char* data = nullptr;
+        size_t stride = 0;
+        size_t count = 0;
+        int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+
+        [[nodiscard]] float read(const size_t element, const int component) const {
+            const unsigned char* p = data + stride * element;
+            switch (componentType) {
+                case GLTF_FLOAT: { float v; std::memcpy(&v, p + component * 4, 4); return v; }
+                case GLTF_UNSIGNED_BYTE: { const float v = p[component]; return normalized ? v / 255.0f : v; }
+                case GLTF_BYTE: { const float v = static_cast<int8_t>(p[component]); return normalized ? std::max(v / 127.0f, -1.0f) : v; }
+                case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p + component * 2, 2); return normalized ? v / 65535.0f : v; }
+                case GLTF_SHORT: { int16_t v; std::memcpy(&v, p + component * 2, 2); return normalized ? std::max(v / 32767.0f, -1.0f) : v; }
+                default: return 0.0f;
+            }
+        }
+
+        [[nodiscard]] uint32_t readIndex(const size_t element) const {
+            const unsigned char* p = data + stride * element;
+            switch (componentType) {
+                case GLTF_UNSIGNED_BYTE: return p[0];
+                case GLTF_UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+                case GLTF_UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+                default: return 0;
+            }
+        }
+    };
+
+    size_t componentSize(const int componentType) {
+        switch (componentType) {
+            case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: return 1;
+            case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: return 2;
+            case GLTF_UNSIGNED_INT: case GLTF_FLOAT: return 4;
+            default: return 0;
+        }
+    }
+
+    int componentCount(const std::string_view type) {
+        if (type == "SCALAR") { return 1; }
+        if (type == "VEC2") { return 2; }
+        if (type == "VEC3") { return 3; }
+        if (type == "VEC4") { return 4; }
+        return 0;
+    }
+
+    bool readAccessor(const JsonDocument& json, const JsonValue* accessors, const JsonValue* bufferViews, const std::string_view bin, const JsonValue* indexValue, Accessor& accessor) {
+        size_t accessorIndex;
+        if (!JsonDocument::toSize(indexValue, MAX_JSON_INDEX, accessorIndex)) { return false; }
+        const JsonValue* value = json.at(accessors, accessorIndex);
+        if (!value) { return false; }
+        if (json.find(value, "sparse")) {
+            std::cout << "ERROR::MESH::GLTF_SPARSE_ACCESSOR" << std::endl;
+            return false;
+        }
+
+        const JsonValue* type = json.find(value, "type");
+        size_t componentType, viewIndex;
+        if (!json.size(value, "componentType", 0, MAX_JSON_INDEX, componentType) ||
+            !json.size(value, "count", 0, bin.size(), accessor.count) ||
+            !json.size(value, "bufferView", MAX_JSON_INDEX, MAX_JSON_INDEX, viewIndex)) {
+            return false;
+        }
+        accessor.componentType = static_cast<int>(componentType);
+        accessor.components = type && type->type == JsonValue::Type::String ? componentCount(type->text) : 0;
+        const JsonValue* normalized = json.find(value, "normalized");
+        accessor.normalized = normalized && normalized->number != 0.0;
+
+        const JsonValue* view = json.at(bufferViews, viewIndex);
+        const size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+        if (!view || elementSize == 0 || json.number(view, "buffer", 0) != 0) { return false; }
+
+        size_t viewOffset, viewLength, offset;
+        if (!json.size(view, "byteOffset", 0, bin.size(), viewOffset) ||
+            !json.size(view, "byteLength", 0, bin.size(), viewLength) ||
+            !json.size(value, "byteOffset", 0, bin.size(), offset) ||
+            !json.size(view, "byteStride", elementSize, bin.size(), accessor.stride)) {
+            return false;
+        }
+
+        // Everything read later is within the view, and the view within the chunk. Every value came from the file,
+        // so the checks subtract rather than add.
+        if (viewLength > bin.size() - viewOffset || accessor.stride < elementSize) { return false; }
+        if (accessor.count > 0) {
+            if (offset > viewLength || elementSize > viewLength - offset) { return false; }
+            if (accessor.count - 1 > (viewLength - offset - elementSize) / accessor.stride) { return false; }
+        }
+        accessor.data = reinterpret_cast<const unsigned char*>(bin.data()) + viewOffset + offset;
+        return true;
+    }
+
+    glm::mat4 nodeTransform(const JsonDocument& json, const JsonValue& node) {
+        glm::mat4 transform(1.0f);
+        if (const JsonValue* matrix = json.find(&node, "matrix"); matrix && json.count(matrix) == 16) {
+            int i = 0;
+            json.forEach(matrix, [&](const JsonValue& value) { transform[i / 4][i % 4] = static_cast<float>(value.number); ++i; });
+            return transform;
+        }
+
+        float t[3] = { 0, 0, 0 }, r[4] = { 0, 0, 0, 1 }, s[3] = { 1, 1, 1 };
+        const auto readArray = [&](const char* key, float* out, const size_t size) {
+            const JsonValue* array = json.find(&node, key);
+            if (json.count(array) != size) { return; }
+            size_t i = 0;
+            json.forEach(array, [&](const JsonValue& value) { out[i++] = static_cast<float>(value.number); });
+        };
+        readArray("translation", t, 3);
+        readArray("rotation", r, 4);
+        readArray("scale", s, 3);
+
+        // T * R * S, with R from the unit quaternion (x, y, z, w).
+        const float x = r[0], y = r[1], z = r[2], w = r[3];
+        transform[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0) * s[0];
+        transform[1] = glm::vec4(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0) * s[1];
+        transform[2] = glm::vec4(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0) * s[2];
+        transform[3] = glm::vec4(t[0], t[1], t[2], 1);
+        return transform;
+    }
+
+    // A triangle primitive placed in the scene, and where its corners go in the merged corner array.
+    struct GltfPrimitive {
+        Accessor positions;
+        Accessor texCoords;
+        Accessor indices;
+        bool indexed = false;
+        bool hasTexCoords = false;
+        glm::mat4 transform;
+        // Mirroring transforms turn triangles inside out, their corners are swapped back.
+        bool mirrored = false;
+        size_t firstCorner = 0;
+        size_t cornerCount = 0;
+    };
+}
+
+bool loadMesh(const std::filesystem::path &path, Mesh &mesh, JobPool *pool, MeshOptimizationReport *report) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+
+    if (extension != ".obj" && extension != ".glb") {
+        std::cout << "ERROR::MESH::UNKNOWN_FORMAT " << path.string() << std::endl;
+        return false;
+    }
+
+    const FileData file = FileData::open(path);
+    if (!file) { return false; }
+
+    const bool loaded = extension == ".obj" ? loadObjMesh(file, mesh, pool) : loadGlbMesh(file, mesh, pool);
+    if (!loaded) {
+        std::cout << "ERROR::MESH::LOAD_FAILED " << path.string() << std::endl;
+        return false;
+    }
+
+    const MeshOptimizationReport optimized = optimizeMesh(mesh);
+    if (report) { *report = optimized; }
+    return true;
+}
+
+bool loadObjMesh(const FileData &file, Mesh &mesh, JobPool *pool) {
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    // Chunks start on line boundaries, the first pass counts what each holds so the second knows where to write.
+    const size_t wanted = pool ? std::max<size_t>(1, std::min<size_t>(pool->getThreadCount() * 4, file.size() / OBJ_CHUNK_BYTES)) : 1;
+    std::vector<ObjChunk> chunks;
+    for (const char* chunkBegin = begin; chunkBegin < end;) {
+        const char* chunkEnd = chunks.size() + 1 == wanted ? end : std::min(end, lineEnd(std::max(chunkBegin, begin + file.size() * (chunks.size() + 1) / wanted), end) + 1);
+        chunks.push_back({ chunkBegin, chunkEnd });
+        chunkBegin = chunkEnd;
+    }
+
+    forRanges(pool, chunks.size(), 1, [&](const size_t first, const size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            ObjChunk& chunk = chunks[i];
+            for (const char* line = chunk.begin; line < chunk.end;) {
+                const char* lineStop = lineEnd(line, chunk.end);
+                const char* p = line;
+                line = lineStop + 1;
+
+                switch (classify(p, lineStop)) {
+                    case ObjLine::Position: ++chunk.positions; break;
+                    case ObjLine::TexCoord: ++chunk.texCoords; break;
+                    case ObjLine::Face: chunk.triangles += std::max(0, cornersOnLine(p, lineStop) - 2); break;
+                    case ObjLine::Other: break;
+                }
+            }
+        }
+    });
+
+    // Counts become offsets into the whole file's arrays.
+    size_t positionCount = 0, texCoordCount = 0, triangleCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        const ObjChunk counts = chunk;
+        chunk.positions = positionCount;
+        chunk.texCoords = texCoordCount;
+        chunk.triangles = triangleCount;
+        positionCount += counts.positions;
+        texCoordCount += counts.texCoords;
+        triangleCount += counts.triangles;
+    }
+    if (triangleCount == 0) {
+        std::cout << "ERROR::MESH::NO_TRIANGLES" << std::endl;
+        return false;
+    }
+
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec2> texCoords(texCoordCount);
+    std::vector<ObjCorner> objCorners(triangleCount * 3);
+    std::atomic<bool> parsed = true;
+    forRanges(pool, chunks.size(), 1, [&](const size_t first, const size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            if (!parseObjChunk(chunks[i], positions, texCoords, objCorners)) { parsed = false; }
+        }
+    });
+    if (!parsed) {
+        std::cout << "ERROR::MESH::OBJ_PARSE_FAILED" << std::endl;
+        return false;
+    }
+
+    std::vector<Vertex> corners(objCorners.size());
+    std::atomic<bool> inRange = true;
+    forRanges(pool, corners.size(), CORNER_GRAIN, [&](const size_t first, const size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const ObjCorner& corner = objCorners[i];
+            if (corner.position < 0 || corner.position >= static_cast<int64_t>(positionCount) || corner.texCoord >= static_cast<int64_t>(texCoordCount) || corner.texCoord < -1) {
+                inRange = false;
+                continue;
+            }
+            corners[i] = { positions[corner.position], corner.texCoord >= 0 ? texCoords[corner.texCoord] : glm::vec2(0.0f) };
+        }
+    });
+    if (!inRange) {
+        std::cout << "ERROR::MESH::INDEX_OUT_OF_RANGE" << std::endl;
+        return false;
+    }
+
+    buildIndexedMesh(corners, mesh, pool);
+    return true;
+}
+
+bool loadGlbMesh(const FileData &file, Mesh &mesh, JobPool *pool) {
+    uint32_t header[3];
+    uint32_t jsonHeader[2];
+    if (file.size() < sizeof(header) + sizeof(jsonHeader)) {
+        std::cout << "ERROR::MESH::GLB_TRUNCATED" << std::endl;
+        return false;
+    }
+    std::memcpy(header, file.data(), sizeof(header));
+    std::memcpy(jsonHeader, file.data() + sizeof(header), sizeof(jsonHeader));
+    if (header[0] != GLB_MAGIC || header[1] != 2 || jsonHeader[1] != GLB_CHUNK_JSON) {
+        std::cout << "ERROR::MESH::GLB_WRONG_VERSION" << std::endl;
+        return false;
+    }
+
+    const size_t jsonOffset = sizeof(header) + sizeof(jsonHeader);
+    if (jsonOffset + jsonHeader[0] > file.size()) {
+        std::cout << "ERROR::MESH::GLB_TRUNCATED" << std::endl;
+        return false;
+    }
+
+    // The BIN chunk is optional, and follows the JSON one padded to 4 bytes.
+    std::string_view bin;
+    const size_t binOffset = jsonOffset + (jsonHeader[0] + 3) / 4 * 4;
+    if (binOffset + 8 <= file.size()) {
+        uint32_t binHeader[2];
+        std::memcpy(binHeader, file.data() + binOffset, sizeof(binHeader));
+        if (binHeader[1] == GLB_CHUNK_BIN && binOffset + 8 + binHeader[0] <= file.size()) {
+            bin = std::string_view(file.data() + binOffset + 8, binHeader[0]);
+        }
+    }
+
+    JsonDocument json;
+    if (!json.parse(std::string_view(file.data() + jsonOffset, jsonHeader[0]))) {
+        std::cout << "ERROR::MESH::GLTF_PARSE_FAILED" << std::endl;
+        return false;
+    }
+
+    const JsonValue* root = &json.root();
+    const JsonValue* buffers = json.find(root, "buffers");
+    if (const JsonValue* buffer = json.at(buffers, 0); json.count(buffers) > 1 || json.find(buffer, "uri")) {
+        std::cout << "ERROR::MESH::GLTF_EXTERNAL_BUFFER" << std::endl;
+        return false;
+    }
+
+    const JsonValue* meshes = json.find(root, "meshes");
+    const JsonValue* nodes = json.find(root, "nodes");
+    const JsonValue* accessors = json.find(root, "accessors");
+    const JsonValue* bufferViews = json.find(root, "bufferViews");
+
+    // Walk the scene to find every mesh instance and where it sits.
+    std::vector<GltfPrimitive> primitives;
+    bool valid = true;
+    bool tooLarge = false;
+    size_t instances = 0;
+    size_t cornerCount = 0;
+    // Counts one more node or primitive, and gives up on the scene once there are too many.
+    const auto visit = [&]() {
+        if (++instances > MAX_GLTF_INSTANCES) {
+            tooLarge = true;
+            valid = false;
+        }
+        return valid;
+    };
+    const auto addMesh = [&](const JsonValue* meshValue, const glm::mat4& transform) {
+        json.forEach(json.find(meshValue, "primitives"), [&](const JsonValue& primitiveValue) {
+            if (!visit()) { return; }
+            if (json.number(&primitiveValue, "mode", GLTF_TRIANGLES) != GLTF_TRIANGLES) { return; }
+
+            GltfPrimitive primitive;
+            primitive.transform = transform;
+            const glm::vec3 x(transform[0]), y(transform[1]), z(transform[2]);
+            primitive.mirrored = glm::dot(glm::cross(x, y), z) < 0.0f;
+
+            const JsonValue* attributes = json.find(&primitiveValue, "attributes");
+            const JsonValue* texCoordIndex = json.find(attributes, "TEXCOORD_0");
+            const JsonValue* indexIndex = json.find(&primitiveValue, "indices");
+            primitive.hasTexCoords = texCoordIndex != nullptr;
+            primitive.indexed = indexIndex != nullptr;
+
+            if (!readAccessor(json, accessors, bufferViews, bin, json.find(attributes, "POSITION"), primitive.positions) ||
+                (primitive.hasTexCoords && !readAccessor(json, accessors, bufferViews, bin, texCoordIndex, primitive.texCoords)) ||
+                (primitive.indexed && !readAccessor(json, accessors, bufferViews, bin, indexIndex, primitive.indices))) {
+                valid = false;
+                return;
+            }
+            if (primitive.positions.components != 3 || (primitive.hasTexCoords && primitive.texCoords.components != 2) ||
+                (primitive.indexed && primitive.indices.components != 1)) {
+                valid = false;
+                return;
+            }
+
+            primitive.cornerCount = (primitive.indexed ? primitive.indices.count : primitive.positions.count) / 3 * 3;
+            if (primitive.cornerCount == 0) { return; }
+            if (primitive.cornerCount > MAX_GLTF_CORNERS - cornerCount) {
+                tooLarge = true;
+                valid = false;
+                return;
+            }
+            primitive.firstCorner = cornerCount;
+            cornerCount += primitive.cornerCount;
+            primitives.push_back(primitive);
+        });
+    };
+
+    std::function<void(size_t, const glm::mat4&, int)> addNode = [&](const size_t index, const glm::mat4& parent, const int depth) {
+        if (!visit()) { return; }
+        const JsonValue* node = json.at(nodes, index);
+        if (!node || depth > 64) {
+            valid = false;
+            return;
+        }
+        const glm::mat4 transform = parent * nodeTransform(json, *node);
+        if (const JsonValue* meshIndex = json.find(node, "mesh")) {
+            size_t index;
+            if (!JsonDocument::toSize(meshIndex, MAX_JSON_INDEX, index)) {
+                valid = false;
+                return;
+            }
+            addMesh(json.at(meshes, index), transform);
+        }
+        json.forEach(json.find(node, "children"), [&](const JsonValue& child) {
+            if (!valid) { return; }
+            size_t childIndex;
+            if (!JsonDocument::toSize(&child, MAX_JSON_INDEX, childIndex)) {
+                valid = false;
+                return;
+            }
+            addNode(childIndex, transform, depth + 1);
+        });
+    };
+
+    const JsonValue* scenes = json.find(root, "scenes");
+    size_t sceneIndex;
+    if (!json.size(root, "scene", 0, MAX_JSON_INDEX, sceneIndex)) {
+        std::cout << "ERROR::MESH::GLTF_PARSE_FAILED" << std::endl;
+        return false;
+    }
+    if (const JsonValue* scene = json.at(scenes, sceneIndex)) {
+        json.forEach(json.find(scene, "nodes"), [&](const JsonValue& node) {
+            if (!valid) { return; }
+            size_t nodeIndex;
+            if (!JsonDocument::toSize(&node, MAX_JSON_INDEX, nodeIndex)) {
+                valid = false;
+                return;
+            }
+            addNode(nodeIndex, glm::mat4(1.0f), 0);
+        });
+    } else {
+        // No scene to place them, so every mesh goes in once where it was modelled.
+        json.forEach(meshes, [&](const JsonValue& meshValue) { addMesh(&meshValue, glm::mat4(1.0f)); });
+    }
+
+    if (tooLarge) {
+        std::cout << "ERROR::MESH::TOO_MANY_TRIANGLES" << std::endl;
+        return false;
+    }
+    if (!valid) {
+        std::cout << "ERROR::MESH::GLTF_BAD_ACCESSOR" << std::endl;
+        return false;
+    }
+    if (cornerCount == 0) {
+        std::cout << "ERROR::MESH::NO_TRIANGLES" << std::endl;
+        return false;
+    }
+
+    // Corners are gathered in fixed size pieces, so one huge primitive still spreads across every thread.
+    std::vector<Vertex> corners(cornerCount);
+    std::atomic<bool> inRange = true;
+    forRanges(pool, cornerCount, CORNER_GRAIN, [&](const size_t first, const size_t last) {
+        auto primitive = std::upper_bound(primitives.begin(), primitives.end(), first, [](const size_t corner, const GltfPrimitive& p) { return corner < p.firstCorner; }) - 1;
+        for (size_t i = first; i < last; ++i) {
+            while (i >= primitive->firstCorner + primitive->cornerCount) { ++primitive; }
+
+            size_t corner = i - primitive->firstCorner;
+            if (primitive->mirrored && corner % 3 != 0) { corner += corner % 3 == 1 ? 1 : -1; }
+
+            const size_t vertex = primitive->indexed ? primitive->indices.readIndex(corner) : corner;
+            if (vertex >= primitive->positions.count || (primitive->hasTexCoords && vertex >= primitive->texCoords.count)) {
+                inRange = false;
+                continue;
+            }
+
+            const Accessor& positions = primitive->positions;
+            const glm::vec4 position = primitive->transform * glm::vec4(positions.read(vertex, 0), positions.read(vertex, 1), positions.read(vertex, 2), 1.0f);
+            const glm::vec2 texCoord = primitive->hasTexCoords
+                ? glm::vec2(primitive->texCoords.read(vertex, 0), 1.0f - primitive->texCoords.read(vertex, 1))
+                : glm::vec2(0.0f);
+            corners[i] = { glm::vec3(position.x, position.y, position.z), texCoord };
+        }
+    });
+    if (!inRange) {
+        std::cout << "ERROR::MESH::INDEX_OUT_OF_RANGE" << std::endl;
+        return false;
+    }
+
+    buildIndexedMesh(corners, mesh, pool);
+    return true;
+}
@@ -0,0 +1,253 @@
+#include "../headers/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    // FIFO cache by timestamps: a vertex is cached if it went in fewer than cacheSize misses ago.
+    class CacheSimulator {
+    public:
+        CacheSimulator(const size_t vertexCount, const unsigned int cacheSize) : m_cacheTime(vertexCount, 0), m_cacheSize(cacheSize) {}
+
+        // Whether the vertex had to be transformed.
+        bool access(const unsigned int vertex) {
+            if (m_time - m_cacheTime[vertex] < m_cacheSize && m_cacheTime[vertex] != 0) { return false; }
+            m_cacheTime[vertex] = m_time++;
+            return true;
+        }
+
+        // Pushes everything out, as if starting on a cold cache.
+        void flush() { m_time += m_cacheSize; }
+
+    private:
+        std::vector<uint64_t> m_cacheTime;
+        uint64_t m_time = 1;
+        unsigned int m_cacheSize;
+    };
+
+    // Triangles using each vertex, as one array with per vertex offsets.
+    struct Adjacency {
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> triangles;
+
+        Adjacency(const std::vector<unsigned int>& indices, const size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size()) {
+            for (const unsigned int index : indices) { ++offsets[index + 1]; }
+            for (size_t v = 0; v < vertexCount; ++v) { offsets[v + 1] += offsets[v]; }
+
+            std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); ++i) {
+                triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+    };
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices, const size_t vertexCount, const unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indices.size() < 3) { return stats; }
+
+    CacheSimulator cache(vertexCount, cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (const unsigned int index : indices) {
+        stats.transformed += cache.access(index);
+        if (!used[index]) {
+            used[index] = true;
+            ++usedCount;
+        }
+    }
+
+    stats.acmr = static_cast<float>(stats.transformed) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(stats.transformed) / static_cast<float>(usedCount);
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, const size_t vertexCount, std::vector<size_t> *clusters, const unsigned int cacheSize) {
+    if (clusters) { clusters->assign(1, 0); }
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) { return; }
+
+    const Adjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    std::vector<uint64_t> cacheTime(vertexCount, 0);
+    uint64_t time = cacheSize + 1;
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    size_t nextScan = 0;
+
+    // Vertices are fanned around one at a time: every remaining triangle of the current vertex is emitted, then the
+    // next vertex is picked among those just used, preferring ones that will still be in the cache after their own
+    // remaining triangles go out.
+    for (int64_t fanning = indices[0]; fanning >= 0;) {
+        candidates.clear();
+        for (unsigned int i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+            const unsigned int triangle = adjacency.triangles[i];
+            if (emitted[triangle]) { continue; }
+
+            for (int corner = 0; corner < 3; ++corner) {
+                const unsigned int vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (time - cacheTime[vertex] > cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        int64_t best = -1;
+        uint64_t bestPriority = 0;
+        for (const unsigned int vertex : candidates) {
+            if (liveTriangles[vertex] == 0) { continue; }
+            uint64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                priority = time - cacheTime[vertex];
+            }
+            if (best < 0 || priority > bestPriority) {
+                best = vertex;
+                bestPriority = priority;
+            }
+        }
+        if (best >= 0) {
+            fanning = best;
+            continue;
+        }
+
+        // Dead end: back up through recently used vertices, and failing that take the next one with triangles left.
+        // Either way the order restarts somewhere else, which starts a new cluster.
+        fanning = -1;
+        while (!deadEnd.empty() && fanning < 0) {
+            const unsigned int vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0) { fanning = vertex; }
+        }
+        while (fanning < 0 && nextScan < vertexCount) {
+            if (liveTriangles[nextScan] > 0) { fanning = static_cast<int64_t>(nextScan); }
+            ++nextScan;
+        }
+        if (fanning >= 0 && clusters && result.size() < indices.size()) {
+            clusters->push_back(result.size() / 3);
+        }
+    }
+
+    indices = std::move(result);
+}
+
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, const std::vector<size_t> &clusters, const float threshold, const unsigned int cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || clusters.empty()) { return; }
+
+    // Split the hard clusters wherever the running ACMR since the last split is already within threshold.
+    std::vector<size_t> splits;
+    CacheSimulator cache(vertices.size(), cacheSize);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        const size_t begin = clusters[c];
+        const size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+        cache.flush();
+        size_t misses = 0;
+        for (size_t i = begin * 3; i < end * 3; ++i) { misses += cache.access(indices[i]); }
+        const float target = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+        cache.flush();
+        misses = 0;
+        size_t start = begin;
+        splits.push_back(begin);
+        for (size_t triangle = begin; triangle < end; ++triangle) {
+            for (int corner = 0; corner < 3; ++corner) { misses += cache.access(indices[triangle * 3 + corner]); }
+            if (triangle + 1 < end && static_cast<float>(misses) / static_cast<float>(triangle + 1 - start) <= target) {
+                splits.push_back(triangle + 1);
+                start = triangle + 1;
+                misses = 0;
+                cache.flush();
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of every cluster, and of the mesh.
+    struct Cluster {
+        size_t begin;
+        size_t end;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted(splits.size());
+    std::vector<glm::vec3> centroids(splits.size()), normals(splits.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < splits.size(); ++c) {
+        sorted[c] = { splits[c], c + 1 < splits.size() ? splits[c + 1] : triangleCount, 0.0f };
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t triangle = sorted[c].begin; triangle < sorted[c].end; ++triangle) {
+            const glm::vec3& a = vertices[indices[triangle * 3]].position;
+            const glm::vec3& b = vertices[indices[triangle * 3 + 1]].position;
+            const glm::vec3& d = vertices[indices[triangle * 3 + 2]].position;
+            const glm::vec3 cross = glm::cross(b - a, d - a);
+            const float triangleArea = std::sqrt(glm::dot(cross, cross));
+
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids[c] = area > 0.0f ? centroid * (1.0f / area) : centroid;
+        normals[c] = normal;
+    }
+    if (meshArea > 0.0f) { meshCentroid = meshCentroid * (1.0f / meshArea); }
+
+    // How far the cluster faces out from the middle of the mesh. Clusters facing furthest out are the least likely
+    // to be hidden behind anything else.
+    for (size_t c = 0; c < sorted.size(); ++c) {
+        const float length = std::sqrt(glm::dot(normals[c], normals[c]));
+        sorted[c].sortKey = length > 0.0f ? glm::dot(centroids[c] - meshCentroid, normals[c]) / length : 0.0f;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : sorted) {
+        result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    indices = std::move(result);
+}
+
+void optimizeVertexFetch(Mesh &mesh) {
+    constexpr unsigned int UNUSED = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (unsigned int& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+MeshOptimizationReport optimizeMesh(Mesh &mesh, const float overdrawThreshold) {
+    MeshOptimizationReport report;
+    report.before = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    std::vector<size_t> clusters;
+    optimizeVertexCache(mesh.indices, mesh.vertices.size(), &clusters);
+    optimizeOverdraw(mesh.indices, mesh.vertices, clusters, overdrawThreshold);
+    optimizeVertexFetch(mesh);
+
+    report.after = analyzeVertexCache(mesh.indices, mesh.vertices.size());
+    return report;
+}
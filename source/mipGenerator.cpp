@@ -0,0 +1,490 @@
+#include "../headers/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "stb_image/stb_image.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MIPGEN_SSE2 1
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__)
+#define MIPGEN_AVX2 1
+#endif
+
+namespace {
+    // Levels are filtered as four floats per pixel whatever the channel count, so every pixel is one SSE register.
+    constexpr int WORKING_CHANNELS = 4;
+    constexpr int LINEAR_TO_SRGB_SIZE = 16384;
+    // Kaiser support in destination pixels either side of the centre, and the window's shape parameter.
+    constexpr double KAISER_RADIUS = 2.0;
+    constexpr double KAISER_ALPHA = 4.0;
+    constexpr double PI = 3.14159265358979323846;
+
+    struct SrgbTables {
+        float toLinear[256];
+        uint8_t fromLinear[LINEAR_TO_SRGB_SIZE];
+
+        SrgbTables() {
+            for (int i = 0; i < 256; ++i) {
+                const double c = i / 255.0;
+                toLinear[i] = static_cast<float>(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+            }
+            for (int i = 0; i < LINEAR_TO_SRGB_SIZE; ++i) {
+                const double l = i / static_cast<double>(LINEAR_TO_SRGB_SIZE - 1);
+                const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                fromLinear[i] = static_cast<uint8_t>(std::clamp(std::lround(c * 255.0), 0l, 255l));
+            }
+        }
+    };
+
+    const SrgbTables& srgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    // For every destination pixel along one axis, taps source indices (already clamped to the edge) and weights.
+    struct Kernel {
+        int taps = 0;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    double besselI0(const double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+            if (term < sum * 1e-12) { break; }
+        }
+        return sum;
+    }
+
+    double kaiserSinc(const double t, const double radius) {
+        const double u = t / radius;
+        if (std::fabs(u) >= 1.0) { return 0.0; }
+
+        const double sinc = std::fabs(t) < 1e-9 ? 1.0 : std::sin(PI * t) / (PI * t);
+        return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0 - u * u)) / besselI0(KAISER_ALPHA);
+    }
+
+    Kernel makeKernel(const int sourceSize, const int targetSize, const MipFilter filter) {
+        const double scale = static_cast<double>(sourceSize) / targetSize;
+        const double support = filter == MipFilter::Box ? scale * 0.5 : KAISER_RADIUS * scale;
+
+        // Widest span of source pixels any destination pixel touches.
+        Kernel kernel;
+        for (int x = 0; x < targetSize; ++x) {
+            const double centre = (x + 0.5) * scale;
+            const int first = static_cast<int>(std::floor(centre - support));
+            const int last = static_cast<int>(std::ceil(centre + support)) - 1;
+            kernel.taps = std::max(kernel.taps, last - first + 1);
+        }
+        kernel.indices.resize(static_cast<size_t>(targetSize) * kernel.taps);
+        kernel.weights.resize(kernel.indices.size());
+
+        for (int x = 0; x < targetSize; ++x) {
+            const double centre = (x + 0.5) * scale;
+            const int first = static_cast<int>(std::floor(centre - support));
+            int* indices = &kernel.indices[static_cast<size_t>(x) * kernel.taps];
+            float* weights = &kernel.weights[static_cast<size_t>(x) * kernel.taps];
+
+            double total = 0.0;
+            for (int k = 0; k < kernel.taps; ++k) {
+                const int i = first + k;
+                double weight;
+                if (filter == MipFilter::Box) {
+                    // How much of source pixel i the destination pixel's footprint covers.
+                    weight = std::max(0.0, std::min(centre + support, i + 1.0) - std::max(centre - support, static_cast<double>(i)));
+                } else {
+                    weight = kaiserSinc((i + 0.5 - centre) / scale, KAISER_RADIUS);
+                }
+                indices[k] = std::clamp(i, 0, sourceSize - 1);
+                weights[k] = static_cast<float>(weight);
+                total += weight;
+            }
+            for (int k = 0; k < kernel.taps; ++k) {
+                weights[k] = static_cast<float>(weights[k] / total);
+            }
+        }
+        return kernel;
+    }
+
+    // destination[i] += source[i] * weight
+    void accumulate(float* destination, const float* source, const float weight, const size_t count) {
+        size_t i = 0;
+#ifdef MIPGEN_AVX2
+        const __m256 w8 = _mm256_set1_ps(weight);
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(destination + i, _mm256_add_ps(_mm256_loadu_ps(destination + i), _mm256_mul_ps(_mm256_loadu_ps(source + i), w8)));
+        }
+#endif
+#ifdef MIPGEN_SSE2
+        const __m128 w4 = _mm_set1_ps(weight);
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_mul_ps(_mm_loadu_ps(source + i), w4)));
+        }
+#endif
+        for (; i < count; ++i) {
+            destination[i] += source[i] * weight;
+        }
+    }
+
+    // Horizontal pass: one row of working pixels down to targetWidth.
+    void filterRow(float* destination, const float* source, const Kernel& kernel, const int targetWidth) {
+        const int taps = kernel.taps;
+        int x = 0;
+#ifdef MIPGEN_AVX2
+        // Two destination pixels per register, each lane half gathering its own source pixel.
+        for (; x + 2 <= targetWidth; x += 2) {
+            const int* i0 = &kernel.indices[static_cast<size_t>(x) * taps];
+            const int* i1 = i0 + taps;
+            const float* w0 = &kernel.weights[static_cast<size_t>(x) * taps];
+            const float* w1 = w0 + taps;
+
+            __m256 sum = _mm256_setzero_ps();
+            for (int k = 0; k < taps; ++k) {
+                const __m256 pixels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(source + i0[k] * WORKING_CHANNELS)), _mm_loadu_ps(source + i1[k] * WORKING_CHANNELS), 1);
+                const __m256 weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(w0[k])), _mm_set1_ps(w1[k]), 1);
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(pixels, weights));
+            }
+            _mm256_storeu_ps(destination + x * WORKING_CHANNELS, sum);
+        }
+#endif
+        for (; x < targetWidth; ++x) {
+            const int* indices = &kernel.indices[static_cast<size_t>(x) * taps];
+            const float* weights = &kernel.weights[static_cast<size_t>(x) * taps];
+#ifdef MIPGEN_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < taps; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source + indices[k] * WORKING_CHANNELS), _mm_set1_ps(weights[k])));
+            }
+            _mm_storeu_ps(destination + x * WORKING_CHANNELS, sum);
+#else
+            float sum[WORKING_CHANNELS] = {};
+            for (int k = 0; k < taps; ++k) {
+                for (int c = 0; c < WORKING_CHANNELS; ++c) {
+                    sum[c] += source[indices[k] * WORKING_CHANNELS + c] * weights[k];
+                }
+            }
+            std::memcpy(destination + x * WORKING_CHANNELS, sum, sizeof(sum));
+#endif
+        }
+    }
+
+    void forRanges(JobPool* pool, const size_t count, const size_t grain, const std::function<void(size_t, size_t)>& body) {
+        if (pool) {
+            pool->parallelFor(count, grain, body);
+        } else {
+            body(0, count);
+        }
+    }
+
+    // Roughly this many pixels per job, enough to be worth handing to another thread.
+    size_t rowGrain(const int width) {
+        return std::max<size_t>(1, 64 * 1024 / std::max(1, width));
+    }
+
+    // Separable: each destination row first gathers its source rows (vertical pass), then filters across.
+    void downsample(const float* source, const int sourceWidth, const int sourceHeight, float* destination, const int width, const int height, const MipFilter filter, JobPool* pool) {
+        const Kernel horizontal = makeKernel(sourceWidth, width, filter);
+        const Kernel vertical = makeKernel(sourceHeight, height, filter);
+        const size_t sourceRowSize = static_cast<size_t>(sourceWidth) * WORKING_CHANNELS;
+
+        forRanges(pool, height, rowGrain(sourceWidth), [&](const size_t begin, const size_t end) {
+            std::vector<float> row(sourceRowSize);
+            for (size_t y = begin; y < end; ++y) {
+                std::fill(row.begin(), row.end(), 0.0f);
+                for (int k = 0; k < vertical.taps; ++k) {
+                    const size_t tap = y * vertical.taps + k;
+                    accumulate(row.data(), source + vertical.indices[tap] * sourceRowSize, vertical.weights[tap], sourceRowSize);
+                }
+                filterRow(destination + y * width * WORKING_CHANNELS, row.data(), horizontal, width);
+            }
+        });
+    }
+
+    void bytesToWorking(const unsigned char* source, const size_t first, const size_t count, const int channels, const bool srgb, float* destination) {
+        const float* toLinear = srgbTables().toLinear;
+        for (size_t p = first; p < first + count; ++p) {
+            const unsigned char* in = source + p * channels;
+            float* out = destination + p * WORKING_CHANNELS;
+#ifdef MIPGEN_SSE2
+            if (channels == 4 && !srgb) {
+                int packed;
+                std::memcpy(&packed, in, 4);
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+                _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(1.0f / 255.0f)));
+                continue;
+            }
+#endif
+            for (int c = 0; c < WORKING_CHANNELS; ++c) {
+                if (c >= channels) {
+                    out[c] = 0.0f;
+                } else {
+                    out[c] = srgb && c < 3 ? toLinear[in[c]] : in[c] / 255.0f;
+                }
+            }
+        }
+    }
+
+    void workingToBytes(const float* source, const size_t first, const size_t count, const int channels, const bool srgb, unsigned char* destination) {
+        const uint8_t* fromLinear = srgbTables().fromLinear;
+        size_t p = first;
+#ifdef MIPGEN_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 byteScale = _mm_set1_ps(255.0f);
+
+        if (channels == 4 && !srgb) {
+            // Four pixels at a time, rounded and packed down to sixteen bytes.
+            const auto quantise = [&](const float* in) {
+                const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), zero), one);
+                return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, byteScale), half));
+            };
+            for (; p + 4 <= first + count; p += 4) {
+                const float* in = source + p * WORKING_CHANNELS;
+                const __m128i low = _mm_packs_epi32(quantise(in), quantise(in + 4));
+                const __m128i high = _mm_packs_epi32(quantise(in + 8), quantise(in + 12));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + p * 4), _mm_packus_epi16(low, high));
+            }
+        }
+
+        const __m128 tableScale = _mm_set1_ps(static_cast<float>(LINEAR_TO_SRGB_SIZE - 1));
+        for (; p < first + count; ++p) {
+            const __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + p * WORKING_CHANNELS), zero), one);
+            alignas(16) int32_t linear[4];
+            alignas(16) int32_t table[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(linear), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, byteScale), half)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(table), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, tableScale), half)));
+
+            unsigned char* out = destination + p * channels;
+            for (int c = 0; c < channels; ++c) {
+                out[c] = srgb && c < 3 ? fromLinear[table[c]] : static_cast<unsigned char>(linear[c]);
+            }
+        }
+#else
+        for (; p < first + count; ++p) {
+            const float* in = source + p * WORKING_CHANNELS;
+            unsigned char* out = destination + p * channels;
+            for (int c = 0; c < channels; ++c) {
+                const float v = std::clamp(in[c], 0.0f, 1.0f);
+                out[c] = srgb && c < 3
+                    ? fromLinear[static_cast<int>(v * (LINEAR_TO_SRGB_SIZE - 1) + 0.5f)]
+                    : static_cast<unsigned char>(v * 255.0f + 0.5f);
+            }
+        }
+#endif
+    }
+
+    void floatsToWorking(const float* source, const size_t first, const size_t count, const int channels, float* destination) {
+        for (size_t p = first; p < first + count; ++p) {
+            for (int c = 0; c < WORKING_CHANNELS; ++c) {
+                destination[p * WORKING_CHANNELS + c] = c < channels ? source[p * channels + c] : 0.0f;
+            }
+        }
+    }
+
+    void workingToFloats(const float* source, const size_t first, const size_t count, const int channels, float* destination) {
+        for (size_t p = first; p < first + count; ++p) {
+            std::memcpy(destination + p * channels, source + p * WORKING_CHANNELS, sizeof(float) * channels);
+        }
+    }
+
+    // Shared by both pixel types: convert level 0 in, then each level is filtered from the one above and converted out.
+    template <typename ToWorking, typename FromWorking>
+    void buildLevels(const MipChain& chain, unsigned char* storage, const MipFilter filter, JobPool* pool, const ToWorking& toWorking, const FromWorking& fromWorking) {
+        const size_t basePixels = static_cast<size_t>(chain.getWidth()) * chain.getHeight();
+        std::vector<float> current(basePixels * WORKING_CHANNELS);
+        std::vector<float> next;
+
+        forRanges(pool, basePixels, rowGrain(1), [&](const size_t begin, const size_t end) {
+            toWorking(begin, end - begin, current.data());
+        });
+
+        for (size_t level = 1; level < chain.getLevelCount(); ++level) {
+            const MipLevel& above = chain.getLevel(level - 1);
+            const MipLevel& info = chain.getLevel(level);
+            const size_t pixels = static_cast<size_t>(info.width) * info.height;
+
+            next.resize(pixels * WORKING_CHANNELS);
+            downsample(current.data(), above.width, above.height, next.data(), info.width, info.height, filter, pool);
+
+            forRanges(pool, pixels, rowGrain(1), [&](const size_t begin, const size_t end) {
+                fromWorking(next.data(), begin, end - begin, storage + info.offset);
+            });
+            current.swap(next);
+        }
+    }
+
+    uint64_t mix(uint64_t hash, const uint64_t value) {
+        constexpr uint64_t PRIME = 0x9E3779B97F4A7C15ull;
+        hash = (hash ^ value) * PRIME;
+        return hash ^ (hash >> 29);
+    }
+}
+
+size_t MipChain::_layout(int width, int height, const int channels, const MipPixelType type, const size_t maxLevels) {
+    m_channels = channels;
+    m_type = type;
+    m_levels.clear();
+
+    const size_t pixelSize = static_cast<size_t>(channels) * (type == MipPixelType::Float ? sizeof(float) : 1);
+    size_t offset = 0;
+    while (true) {
+        const size_t size = static_cast<size_t>(width) * height * pixelSize;
+        m_levels.push_back({ offset, size, width, height });
+        offset += size;
+
+        if ((width == 1 && height == 1) || m_levels.size() == maxLevels) { break; }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return offset;
+}
+
+MipChain generateMipChain(const unsigned char* pixels, const int width, const int height, const int channels, bool srgb, const MipFilter filter, JobPool* pool, const size_t maxLevels) {
+    MipChain chain;
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) { return chain; }
+
+    // Only RGB and RGBA have sRGB formats, and alpha is always linear.
+    srgb = srgb && channels >= 3;
+
+    chain.m_storage.resize(chain._layout(width, height, channels, MipPixelType::UnsignedByte, maxLevels));
+    std::memcpy(chain.m_storage.data(), pixels, chain.getLevel(0).size);
+
+    buildLevels(chain, chain.m_storage.data(), filter, pool,
+        [&](const size_t first, const size_t count, float* working) {
+            bytesToWorking(pixels, first, count, channels, srgb, working);
+        },
+        [&](const float* working, const size_t first, const size_t count, unsigned char* out) {
+            workingToBytes(working, first, count, channels, srgb, out);
+        });
+    return chain;
+}
+
+MipChain generateMipChain(const float* pixels, const int width, const int height, const int channels, const MipFilter filter, JobPool* pool, const size_t maxLevels) {
+    MipChain chain;
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) { return chain; }
+
+    chain.m_storage.resize(chain._layout(width, height, channels, MipPixelType::Float, maxLevels));
+    std::memcpy(chain.m_storage.data(), pixels, chain.getLevel(0).size);
+
+    buildLevels(chain, chain.m_storage.data(), filter, pool,
+        [&](const size_t first, const size_t count, float* working) {
+            floatsToWorking(pixels, first, count, channels, working);
+        },
+        [&](const float* working, const size_t first, const size_t count, unsigned char* out) {
+            workingToFloats(working, first, count, channels, reinterpret_cast<float*>(out));
+        });
+    return chain;
+}
+
+uint64_t MipCache::makeKey(const uint64_t sourceHash, const int channels, const bool srgb, const bool flip, const MipFilter filter) {
+    uint64_t key = mix(sourceHash, VERSION);
+    key = mix(key, static_cast<uint64_t>(channels));
+    key = mix(key, srgb ? 1 : 0);
+    key = mix(key, flip ? 1 : 0);
+    return mix(key, static_cast<uint64_t>(filter));
+}
+
+MipChain loadMipChain(const FileData& file, const int channels, const bool srgb, const bool flip, const MipFilter filter, MipCache* cache, JobPool* pool) {
+    MipChain chain;
+    if (!file) { return chain; }
+
+    const uint64_t key = cache ? MipCache::makeKey(file.hash(), channels, srgb, flip, filter) : 0;
+    if (cache && cache->load(key, chain)) { return chain; }
+
+    int width, height, fileChannels;
+    const std::unique_ptr<unsigned char, void (*)(void*)> pixels(
+        stbi_load_from_memory(file.bytes(), static_cast<int>(file.size()), &width, &height, &fileChannels, channels), stbi_image_free);
+    if (!pixels) { return chain; }
+
+    if (flip) {
+        flipImageVertically(pixels.get(), width, height, channels);
+    }
+    chain = generateMipChain(pixels.get(), width, height, channels, srgb, filter, pool);
+    if (cache) {
+        cache->store(key, chain);
+    }
+    return chain;
+}
+
+bool MipCache::load(const uint64_t key, MipChain &chain) const {
+    const std::filesystem::path path = _pathFor(key);
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) { return false; }
+
+    FileData file = FileData::open(path);
+    if (!file || file.size() < sizeof(Header)) { return false; }
+
+    Header header{};
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    MipChain loaded;
+    const bool valid = header.magic == MAGIC && header.version == VERSION && header.key == key
+        && header.width > 0 && header.height > 0 && header.channels >= 1 && header.channels <= 4
+        && header.type <= static_cast<uint32_t>(MipPixelType::Float)
+        && sizeof(Header) + loaded._layout(static_cast<int>(header.width), static_cast<int>(header.height), static_cast<int>(header.channels), static_cast<MipPixelType>(header.type)) == file.size();
+    if (!valid) {
+        file = {};
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    file.prefetch();
+    loaded.m_file = std::move(file);
+    loaded.m_fileOffset = sizeof(Header);
+    chain = std::move(loaded);
+    return true;
+}
+
+void MipCache::store(const uint64_t key, const MipChain &chain) const {
+    if (!chain.isValid()) { return; }
+
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+
+    // Unique per thread, two workers can finish the same image at once.
+    const std::filesystem::path path = _pathFor(key);
+    std::filesystem::path temp = path;
+    temp += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    const Header header = {
+        MAGIC, VERSION, key,
+        static_cast<uint32_t>(chain.getWidth()), static_cast<uint32_t>(chain.getHeight()),
+        static_cast<uint32_t>(chain.getChannels()), static_cast<uint32_t>(chain.getType()),
+    };
+
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(chain.levelData(0)), static_cast<std::streamsize>(chain.getByteSize()));
+    file.close();
+
+    if (!file) {
+        std::cout << "ERROR::MIP_CACHE::WRITE_FAILED " << temp.string() << std::endl;
+        std::filesystem::remove(temp, error);
+        return;
+    }
+
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::filesystem::remove(temp, error);
+    }
+}
+
+std::filesystem::path MipCache::_pathFor(const uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.mip", static_cast<unsigned long long>(key));
+    return m_directory / name;
+}
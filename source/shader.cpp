@@ -1,105 +1,173 @@
 #include "../headers/Shader.h"
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath) {
-    // Retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-
-    // Ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-	
-    try {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-
-        // Read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-
-        vShaderFile.close();
-        fShaderFile.close();
-
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
-    } catch(std::ifstream::failure &e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
-    }
+#include <algorithm>
 
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+Shader::Shader(const char *vertexPath, const char *fragmentPath, ProgramBinaryCache* binaryCache) :
+        m_vertexPath(vertexPath), m_fragmentPath(fragmentPath) {
+    // Retrieve the vertex/fragment source code from filePath, with includes resolved.
+    const ShaderPreprocessor preprocessor;
+    const ShaderSource vertexSource = preprocessor.process(vertexPath);
+    const ShaderSource fragmentSource = preprocessor.process(fragmentPath);
+    _setDependencies(vertexSource, fragmentSource);
 
-    // Compile shaders
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
+    ID = glCreateProgram();
 
-    // Vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
-
-     // Vertex Error Handling.
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if(!success) {
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
-
-    // Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-
-    // // Fragment Error Handling.
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+    // A cache hit skips compilation and linking entirely.
+    uint64_t cacheKey = 0;
+    if (binaryCache) {
+        cacheKey = binaryCache->makeKey(vertexSource.segments, fragmentSource.segments, "");
+        if (binaryCache->load(cacheKey, ID)) {
+            return;
+        }
     }
 
+    // Compile shaders
+    const unsigned int vertex = createStage(GL_VERTEX_SHADER, vertexSource);
+    const unsigned int fragment = createStage(GL_FRAGMENT_SHADER, fragmentSource);
+
+    checkStage(vertex, "VERTEX");
+    checkStage(fragment, "FRAGMENT");
+
     // Shader Program
-    ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if (binaryCache) {
+        binaryCache->prepareForLink(ID);
+    }
     glLinkProgram(ID);
 
-    // Handle Linking errors.
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if(!success) {
-        glGetProgramInfoLog(ID, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    if (!checkProgram(ID)) {
+        m_status = Status::Failed;
+    } else if (binaryCache) {
+        binaryCache->store(cacheKey, ID);
     }
 
     // Delete shaders after linking, they aren't needed anymore.
+    glDetachShader(ID, vertex);
+    glDetachShader(ID, fragment);
     glDeleteShader(vertex);
     glDeleteShader(fragment);
 }
 
+void Shader::_setDependencies(const ShaderSource &vertex, const ShaderSource &fragment) {
+    m_dependencies = vertex.dependencies;
+    for (const std::string& file : fragment.dependencies) {
+        if (std::find(m_dependencies.begin(), m_dependencies.end(), file) == m_dependencies.end()) {
+            m_dependencies.push_back(file);
+        }
+    }
+}
+
+std::string Shader::readSource(const char *path) {
+    const FileData file = FileData::open(path);
+    if (!file) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+        return {};
+    }
+    return std::string(file.view());
+}
+
+unsigned int Shader::createStage(const GLenum type, const std::string &code) {
+    const char* source = code.c_str();
+
+    const unsigned int stage = glCreateShader(type);
+    glShaderSource(stage, 1, &source, nullptr);
+    glCompileShader(stage);
+    return stage;
+}
+
+unsigned int Shader::createStage(const GLenum type, const ShaderSource &source) {
+    std::vector<const char*> strings(source.segments.size());
+    std::vector<GLint> lengths(source.segments.size());
+    for (size_t i = 0; i < source.segments.size(); ++i) {
+        strings[i] = source.segments[i].data();
+        lengths[i] = static_cast<GLint>(source.segments[i].size());
+    }
+
+    const unsigned int stage = glCreateShader(type);
+    glShaderSource(stage, static_cast<GLsizei>(strings.size()), strings.data(), lengths.data());
+    glCompileShader(stage);
+    return stage;
+}
+
+bool Shader::checkStage(const unsigned int stage, const char *stageName) {
+    int success;
+    char infoLog[512];
+
+    glGetShaderiv(stage, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(stage, 512, nullptr, infoLog);
+        std::cout << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return success;
+}
+
+bool Shader::checkProgram(const unsigned int program) {
+    int success;
+    char infoLog[512];
+
+    // Handle Linking errors.
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    return success;
+}
+
 void Shader::use() const {
     glUseProgram(ID);
 }
 
+const std::vector<int>& Shader::getUniformLocations(const std::span<const UniformField> fields) const {
+    if (m_uniformLocationsProgram != ID) {
+        m_uniformLocations.clear();
+        m_uniformLocationsProgram = ID;
+    }
+
+    auto it = m_uniformLocations.find(fields.data());
+    if (it == m_uniformLocations.end()) {
+        it = m_uniformLocations.emplace(fields.data(), resolveUniformLocations(ID, fields)).first;
+    }
+    return it->second;
+}
+
 void Shader::setBool(const std::string &name, const bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), static_cast<int>(value));
+    setInt(name, static_cast<int>(value));
 }
 
 void Shader::setInt(const std::string &name, const int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    const int location = glGetUniformLocation(ID, name.c_str());
+    if (location >= 0 && _shadow().update(location, &value, sizeof(value))) {
+        glUniform1i(location, value);
+    }
 }
 
 void Shader::setFloat(const std::string &name, const float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    const int location = glGetUniformLocation(ID, name.c_str());
+    if (location >= 0 && _shadow().update(location, &value, sizeof(value))) {
+        glUniform1f(location, value);
+    }
 }
 
 void Shader::setVector3(const std::string &name, const glm::vec3 &value) const {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	const int location = glGetUniformLocation(ID, name.c_str());
+	if (location >= 0 && _shadow().update(location, &value[0], sizeof(float) * 3)) {
+		glUniform3fv(location, 1, &value[0]);
+	}
 }
 
 void Shader::setMatrix4(const std::string &name, const glm::mat4 &value) const {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	const int location = glGetUniformLocation(ID, name.c_str());
+	if (location >= 0 && _shadow().update(location, &value[0][0], sizeof(float) * 16)) {
+		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+	}
 }
 
+UniformShadow& Shader::_shadow() const {
+    if (!m_shadow || m_shadowProgram != ID) {
+        m_shadow = &UniformShadow::forProgram(ID);
+        m_shadowProgram = ID;
+    }
+    return *m_shadow;
+}
@@ -0,0 +1,211 @@
+#include "../headers/ShaderBuildQueue.h"
+
+namespace {
+    // Drawn while the real program is still compiling. Same inputs and matrices as vertex.vs, flat grey output.
+    const char* FALLBACK_VERTEX = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
+)";
+
+    const char* FALLBACK_FRAGMENT = R"(#version 330 core
+out vec4 FragColor;
+
+void main() {
+    FragColor = vec4(0.5, 0.5, 0.5, 1.0);
+}
+)";
+}
+
+ShaderBuildQueue::ShaderBuildQueue(const GLADloadproc loader, ProgramBinaryCache* binaryCache) : m_binaryCache(binaryCache) {
+    const char* threadsFunction = nullptr;
+    if (hasGlExtension("GL_KHR_parallel_shader_compile")) {
+        threadsFunction = "glMaxShaderCompilerThreadsKHR";
+    } else if (hasGlExtension("GL_ARB_parallel_shader_compile")) {
+        threadsFunction = "glMaxShaderCompilerThreadsARB";
+    }
+
+    if (threadsFunction) {
+        m_parallelCompile = true;
+        // Let the driver pick how many threads to use.
+        if (const auto maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(loader(threadsFunction))) {
+            maxThreads(0xFFFFFFFFu);
+        }
+    }
+
+    _buildFallback();
+}
+
+std::shared_ptr<Shader> ShaderBuildQueue::submit(const char *vertexPath, const char *fragmentPath, const std::vector<std::string> &defines) {
+    std::shared_ptr<Shader> shader(new Shader());
+    shader->ID = m_fallbackProgram;
+    shader->m_status = Shader::Status::Pending;
+    shader->m_vertexPath = vertexPath;
+    shader->m_fragmentPath = fragmentPath;
+    shader->m_defines = defines;
+
+    const ShaderSource vertexSource = m_preprocessor.process(vertexPath, defines);
+    const ShaderSource fragmentSource = m_preprocessor.process(fragmentPath, defines);
+
+    // Dependencies are kept even on failure, so fixing a missing include through the watcher still works.
+    shader->_setDependencies(vertexSource, fragmentSource);
+    if (!vertexSource.success || !fragmentSource.success) {
+        shader->m_status = Shader::Status::Failed;
+        return shader;
+    }
+
+    _enqueue(shader, vertexSource, fragmentSource);
+    return shader;
+}
+
+void ShaderBuildQueue::rebuild(const std::shared_ptr<Shader> &shader, const ShaderSource &vertexSource, const ShaderSource &fragmentSource) {
+    shader->_setDependencies(vertexSource, fragmentSource);
+    _enqueue(shader, vertexSource, fragmentSource);
+}
+
+void ShaderBuildQueue::poll() {
+    if (!m_parallelCompile) {
+        finishAll();
+        return;
+    }
+
+    // Jobs still outstanding keep their submission order.
+    size_t kept = 0;
+    for (size_t i = 0; i < m_jobs.size(); ++i) {
+        if (_isComplete(m_jobs[i])) {
+            _finish(m_jobs[i]);
+        } else {
+            if (kept != i) { m_jobs[kept] = std::move(m_jobs[i]); }
+            ++kept;
+        }
+    }
+    m_jobs.erase(m_jobs.begin() + static_cast<std::ptrdiff_t>(kept), m_jobs.end());
+}
+
+void ShaderBuildQueue::finishAll() {
+    // Finish in submission order. Older rebuilds of a shader are dropped by _finish either way.
+    for (Job& job : m_jobs) {
+        _finish(job);
+    }
+    m_jobs.clear();
+}
+
+void ShaderBuildQueue::_enqueue(const std::shared_ptr<Shader> &shader, const ShaderSource &vertexSource, const ShaderSource &fragmentSource) {
+    Job job = { shader, glCreateProgram(), 0, 0, 0, ++shader->m_buildGeneration };
+
+    if (m_binaryCache) {
+        job.cacheKey = m_binaryCache->makeKey(vertexSource.segments, fragmentSource.segments, _joinDefines(shader->m_defines));
+        if (m_binaryCache->load(job.cacheKey, job.program)) {
+            _finish(job);
+            return;
+        }
+    }
+
+    // Issue everything now, nothing here waits on the driver.
+    job.vertex = Shader::createStage(GL_VERTEX_SHADER, vertexSource);
+    job.fragment = Shader::createStage(GL_FRAGMENT_SHADER, fragmentSource);
+
+    glAttachShader(job.program, job.vertex);
+    glAttachShader(job.program, job.fragment);
+    if (m_binaryCache) {
+        m_binaryCache->prepareForLink(job.program);
+    }
+    glLinkProgram(job.program);
+
+    m_jobs.push_back(std::move(job));
+}
+
+bool ShaderBuildQueue::_isComplete(const Job &job) const {
+    GLint done = GL_TRUE;
+    if (m_parallelCompile) {
+        glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &done);
+    }
+    return done == GL_TRUE;
+}
+
+void ShaderBuildQueue::_finish(Job &job) const {
+    // A newer build of this shader was queued after this one. Whichever order the driver finishes them in, only the
+    // newest source may end up in the shader.
+    if (job.generation != job.shader->m_buildGeneration) {
+        _discard(job);
+        return;
+    }
+
+    bool linked;
+    if (job.vertex == 0) {
+        // Restored from the binary cache, already checked by load().
+        linked = true;
+    } else {
+        Shader::checkStage(job.vertex, "VERTEX");
+        Shader::checkStage(job.fragment, "FRAGMENT");
+        linked = Shader::checkProgram(job.program);
+
+        glDetachShader(job.program, job.vertex);
+        glDetachShader(job.program, job.fragment);
+        glDeleteShader(job.vertex);
+        glDeleteShader(job.fragment);
+
+        if (linked && m_binaryCache) {
+            m_binaryCache->store(job.cacheKey, job.program);
+        }
+    }
+
+    Shader& shader = *job.shader;
+    if (linked) {
+        if (shader.ID != 0 && shader.ID != m_fallbackProgram) {
+            UniformShadow::release(shader.ID);
+            glDeleteProgram(shader.ID);
+        }
+        shader.ID = job.program;
+        shader.m_status = Shader::Status::Ready;
+    } else {
+        // Whatever the shader was drawing with before stays.
+        UniformShadow::release(job.program);
+        glDeleteProgram(job.program);
+        if (shader.m_status == Shader::Status::Pending) {
+            shader.m_status = Shader::Status::Failed;
+        }
+    }
+}
+
+void ShaderBuildQueue::_discard(const Job &job) {
+    if (job.vertex != 0) {
+        glDetachShader(job.program, job.vertex);
+        glDetachShader(job.program, job.fragment);
+        glDeleteShader(job.vertex);
+        glDeleteShader(job.fragment);
+    }
+    UniformShadow::release(job.program);
+    glDeleteProgram(job.program);
+}
+
+void ShaderBuildQueue::_buildFallback() {
+    const unsigned int vertex = Shader::createStage(GL_VERTEX_SHADER, FALLBACK_VERTEX);
+    const unsigned int fragment = Shader::createStage(GL_FRAGMENT_SHADER, FALLBACK_FRAGMENT);
+
+    m_fallbackProgram = glCreateProgram();
+    glAttachShader(m_fallbackProgram, vertex);
+    glAttachShader(m_fallbackProgram, fragment);
+    glLinkProgram(m_fallbackProgram);
+    Shader::checkProgram(m_fallbackProgram);
+
+    glDetachShader(m_fallbackProgram, vertex);
+    glDetachShader(m_fallbackProgram, fragment);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+}
+
+std::string ShaderBuildQueue::_joinDefines(const std::vector<std::string> &defines) {
+    std::string joined;
+    for (const std::string& define : defines) {
+        joined += define;
+        joined += '\n';
+    }
+    return joined;
+}
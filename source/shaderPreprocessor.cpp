@@ -0,0 +1,177 @@
+#include "../headers/ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <string_view>
+
+namespace {
+    std::string normalise(const std::filesystem::path& path) {
+        std::error_code error;
+        const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+        return error ? path.lexically_normal().string() : canonical.string();
+    }
+
+    // Returns the directive name if the line is a preprocessor directive, e.g. "include" for `  #  include "x"`.
+    std::string_view directiveOf(const std::string_view line, std::string_view& rest) {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string_view::npos || line[i] != '#') { return {}; }
+        i = line.find_first_not_of(" \t", i + 1);
+        if (i == std::string_view::npos) { return {}; }
+
+        size_t end = i;
+        while (end < line.size() && std::isalpha(static_cast<unsigned char>(line[end]))) { ++end; }
+        rest = line.substr(end);
+        return line.substr(i, end - i);
+    }
+}
+
+std::string ShaderSource::code() const {
+    std::string joined;
+    for (const std::string_view segment : segments) {
+        joined += segment;
+    }
+    return joined;
+}
+
+ShaderSource ShaderPreprocessor::process(const std::string &path, const std::vector<std::string> &defines) const {
+    std::string defineBlock;
+    for (const std::string& define : defines) {
+        const size_t equals = define.find('=');
+        if (equals == std::string::npos) {
+            defineBlock += "#define " + define + " 1\n";
+        } else {
+            defineBlock += "#define " + define.substr(0, equals) + " " + define.substr(equals + 1) + "\n";
+        }
+    }
+
+    ShaderSource result;
+    result.success = _append(path, result, defineBlock);
+    return result;
+}
+
+bool ShaderPreprocessor::_append(const std::filesystem::path &path, ShaderSource &result, const std::string &defineBlock) const {
+    FileData file = FileData::open(path);
+    if (!file) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path.string() << std::endl;
+        return false;
+    }
+    const std::string_view source = file.view();
+    result.files.push_back(std::move(file));
+
+    const int fileIndex = static_cast<int>(result.dependencies.size());
+    result.dependencies.push_back(normalise(path));
+    const bool isRoot = fileIndex == 0;
+    const size_t firstSegment = result.segments.size();
+
+    bool success = true;
+    bool definesInjected = !isRoot || defineBlock.empty();
+    int lineNumber = 0;
+
+    // Lines are passed through in runs, a run is only cut where a directive is dropped or text is injected.
+    size_t runStart = 0;
+    const auto flush = [&](const size_t runEnd) {
+        if (runEnd > runStart) {
+            result.segments.push_back(source.substr(runStart, runEnd - runStart));
+        }
+    };
+
+    for (size_t lineStart = 0; lineStart < source.size();) {
+        size_t lineEnd = source.find('\n', lineStart);
+        const size_t next = lineEnd == std::string_view::npos ? source.size() : lineEnd + 1;
+        if (lineEnd == std::string_view::npos) { lineEnd = source.size(); }
+        ++lineNumber;
+
+        std::string_view line = source.substr(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+
+        std::string_view rest;
+        const std::string_view directive = directiveOf(line, rest);
+
+        if (directive == "version") {
+            // Only the root file keeps its #version, and the defines have to come straight after it.
+            if (isRoot) {
+                flush(next);
+                std::string injected = definesInjected ? "" : defineBlock;
+                definesInjected = true;
+                _pushGenerated(result, injected + "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n");
+            } else {
+                flush(lineStart);
+            }
+            runStart = next;
+            lineStart = next;
+            continue;
+        }
+
+        if (!definesInjected && !directive.empty()) {
+            // No #version, so the defines go before the first directive instead.
+            flush(lineStart);
+            runStart = lineStart;
+            _pushGenerated(result, defineBlock + "#line " + std::to_string(lineNumber) + " " + std::to_string(fileIndex) + "\n");
+            definesInjected = true;
+        }
+
+        if (directive == "include") {
+            flush(lineStart);
+            runStart = next;
+            lineStart = next;
+
+            const size_t open = rest.find_first_of("\"<");
+            const size_t close = open == std::string_view::npos ? open : rest.find_first_of("\">", open + 1);
+            if (close == std::string_view::npos) {
+                std::cout << "ERROR::SHADER::MALFORMED_INCLUDE " << path.string() << ":" << lineNumber << std::endl;
+                success = false;
+                continue;
+            }
+
+            const std::string name(rest.substr(open + 1, close - open - 1));
+            const std::filesystem::path resolved = _resolve(name, path);
+            if (resolved.empty()) {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << name << " in " << path.string() << ":" << lineNumber << std::endl;
+                success = false;
+                continue;
+            }
+
+            const std::string key = normalise(resolved);
+            if (std::find(result.dependencies.begin(), result.dependencies.end(), key) != result.dependencies.end()) {
+                continue;
+            }
+
+            _pushGenerated(result, "#line 1 " + std::to_string(result.dependencies.size()) + "\n");
+            success = _append(resolved, result, defineBlock) && success;
+            _pushGenerated(result, "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n");
+            continue;
+        }
+
+        lineStart = next;
+    }
+    flush(source.size());
+
+    if (!definesInjected) {
+        result.generated.push_back(defineBlock);
+        result.segments.insert(result.segments.begin() + static_cast<std::ptrdiff_t>(firstSegment), result.generated.back());
+    }
+    return success;
+}
+
+void ShaderPreprocessor::_pushGenerated(ShaderSource &result, std::string text) {
+    // The previous file may not end in a newline, and a directive has to start its own line.
+    if (!result.segments.empty() && result.segments.back().back() != '\n') {
+        text.insert(0, "\n");
+    }
+    result.generated.push_back(std::move(text));
+    result.segments.push_back(result.generated.back());
+}
+
+std::filesystem::path ShaderPreprocessor::_resolve(const std::string &name, const std::filesystem::path &includer) const {
+    std::error_code error;
+
+    const std::filesystem::path local = includer.parent_path() / name;
+    if (std::filesystem::is_regular_file(local, error)) { return local; }
+
+    for (const std::filesystem::path& directory : m_includeDirectories) {
+        const std::filesystem::path candidate = directory / name;
+        if (std::filesystem::is_regular_file(candidate, error)) { return candidate; }
+    }
+    return {};
+}
@@ -0,0 +1,190 @@
+#include "../headers/ShaderWatcher.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::ShaderWatcher(ShaderBuildQueue &buildQueue) : m_buildQueue(buildQueue) {
+#ifdef __linux__
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotifyFd < 0 || m_wakeFd < 0) {
+        std::cout << "ERROR::SHADER_WATCHER::INIT_FAILED" << std::endl;
+        return;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&ShaderWatcher::_run, this);
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+    if (m_running) {
+        m_running = false;
+        const uint64_t wake = 1;
+        [[maybe_unused]] const ssize_t written = write(m_wakeFd, &wake, sizeof(wake));
+        m_thread.join();
+    }
+    if (m_inotifyFd >= 0) { close(m_inotifyFd); }
+    if (m_wakeFd >= 0) { close(m_wakeFd); }
+#endif
+}
+
+void ShaderWatcher::watch(const std::shared_ptr<Shader> &shader) {
+    if (shader->getDependencies().empty()) {
+        _watchFile(shader->getVertexPath(), shader);
+        _watchFile(shader->getFragmentPath(), shader);
+        return;
+    }
+
+    for (const std::string& file : shader->getDependencies()) {
+        _watchFile(file, shader);
+    }
+}
+
+void ShaderWatcher::applyPendingReloads() {
+    std::vector<Reload> reloads;
+    {
+        std::lock_guard lock(m_mutex);
+        reloads.swap(m_pending);
+    }
+
+    for (const Reload& reload : reloads) {
+        // A failed read usually means we caught the file mid save, the next write event will bring it back.
+        if (!reload.vertexSource.success || !reload.fragmentSource.success) { continue; }
+
+        std::cout << "Reloading shader " << reload.shader->getVertexPath() << " + " << reload.shader->getFragmentPath() << std::endl;
+        m_buildQueue.rebuild(reload.shader, reload.vertexSource, reload.fragmentSource);
+
+        // The edit may have added includes.
+        watch(reload.shader);
+    }
+}
+
+void ShaderWatcher::_watchFile(const std::filesystem::path &file, const std::shared_ptr<Shader> &shader) {
+#ifdef __linux__
+    if (m_inotifyFd < 0) { return; }
+
+    const std::string key = _normalise(file);
+    if (_isWatching(key, shader)) { return; }
+    const std::filesystem::path directory = std::filesystem::path(key).parent_path();
+
+    // Watch the directory rather than the file, editors often save by writing a new file and renaming it over the old one.
+    const int wd = inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        std::cout << "ERROR::SHADER_WATCHER::WATCH_FAILED " << directory.string() << std::endl;
+        return;
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_directories[wd] = directory;
+    m_shadersByFile[key].push_back(shader);
+#endif
+}
+
+bool ShaderWatcher::_isWatching(const std::string &file, const std::shared_ptr<Shader> &shader) {
+    std::lock_guard lock(m_mutex);
+    const auto it = m_shadersByFile.find(file);
+    if (it == m_shadersByFile.end()) { return false; }
+
+    return std::any_of(it->second.begin(), it->second.end(), [&shader](const std::weak_ptr<Shader>& watched) {
+        return watched.lock() == shader;
+    });
+}
+
+void ShaderWatcher::_run() {
+#ifdef __linux__
+    pollfd fds[2] = {
+        { m_inotifyFd, POLLIN, 0 },
+        { m_wakeFd, POLLIN, 0 }
+    };
+    alignas(inotify_event) char buffer[4096];
+    std::vector<std::string> changed;
+
+    while (m_running) {
+        // After the first event wait a moment for the rest of the save to land, editors often touch a file several times.
+        const int ready = poll(fds, 2, changed.empty() ? -1 : 50);
+        if (ready < 0) {
+            if (errno == EINTR) { continue; }
+            break;
+        }
+        if (fds[1].revents & POLLIN) { break; }
+
+        if (ready == 0) {
+            _reloadFiles(changed);
+            changed.clear();
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (const char* p = buffer; p < buffer + length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(p);
+                if (event->len > 0) {
+                    std::filesystem::path directory;
+                    {
+                        std::lock_guard lock(m_mutex);
+                        if (const auto it = m_directories.find(event->wd); it != m_directories.end()) {
+                            directory = it->second;
+                        }
+                    }
+                    if (!directory.empty()) {
+                        changed.push_back(_normalise(directory / event->name));
+                    }
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+#endif
+}
+
+void ShaderWatcher::_reloadFiles(const std::vector<std::string> &changedFiles) {
+    std::vector<std::shared_ptr<Shader>> affected;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const std::string& file : changedFiles) {
+            const auto it = m_shadersByFile.find(file);
+            if (it == m_shadersByFile.end()) { continue; }
+
+            std::erase_if(it->second, [](const std::weak_ptr<Shader>& shader) { return shader.expired(); });
+            for (const std::weak_ptr<Shader>& weak : it->second) {
+                std::shared_ptr<Shader> shader = weak.lock();
+                if (std::find(affected.begin(), affected.end(), shader) == affected.end()) {
+                    affected.push_back(std::move(shader));
+                }
+            }
+        }
+    }
+    if (affected.empty()) { return; }
+
+    // File reads and include resolution happen here on the watcher thread, the GL thread only gets the finished sources.
+    const ShaderPreprocessor& preprocessor = m_buildQueue.getPreprocessor();
+    std::vector<Reload> reloads;
+    for (std::shared_ptr<Shader>& shader : affected) {
+        ShaderSource vertexSource = preprocessor.process(shader->getVertexPath(), shader->getDefines());
+        ShaderSource fragmentSource = preprocessor.process(shader->getFragmentPath(), shader->getDefines());
+        reloads.push_back({ std::move(shader), std::move(vertexSource), std::move(fragmentSource) });
+    }
+
+    std::lock_guard lock(m_mutex);
+    for (Reload& reload : reloads) {
+        m_pending.push_back(std::move(reload));
+    }
+}
+
+std::string ShaderWatcher::_normalise(const std::filesystem::path &path) {
+    std::error_code error;
+    std::filesystem::path normalised = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        normalised = std::filesystem::absolute(path, error).lexically_normal();
+    }
+    return normalised.string();
+}
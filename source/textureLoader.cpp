@@ -0,0 +1,312 @@
+#include "../headers/TextureLoader.h"
+
+#include <algorithm>
+
+namespace {
+    // Two tone grey checker, drawn until the real texture is uploaded.
+    constexpr unsigned char PLACEHOLDER_PIXELS[] = {
+        96, 96, 96, 255,    160, 160, 160, 255,
+        160, 160, 160, 255, 96, 96, 96, 255,
+    };
+
+    void setSamplingParameters() {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+}
+
+TextureLoader::TextureLoader(MipCache* mipCache, const unsigned int workerCount) : m_mipCache(mipCache), m_pool(workerCount) {
+    _buildPlaceholder();
+}
+
+TextureLoader::~TextureLoader() {
+    // Jobs still queued see this and return, m_pool then waits for any already decoding.
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::string &path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip, FileData file) {
+    std::shared_ptr<Texture> texture(new Texture());
+    texture->ID = m_placeholder;
+    texture->m_status = Texture::Status::Pending;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_requests.push_back({ texture, path, internalFormat, format, type, flip, m_mipFilter, std::move(file) });
+    }
+    m_pool.submit([this] { _work(); });
+    return texture;
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::shared_ptr<const TexturePack> &pack, const std::string &name) {
+    std::shared_ptr<Texture> texture(new Texture());
+    texture->ID = m_placeholder;
+    texture->m_status = Texture::Status::Pending;
+
+    Decoded decoded{};
+    decoded.packEntry = pack ? pack->find(name) : nullptr;
+    if (!decoded.packEntry) {
+        std::cout << "ERROR::TEXTURE_PACK::NOT_FOUND " << name << std::endl;
+    } else {
+        decoded.pack = pack;
+        decoded.request.internalFormat = decoded.packEntry->internalFormat;
+        decoded.request.format = decoded.packEntry->format;
+        decoded.request.type = decoded.packEntry->type;
+    }
+    decoded.request.texture = texture;
+    decoded.request.path = name;
+
+    // Nothing to decode, so it goes straight to the upload queue, update() fails it there if it wasn't found.
+    m_uploads.push_back({ std::move(decoded) });
+    return texture;
+}
+
+void TextureLoader::update(const std::chrono::microseconds budget) {
+    const auto start = std::chrono::steady_clock::now();
+
+    while (true) {
+        {
+            std::lock_guard lock(m_mutex);
+            while (!m_decoded.empty()) {
+                m_uploads.push_back({ std::move(m_decoded.front()) });
+                m_decoded.pop_front();
+            }
+        }
+        if (m_uploads.empty()) { return; }
+
+        Upload& upload = m_uploads.front();
+        const GLenum compressedFormat = upload.image.compressedFormat();
+        if (!upload.image.isValid()) {
+            _fail(upload);
+            m_uploads.pop_front();
+            continue;
+        }
+
+        // Nobody holds the texture anymore, don't bother uploading it.
+        if (upload.image.request.texture.use_count() == 1) {
+            if (upload.texture != 0) { glDeleteTextures(1, &upload.texture); }
+            m_uploads.pop_front();
+            continue;
+        }
+
+        if (compressedFormat != 0 && upload.texture == 0) {
+            auto support = m_formatSupport.find(compressedFormat);
+            if (support == m_formatSupport.end()) {
+                support = m_formatSupport.emplace(compressedFormat, isCompressedFormatSupported(compressedFormat)).first;
+            }
+            if (!support->second) {
+                std::cout << "ERROR::TEXTURE::COMPRESSED_FORMAT_UNSUPPORTED " << upload.image.request.path << std::endl;
+                _fail(upload);
+                m_uploads.pop_front();
+                continue;
+            }
+        }
+
+        if (upload.texture == 0) {
+            _createTexture(upload);
+        }
+
+        if (compressedFormat != 0 ? _uploadLevel(upload) : _uploadBand(upload)) {
+            _finish(upload);
+            m_uploads.pop_front();
+        }
+
+        if (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) >= budget) {
+            return;
+        }
+    }
+}
+
+void TextureLoader::finishAll() {
+    while (true) {
+        update(std::chrono::microseconds::max());
+
+        std::unique_lock lock(m_mutex);
+        if (m_requests.empty() && m_decoding == 0 && m_decoded.empty()) {
+            break;
+        }
+        m_decodedReady.wait(lock, [this] { return !m_decoded.empty(); });
+    }
+}
+
+size_t TextureLoader::getPendingCount() const {
+    std::lock_guard lock(m_mutex);
+    return m_requests.size() + m_decoding + m_decoded.size() + m_uploads.size();
+}
+
+// One job per load() call, each takes the oldest request.
+void TextureLoader::_work() {
+    Request request;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_stopping || m_requests.empty()) { return; }
+
+        request = std::move(m_requests.front());
+        m_requests.pop_front();
+        ++m_decoding;
+    }
+
+    Decoded decoded = _decode(std::move(request));
+
+    {
+        std::lock_guard lock(m_mutex);
+        --m_decoding;
+        m_decoded.push_back(std::move(decoded));
+    }
+    m_decodedReady.notify_all();
+}
+
+TextureLoader::Decoded TextureLoader::_decode(Request request) {
+    Decoded decoded;
+    FileData file = request.file ? std::move(request.file) : FileData::open(request.path);
+
+    if (isCompressedTexturePath(request.path)) {
+        // Nothing to decode, the levels upload straight out of the file.
+        loadCompressedImage(std::move(file), decoded.compressed);
+    } else if (file) {
+        // Rows are shared out over the pool, this job works on them too.
+        decoded.mips = loadMipChain(file, channelsForFormat(request.format), isSrgbFormat(request.internalFormat), request.flip, request.mipFilter, m_mipCache, &m_pool);
+    }
+
+    decoded.request = std::move(request);
+    return decoded;
+}
+
+void TextureLoader::_createTexture(Upload &upload) {
+    glGenTextures(1, &upload.texture);
+    glBindTexture(GL_TEXTURE_2D, upload.texture);
+    setSamplingParameters();
+
+    const Decoded& image = upload.image;
+    if (image.compressedFormat() != 0) {
+        // Levels come from the file, so tell GL how many to expect.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levelCount()) - 1);
+        if (image.levelCount() == 1) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        }
+        return;
+    }
+
+    // Allocate the whole chain up front, the bands then only ever fill it in.
+    const Request& request = image.request;
+    for (size_t level = 0; level < image.levelCount(); ++level) {
+        const LevelView info = image.level(level);
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), request.internalFormat, info.width, info.height, 0, request.format, request.type, nullptr);
+    }
+}
+
+bool TextureLoader::_uploadBand(Upload &upload) {
+    const LevelView info = upload.image.level(upload.level);
+    const size_t rowSize = info.size / info.height;
+    const int rows = std::min(info.height - upload.rowsDone, static_cast<int>(std::max<size_t>(1, BAND_SIZE / rowSize)));
+
+    unsigned int buffer;
+    const void* pixels = _stage(info.data + rowSize * upload.rowsDone, rowSize * rows, buffer);
+
+    glBindTexture(GL_TEXTURE_2D, upload.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(upload.level), 0, upload.rowsDone, info.width, rows, upload.image.request.format, upload.image.request.type, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    _unstage(buffer);
+
+    upload.rowsDone += rows;
+    if (upload.rowsDone >= info.height) {
+        ++upload.level;
+        upload.rowsDone = 0;
+    }
+    return upload.level >= upload.image.levelCount();
+}
+
+bool TextureLoader::_uploadLevel(Upload &upload) {
+    const size_t level = upload.level;
+    const LevelView info = upload.image.level(level);
+
+    unsigned int buffer;
+    const void* data = _stage(info.data, info.size, buffer);
+
+    glBindTexture(GL_TEXTURE_2D, upload.texture);
+    glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), upload.image.compressedFormat(), info.width, info.height, 0, static_cast<GLsizei>(info.size), data);
+    _unstage(buffer);
+
+    ++upload.level;
+    return upload.level >= upload.image.levelCount();
+}
+
+const void* TextureLoader::_stage(const unsigned char *source, const size_t bytes, unsigned int &buffer) {
+    if (m_freeBuffers.empty()) {
+        glGenBuffers(1, &buffer);
+    } else {
+        buffer = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+
+    // Orphan the buffer so the driver never waits on a previous upload that still reads from it.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bytes), nullptr, GL_STREAM_DRAW);
+    void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    if (staging) {
+        std::memcpy(staging, source, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        return nullptr;
+    }
+
+    // Couldn't map, upload straight from client memory instead.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return source;
+}
+
+void TextureLoader::_unstage(const unsigned int buffer) {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_freeBuffers.push_back(buffer);
+}
+
+void TextureLoader::_finish(Upload &upload) const {
+    Texture& texture = *upload.image.request.texture;
+    texture.ID = upload.texture;
+    texture.m_status = Texture::Status::Ready;
+}
+
+void TextureLoader::_fail(Upload &upload) const {
+    std::cout << "ERROR::TEXTURE::LOAD_FAILED " << upload.image.request.path << std::endl;
+
+    if (upload.texture != 0) {
+        glDeleteTextures(1, &upload.texture);
+    }
+    upload.image.request.texture->m_status = Texture::Status::Failed;
+}
+
+GLenum TextureLoader::Decoded::compressedFormat() const {
+    if (packEntry) { return packEntry->isCompressed() ? static_cast<GLenum>(packEntry->internalFormat) : 0; }
+    return compressed.levels.empty() ? 0 : compressed.internalFormat;
+}
+
+size_t TextureLoader::Decoded::levelCount() const {
+    if (packEntry) { return packEntry->levels.size(); }
+    return compressed.levels.empty() ? mips.getLevelCount() : compressed.levels.size();
+}
+
+TextureLoader::LevelView TextureLoader::Decoded::level(const size_t index) const {
+    if (packEntry) {
+        const TexturePackLevel& info = packEntry->levels[index];
+        return { pack->levelData(info), info.size, info.width, info.height };
+    }
+    if (!compressed.levels.empty()) {
+        const CompressedLevel& info = compressed.levels[index];
+        return { compressed.levelData(index), info.size, info.width, info.height };
+    }
+    const MipLevel& info = mips.getLevel(index);
+    return { mips.levelData(index), info.size, info.width, info.height };
+}
+
+void TextureLoader::_buildPlaceholder() {
+    glGenTextures(1, &m_placeholder);
+    glBindTexture(GL_TEXTURE_2D, m_placeholder);
+    setSamplingParameters();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXELS);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
@@ -0,0 +1,214 @@
+#include "../headers/TexturePack.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    GLenum formatForChannels(const int channels) {
+        switch (channels) {
+            case 1: return GL_RED;
+            case 2: return GL_RG;
+            case 3: return GL_RGB;
+            default: return GL_RGBA;
+        }
+    }
+
+    GLint internalFormatFor(const int channels, const bool srgb) {
+        switch (channels) {
+            case 1: return GL_R8;
+            case 2: return GL_RG8;
+            case 3: return srgb ? GL_SRGB8 : GL_RGB8;
+            default: return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        }
+    }
+
+    // Bytes per pixel of an uncompressed entry, 0 for anything a pack never holds.
+    size_t bytesPerPixel(const GLenum format, const GLenum type) {
+        if (type != GL_UNSIGNED_BYTE) { return 0; }
+        switch (format) {
+            case GL_RED: return 1;
+            case GL_RG: return 2;
+            case GL_RGB: return 3;
+            case GL_RGBA: return 4;
+            default: return 0;
+        }
+    }
+
+    // Whether [offset, offset + size) lies inside the file, checked without forming a sum that could wrap.
+    bool inFile(const FileData& file, const uint64_t offset, const uint64_t size) {
+        return offset <= file.size() && size <= file.size() - offset;
+    }
+}
+
+bool TexturePack::load(const std::filesystem::path &path, TexturePack &pack) {
+    FileData file = FileData::open(path);
+    if (!file) { return false; }
+
+    Header header{};
+    if (file.size() < sizeof(header)) {
+        std::cout << "ERROR::TEXTURE_PACK::DAMAGED " << path.string() << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        std::cout << "ERROR::TEXTURE_PACK::WRONG_VERSION " << path.string() << std::endl;
+        return false;
+    }
+
+    const uint64_t levelTable = sizeof(Header) + sizeof(EntryRecord) * static_cast<uint64_t>(header.entryCount);
+    const uint64_t nameBlock = levelTable + sizeof(LevelRecord) * static_cast<uint64_t>(header.levelCount);
+    if (nameBlock > file.size()) {
+        std::cout << "ERROR::TEXTURE_PACK::DAMAGED " << path.string() << std::endl;
+        return false;
+    }
+
+    TexturePack loaded;
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        EntryRecord record{};
+        std::memcpy(&record, file.data() + sizeof(Header) + sizeof(EntryRecord) * i, sizeof(record));
+        if (record.firstLevel > header.levelCount || record.levelCount > header.levelCount - record.firstLevel ||
+            !inFile(file, nameBlock + record.nameOffset, record.nameLength)) {
+            std::cout << "ERROR::TEXTURE_PACK::DAMAGED " << path.string() << std::endl;
+            return false;
+        }
+
+        TexturePackEntry entry = { static_cast<GLint>(record.internalFormat), record.format, record.type, {} };
+        const size_t pixelSize = entry.isCompressed() ? 0 : bytesPerPixel(entry.format, entry.type);
+        for (uint32_t level = 0; level < record.levelCount; ++level) {
+            LevelRecord levelRecord{};
+            std::memcpy(&levelRecord, file.data() + levelTable + sizeof(LevelRecord) * (static_cast<uint64_t>(record.firstLevel) + level), sizeof(levelRecord));
+
+            // Uncompressed levels are uploaded a band of rows at a time, so their size has to be exactly the pixels.
+            const bool validSize = entry.isCompressed()
+                ? levelRecord.size > 0
+                : pixelSize != 0 && levelRecord.size == static_cast<uint64_t>(levelRecord.width) * levelRecord.height * pixelSize;
+            if (levelRecord.width == 0 || levelRecord.height == 0 || levelRecord.width > MAX_DIMENSION || levelRecord.height > MAX_DIMENSION ||
+                !validSize || !inFile(file, levelRecord.offset, levelRecord.size)) {
+                std::cout << "ERROR::TEXTURE_PACK::DAMAGED " << path.string() << std::endl;
+                return false;
+            }
+            entry.levels.push_back({ levelRecord.offset, levelRecord.size, static_cast<int>(levelRecord.width), static_cast<int>(levelRecord.height) });
+        }
+
+        loaded.m_entries.emplace(std::string(file.data() + nameBlock + record.nameOffset, record.nameLength), std::move(entry));
+    }
+
+    // Every texture is likely to be wanted soon, so have the OS start reading it all in now.
+    file.prefetch();
+    loaded.m_file = std::move(file);
+    pack = std::move(loaded);
+    return true;
+}
+
+const TexturePackEntry* TexturePack::find(const std::string &name) const {
+    const auto it = m_entries.find(name);
+    return it == m_entries.end() ? nullptr : &it->second;
+}
+
+bool TexturePack::isUpToDate(const std::filesystem::path &directory, const std::filesystem::path &packPath) {
+    std::error_code error;
+    const auto packTime = std::filesystem::last_write_time(packPath, error);
+    if (error) { return false; }
+
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (!it->is_regular_file(error)) { continue; }
+        if (it->last_write_time(error) > packTime) { return false; }
+    }
+    return !error;
+}
+
+void TexturePackWriter::add(const std::string &name, const MipChain &chain, const bool srgb) {
+    if (!chain.isValid() || chain.getType() != MipPixelType::UnsignedByte) { return; }
+
+    const int channels = chain.getChannels();
+    Pending texture = { name, { internalFormatFor(channels, srgb), formatForChannels(channels), GL_UNSIGNED_BYTE, {} }, {} };
+    for (size_t level = 0; level < chain.getLevelCount(); ++level) {
+        const MipLevel& info = chain.getLevel(level);
+        texture.entry.levels.push_back({ info.offset, info.size, info.width, info.height });
+    }
+    texture.data.assign(chain.levelData(0), chain.levelData(0) + chain.getByteSize());
+    m_textures.push_back(std::move(texture));
+}
+
+void TexturePackWriter::add(const std::string &name, const CompressedImage &image) {
+    if (image.levels.empty()) { return; }
+
+    Pending texture = { name, { static_cast<GLint>(image.internalFormat), 0, 0, {} }, {} };
+    for (size_t level = 0; level < image.levels.size(); ++level) {
+        const CompressedLevel& info = image.levels[level];
+        texture.entry.levels.push_back({ texture.data.size(), info.size, info.width, info.height });
+        texture.data.insert(texture.data.end(), image.levelData(level), image.levelData(level) + info.size);
+    }
+    m_textures.push_back(std::move(texture));
+}
+
+bool TexturePackWriter::save(const std::filesystem::path &path) const {
+    using Header = TexturePack::Header;
+    using EntryRecord = TexturePack::EntryRecord;
+    using LevelRecord = TexturePack::LevelRecord;
+
+    std::vector<EntryRecord> entries;
+    std::vector<LevelRecord> levels;
+    std::string names;
+    for (const Pending& texture : m_textures) {
+        entries.push_back({
+            static_cast<uint32_t>(names.size()), static_cast<uint32_t>(texture.name.size()),
+            static_cast<uint32_t>(levels.size()), static_cast<uint32_t>(texture.entry.levels.size()),
+            static_cast<uint32_t>(texture.entry.internalFormat), texture.entry.format, texture.entry.type, 0,
+        });
+        names += texture.name;
+        for (const TexturePackLevel& level : texture.entry.levels) {
+            levels.push_back({ level.offset, level.size, static_cast<uint32_t>(level.width), static_cast<uint32_t>(level.height) });
+        }
+    }
+
+    // Level offsets become absolute once the size of everything in front of the data is known.
+    const auto alignUp = [](const size_t value) { return (value + TexturePack::DATA_ALIGNMENT - 1) / TexturePack::DATA_ALIGNMENT * TexturePack::DATA_ALIGNMENT; };
+    const size_t indexSize = sizeof(Header) + sizeof(EntryRecord) * entries.size() + sizeof(LevelRecord) * levels.size() + names.size();
+    size_t dataOffset = alignUp(indexSize);
+    for (size_t i = 0, level = 0; i < m_textures.size(); ++i) {
+        for (size_t j = 0; j < m_textures[i].entry.levels.size(); ++j, ++level) {
+            levels[level].offset += dataOffset;
+        }
+        dataOffset = alignUp(dataOffset + m_textures[i].data.size());
+    }
+
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+
+    const Header header = { TexturePack::MAGIC, TexturePack::VERSION, static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(levels.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(sizeof(EntryRecord) * entries.size()));
+    file.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(sizeof(LevelRecord) * levels.size()));
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+    const char zeros[TexturePack::DATA_ALIGNMENT] = {};
+    size_t written = indexSize;
+    for (const Pending& texture : m_textures) {
+        file.write(zeros, static_cast<std::streamsize>(alignUp(written) - written));
+        file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+        written = alignUp(written) + texture.data.size();
+    }
+    file.close();
+
+    if (!file) {
+        std::cout << "ERROR::TEXTURE_PACK::WRITE_FAILED " << temp.string() << std::endl;
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+
+    std::filesystem::rename(temp, path, error);
+    if (error) {
+        std::cout << "ERROR::TEXTURE_PACK::WRITE_FAILED " << path.string() << std::endl;
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,326 @@
+#include "../headers/TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+TextureStreamer::TextureStreamer(TextureLoader &loader, const size_t budgetBytes) :
+    m_loader(loader), m_budget(budgetBytes), m_completed(std::make_shared<Completed>()) {}
+
+std::shared_ptr<Texture> TextureStreamer::load(const std::string &path, const GLint internalFormat, const GLenum format, const GLenum type, const bool flip, FileData file) {
+    std::shared_ptr<Texture> texture(new Texture());
+    texture->ID = m_loader.getPlaceholder();
+    texture->m_status = Texture::Status::Pending;
+    texture->m_streamed = true;
+
+    const auto entry = std::make_shared<Entry>();
+    entry->texture = texture;
+    entry->path = path;
+    entry->internalFormat = internalFormat;
+    entry->format = format;
+    entry->type = type;
+    m_entries[texture.get()] = entry;
+
+    // The job only holds shared state, so it can finish after the streamer is gone. Jobs have to be copyable, so an
+    // already open file goes in behind a shared_ptr.
+    m_loader.getJobPool().submit([completed = m_completed, weak = std::weak_ptr(entry), path, flip, opened = std::make_shared<FileData>(std::move(file)),
+                                  channels = channelsForFormat(format), srgb = isSrgbFormat(internalFormat),
+                                  filter = m_loader.getMipFilter(), cache = m_loader.getMipCache(), pool = &m_loader.getJobPool()] {
+        const FileData source = *opened ? std::move(*opened) : FileData::open(path);
+        Decoded decoded = { weak, loadMipChain(source, channels, srgb, flip, filter, cache, pool) };
+
+        std::lock_guard lock(completed->mutex);
+        completed->decoded.push_back(std::move(decoded));
+    });
+    return texture;
+}
+
+void TextureStreamer::requestScreenSize(const Texture &texture, const float pixels) {
+    if (const auto it = m_entries.find(&texture); it != m_entries.end()) {
+        it->second->screenSize = std::max(it->second->screenSize, pixels);
+    }
+}
+
+void TextureStreamer::requestObject(const Object3D &object, const glm::mat4 &view, const glm::mat4 &projection, const float viewportHeight) {
+    if (!object.mesh || object.textures.empty()) { return; }
+
+    const glm::vec4 centre = view * object.getModelMatrix() * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const float scale = std::max({ std::abs(object.scale.x), std::abs(object.scale.y), std::abs(object.scale.z) });
+    const float radius = object.mesh->getBoundingRadius() * scale;
+    const float depth = -centre.z;
+    if (depth + radius <= 0.0f) { return; }
+
+    // Projected diameter, projection[1][1] being the focal length in half viewport heights. Anything closer than its
+    // radius is taken to fill the view.
+    const float pixels = radius * projection[1][1] * viewportHeight / std::max(depth, radius);
+    for (const std::shared_ptr<Texture>& texture : object.textures) {
+        requestScreenSize(*texture, pixels);
+    }
+}
+
+void TextureStreamer::update(const std::chrono::microseconds budget) {
+    const auto start = std::chrono::steady_clock::now();
+
+    _receiveDecoded();
+    _releaseUnused();
+    _chooseTargets();
+
+    // Room is normally made as levels are needed, this only does anything after the budget was lowered.
+    while (m_resident > m_budget && _evictOne()) {}
+
+    do {
+        if (!m_upload.entry && !_beginUpload()) { return; }
+
+        if (_uploadBand()) {
+            Entry& entry = *m_upload.entry;
+            entry.baseLevel = m_upload.level;
+            glBindTexture(GL_TEXTURE_2D, entry.texture->ID);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.baseLevel));
+
+            ++m_levelsStreamed;
+            m_upload = {};
+        }
+    } while (std::chrono::steady_clock::now() - start < budget);
+}
+
+TextureStreamer::Stats TextureStreamer::getStats() const {
+    return { m_resident, m_budget, m_entries.size(), m_levelsStreamed, m_levelsEvicted };
+}
+
+size_t TextureStreamer::_levelBytes(const Entry &entry, const size_t level) {
+    const MipLevel& info = entry.mips.getLevel(level);
+    const int channels = entry.mips.getChannels();
+    return static_cast<size_t>(info.width) * info.height * (channels == 3 ? 4 : channels);
+}
+
+float TextureStreamer::_oversampling(const Entry &entry, const size_t level) {
+    if (entry.drawnSize <= 0.0f) { return std::numeric_limits<float>::max(); }
+
+    const MipLevel& info = entry.mips.getLevel(level);
+    return static_cast<float>(std::max(info.width, info.height)) / entry.drawnSize;
+}
+
+void TextureStreamer::_receiveDecoded() {
+    std::deque<Decoded> decoded;
+    {
+        std::lock_guard lock(m_completed->mutex);
+        decoded.swap(m_completed->decoded);
+    }
+
+    for (Decoded& result : decoded) {
+        const std::shared_ptr<Entry> entry = result.entry.lock();
+        if (!entry) { continue; }
+
+        if (!result.mips.isValid()) {
+            std::cout << "ERROR::TEXTURE::LOAD_FAILED " << entry->path << std::endl;
+            entry->texture->m_status = Texture::Status::Failed;
+            continue;
+        }
+
+        entry->mips = std::move(result.mips);
+        const MipChain& mips = entry->mips;
+        entry->tailLevel = mips.getLevelCount() - 1;
+        while (entry->tailLevel > 0) {
+            const MipLevel& info = mips.getLevel(entry->tailLevel - 1);
+            if (std::max(info.width, info.height) > TAIL_SIZE) { break; }
+            --entry->tailLevel;
+        }
+
+        unsigned int id;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry->tailLevel));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(mips.getLevelCount()) - 1);
+
+        // Levels above the base are left undefined, they don't count towards completeness until streamed in.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (size_t level = entry->tailLevel; level < mips.getLevelCount(); ++level) {
+            const MipLevel& info = mips.getLevel(level);
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry->internalFormat, info.width, info.height, 0, entry->format, entry->type, mips.levelData(level));
+            entry->residentBytes += _levelBytes(*entry, level);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        m_resident += entry->residentBytes;
+        entry->baseLevel = entry->tailLevel;
+        entry->targetLevel = entry->tailLevel;
+        entry->texture->ID = id;
+        entry->texture->m_status = Texture::Status::Ready;
+    }
+}
+
+void TextureStreamer::_releaseUnused() {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        // The entry's own reference is the last one.
+        if (it->second->texture.use_count() > 1) {
+            ++it;
+            continue;
+        }
+
+        if (m_upload.entry == it->second) {
+            _cancelUpload();
+        }
+        _destroy(*it->second);
+        it = m_entries.erase(it);
+    }
+}
+
+void TextureStreamer::_chooseTargets() {
+    size_t total = 0;
+    for (const auto& [texture, entry] : m_entries) {
+        if (!entry->mips.isValid()) { continue; }
+
+        if (entry->screenSize > 0.0f) {
+            entry->lastScreenSize = entry->screenSize;
+            entry->framesUnseen = 0;
+        } else if (entry->framesUnseen < std::numeric_limits<unsigned int>::max()) {
+            ++entry->framesUnseen;
+        }
+        entry->drawnSize = entry->framesUnseen < UNSEEN_FRAMES ? entry->lastScreenSize : 0.0f;
+        entry->screenSize = 0.0f;
+
+        // One texel per pixel, for a texture spread once across the object.
+        entry->targetLevel = entry->tailLevel;
+        if (entry->drawnSize > 0.0f) {
+            const float texels = static_cast<float>(std::max(entry->mips.getWidth(), entry->mips.getHeight()));
+            const float level = std::floor(std::log2(texels / entry->drawnSize));
+            entry->targetLevel = static_cast<size_t>(std::clamp(level, 0.0f, static_cast<float>(entry->tailLevel)));
+        }
+
+        for (size_t level = entry->targetLevel; level < entry->mips.getLevelCount(); ++level) {
+            total += _levelBytes(*entry, level);
+        }
+    }
+
+    // Over budget, step back whichever texture has the most texels per pixel until it all fits.
+    while (total > m_budget) {
+        Entry* coarsest = nullptr;
+        float coarsestOversampling = 0.0f;
+        for (const auto& [texture, entry] : m_entries) {
+            if (!entry->mips.isValid() || entry->targetLevel >= entry->tailLevel) { continue; }
+
+            const float oversampling = _oversampling(*entry, entry->targetLevel);
+            if (!coarsest || oversampling > coarsestOversampling) {
+                coarsest = entry.get();
+                coarsestOversampling = oversampling;
+            }
+        }
+        if (!coarsest) { break; }
+
+        total -= _levelBytes(*coarsest, coarsest->targetLevel);
+        ++coarsest->targetLevel;
+    }
+}
+
+bool TextureStreamer::_evictOne() {
+    Entry* spare = nullptr;
+    float spareOversampling = 0.0f;
+    for (const auto& [texture, entry] : m_entries) {
+        if (!entry->mips.isValid() || entry->baseLevel >= entry->targetLevel) { continue; }
+
+        // Off screen ones all compare equal, so the one gone longest goes first.
+        const float oversampling = _oversampling(*entry, entry->baseLevel);
+        if (!spare || oversampling > spareOversampling ||
+            (oversampling == spareOversampling && entry->framesUnseen > spare->framesUnseen)) {
+            spare = entry.get();
+            spareOversampling = oversampling;
+        }
+    }
+    if (!spare) { return false; }
+
+    _evictLevel(*spare);
+    return true;
+}
+
+bool TextureStreamer::_beginUpload() {
+    std::shared_ptr<Entry> blurriest;
+    float blurriestOversampling = 0.0f;
+    for (const auto& [texture, entry] : m_entries) {
+        if (!entry->mips.isValid() || entry->baseLevel <= entry->targetLevel) { continue; }
+
+        const float oversampling = _oversampling(*entry, entry->baseLevel);
+        if (!blurriest || oversampling < blurriestOversampling) {
+            blurriest = entry;
+            blurriestOversampling = oversampling;
+        }
+    }
+    if (!blurriest) { return false; }
+
+    // Targets fit the budget together, so whatever has to go to make room is wanted less than this.
+    const size_t level = blurriest->baseLevel - 1;
+    const size_t bytes = _levelBytes(*blurriest, level);
+    while (m_resident + bytes > m_budget) {
+        if (!_evictOne()) { return false; }
+    }
+
+    const MipLevel& info = blurriest->mips.getLevel(level);
+    glBindTexture(GL_TEXTURE_2D, blurriest->texture->ID);
+    glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), blurriest->internalFormat, info.width, info.height, 0, blurriest->format, blurriest->type, nullptr);
+
+    blurriest->residentBytes += bytes;
+    m_resident += bytes;
+    m_upload = { blurriest, level, 0 };
+    return true;
+}
+
+bool TextureStreamer::_uploadBand() {
+    const Entry& entry = *m_upload.entry;
+    const MipLevel& info = entry.mips.getLevel(m_upload.level);
+    const size_t rowSize = static_cast<size_t>(info.width) * entry.mips.getChannels();
+    const int rows = std::min(info.height - m_upload.rowsDone, static_cast<int>(std::max<size_t>(1, TextureLoader::BAND_SIZE / rowSize)));
+
+    glBindTexture(GL_TEXTURE_2D, entry.texture->ID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(m_upload.level), 0, m_upload.rowsDone, info.width, rows, entry.format, entry.type,
+                    entry.mips.levelData(m_upload.level) + rowSize * m_upload.rowsDone);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    m_upload.rowsDone += rows;
+    return m_upload.rowsDone >= info.height;
+}
+
+void TextureStreamer::_cancelUpload() {
+    Entry& entry = *m_upload.entry;
+    const size_t bytes = _levelBytes(entry, m_upload.level);
+
+    if (entry.texture->isReady()) {
+        glBindTexture(GL_TEXTURE_2D, entry.texture->ID);
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(m_upload.level), entry.internalFormat, 0, 0, 0, entry.format, entry.type, nullptr);
+    }
+    entry.residentBytes -= bytes;
+    m_resident -= bytes;
+    m_upload = {};
+}
+
+void TextureStreamer::_evictLevel(Entry &entry) {
+    // The level being streamed sits just above the base, it would be left stranded.
+    if (m_upload.entry.get() == &entry) {
+        _cancelUpload();
+    }
+
+    const size_t level = entry.baseLevel++;
+    const size_t bytes = _levelBytes(entry, level);
+
+    // Move the base first so the texture never samples a level that is gone, then give the memory back.
+    glBindTexture(GL_TEXTURE_2D, entry.texture->ID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(entry.baseLevel));
+    glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), entry.internalFormat, 0, 0, 0, entry.format, entry.type, nullptr);
+
+    entry.residentBytes -= bytes;
+    m_resident -= bytes;
+    ++m_levelsEvicted;
+}
+
+void TextureStreamer::_destroy(Entry &entry) {
+    // Failed and still decoding textures only ever had the placeholder.
+    if (entry.texture->isReady()) {
+        entry.texture->destroy();
+    }
+    m_resident -= entry.residentBytes;
+    entry.residentBytes = 0;
+}
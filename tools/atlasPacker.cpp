@@ -0,0 +1,68 @@
+// AtlasPacker: packs the images listed in an atlas manifest into a cooked atlas file ahead of time, so the game only
+// maps it in (PackedAtlas::load) instead of decoding, packing and filtering at startup.
+//
+//   AtlasPacker [--page N] [--padding N] [--srgb] [--no-flip] [--kaiser] [--force] <manifest> <output>
+//
+// The output is left alone when it is already newer than the manifest and every image in it, unless --force is given.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+
+#include <iostream>
+#include <string>
+
+#include "AtlasBuilder.h"
+
+int main(const int argc, char** argv) {
+    AtlasOptions options;
+    bool force = false;
+    std::string manifest;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--page" && hasValue) {
+            options.pageSize = std::stoi(argv[++i]);
+        } else if (argument == "--padding" && hasValue) {
+            options.padding = std::stoi(argv[++i]);
+        } else if (argument == "--srgb") {
+            options.srgb = true;
+        } else if (argument == "--no-flip") {
+            options.flip = false;
+        } else if (argument == "--kaiser") {
+            options.filter = MipFilter::Kaiser;
+        } else if (argument == "--force") {
+            force = true;
+        } else if (manifest.empty()) {
+            manifest = argument;
+        } else if (output.empty()) {
+            output = argument;
+        } else {
+            manifest.clear();
+            break;
+        }
+    }
+
+    if (manifest.empty() || output.empty() || options.pageSize <= 0) {
+        std::cerr << "Usage: AtlasPacker [--page N] [--padding N] [--srgb] [--no-flip] [--kaiser] [--force] <manifest> <output>" << std::endl;
+        return 1;
+    }
+
+    if (!force && AtlasBuilder::isUpToDate(manifest, output)) {
+        std::cout << output << " is up to date" << std::endl;
+        return 0;
+    }
+
+    AtlasBuilder builder(options);
+    PackedAtlas atlas;
+    JobPool pool;
+    if (!builder.addManifest(manifest) || !builder.build(atlas, &pool) || !atlas.save(output)) {
+        return 1;
+    }
+
+    std::cout << output << ": " << atlas.getRegions().size() << " images on " << atlas.getLayerCount() << " "
+              << atlas.getPageSize() << "x" << atlas.getPageSize() << " pages, " << atlas.getLevelCount() << " levels" << std::endl;
+    return 0;
+}
@@ -0,0 +1,252 @@
+// ShaderReflect: scans GLSL sources for uniform declarations and writes ShaderUniforms.h, one struct per file that
+// declares uniforms. Run by the build whenever a shader changes, see CMakeLists.txt.
+//
+//   ShaderReflect <output header> <shader files...>
+//
+// Struct names come from the file name, so shaders/include/camera.glsl gives uniforms::Camera. Uniforms shared
+// between shaders belong in an include, every shader that includes it can then be bound with the same struct.
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct TypeInfo {
+        const char* cppType;
+        const char* uniformType;
+    };
+
+    // Samplers are set by texture unit, so they map to int like they do in glUniform1i.
+    const std::map<std::string, TypeInfo> TYPES = {
+        { "float", { "float", "Float" } },
+        { "int", { "int", "Int" } },
+        { "bool", { "int", "Int" } },
+        { "uint", { "unsigned int", "UInt" } },
+        { "vec2", { "glm::vec2", "Vec2" } },
+        { "vec3", { "glm::vec3", "Vec3" } },
+        { "vec4", { "glm::vec4", "Vec4" } },
+        { "ivec2", { "glm::ivec2", "IVec2" } },
+        { "ivec3", { "glm::ivec3", "IVec3" } },
+        { "ivec4", { "glm::ivec4", "IVec4" } },
+        { "mat3", { "glm::mat3", "Mat3" } },
+        { "mat4", { "glm::mat4", "Mat4" } },
+    };
+
+    struct Uniform {
+        std::string type;
+        std::string name;
+        int count;
+    };
+
+    struct UniformFile {
+        std::string path;
+        std::string structName;
+        std::vector<Uniform> uniforms;
+    };
+
+    std::string stripComments(const std::string& source) {
+        std::string result;
+        result.reserve(source.size());
+
+        for (size_t i = 0; i < source.size(); ++i) {
+            if (source.compare(i, 2, "//") == 0) {
+                while (i < source.size() && source[i] != '\n') { ++i; }
+                result += '\n';
+            } else if (source.compare(i, 2, "/*") == 0) {
+                const size_t end = source.find("*/", i + 2);
+                i = end == std::string::npos ? source.size() : end + 1;
+                result += ' ';
+            } else {
+                result += source[i];
+            }
+        }
+        return result;
+    }
+
+    // Splits into identifiers, numbers and single punctuation characters.
+    std::vector<std::string> tokenise(const std::string& source) {
+        std::vector<std::string> tokens;
+        for (size_t i = 0; i < source.size();) {
+            const unsigned char c = source[i];
+            if (std::isspace(c)) {
+                ++i;
+            } else if (std::isalnum(c) || c == '_') {
+                const size_t start = i;
+                while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) { ++i; }
+                tokens.push_back(source.substr(start, i - start));
+            } else {
+                tokens.emplace_back(1, source[i]);
+                ++i;
+            }
+        }
+        return tokens;
+    }
+
+    bool isSampler(const std::string& type) {
+        return type.find("sampler") != std::string::npos || type.find("image") != std::string::npos;
+    }
+
+    bool parseUniforms(const std::string& path, std::vector<Uniform>& uniforms) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "ERROR::SHADER_REFLECT::FILE_NOT_READ " << path << std::endl;
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+
+        // Preprocessor lines are left out, uniforms behind #ifdef are still reflected since some permutation uses them.
+        std::string code;
+        std::istringstream lines(stripComments(stream.str()));
+        for (std::string line; std::getline(lines, line);) {
+            const size_t first = line.find_first_not_of(" \t");
+            if (first != std::string::npos && line[first] == '#') { continue; }
+            code += line + '\n';
+        }
+
+        const std::vector<std::string> tokens = tokenise(code);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i] != "uniform") { continue; }
+
+            // Skip precision qualifiers.
+            size_t t = i + 1;
+            while (t < tokens.size() && (tokens[t] == "highp" || tokens[t] == "mediump" || tokens[t] == "lowp")) { ++t; }
+            if (t >= tokens.size()) { break; }
+
+            const std::string type = tokens[t++];
+            if (t < tokens.size() && tokens[t] == "{") {
+                std::cerr << "WARNING::SHADER_REFLECT::UNIFORM_BLOCK_SKIPPED " << type << " in " << path << std::endl;
+                continue;
+            }
+
+            const bool sampler = isSampler(type);
+            if (!sampler && TYPES.find(type) == TYPES.end()) {
+                std::cerr << "WARNING::SHADER_REFLECT::UNSUPPORTED_TYPE " << type << " in " << path << std::endl;
+                continue;
+            }
+
+            // uniform type a, b[4];
+            while (t < tokens.size()) {
+                Uniform uniform = { sampler ? "int" : type, tokens[t++], 1 };
+                if (t + 2 < tokens.size() && tokens[t] == "[" && tokens[t + 2] == "]") {
+                    uniform.count = std::stoi(tokens[t + 1]);
+                    t += 3;
+                }
+                uniforms.push_back(uniform);
+
+                if (t < tokens.size() && tokens[t] == ",") {
+                    ++t;
+                    continue;
+                }
+                break;
+            }
+            i = t;
+        }
+        return true;
+    }
+
+    std::string structNameFor(const std::filesystem::path& path) {
+        std::string name;
+        bool upper = true;
+        for (const char c : path.stem().string()) {
+            if (!std::isalnum(static_cast<unsigned char>(c))) {
+                upper = true;
+                continue;
+            }
+            name += upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+            upper = false;
+        }
+        if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+            name.insert(0, "Shader");
+        }
+        return name;
+    }
+
+    std::string generate(const std::vector<UniformFile>& files) {
+        std::ostringstream out;
+        out << "// Generated by ShaderReflect from the GLSL sources, do not edit.\n";
+        out << "#ifndef SHADERUNIFORMS_H\n#define SHADERUNIFORMS_H\n\n";
+        out << "#include <cstddef>\n#include <span>\n\n#include <glm/glm.hpp>\n\n#include \"UniformBinding.h\"\n\n";
+        out << "namespace uniforms {\n";
+
+        for (size_t f = 0; f < files.size(); ++f) {
+            const UniformFile& file = files[f];
+            if (f > 0) { out << "\n"; }
+
+            out << "    // " << file.path << "\n";
+            out << "    struct " << file.structName << " {\n";
+            for (const Uniform& uniform : file.uniforms) {
+                out << "        " << TYPES.at(uniform.type).cppType << " " << uniform.name;
+                if (uniform.count > 1) { out << "[" << uniform.count << "]"; }
+                out << "{};\n";
+            }
+
+            out << "\n        static std::span<const UniformField> fields() {\n";
+            out << "            static constexpr UniformField FIELDS[] = {\n";
+            for (const Uniform& uniform : file.uniforms) {
+                out << "                { \"" << uniform.name << "\", UniformType::" << TYPES.at(uniform.type).uniformType
+                    << ", offsetof(" << file.structName << ", " << uniform.name << "), " << uniform.count << " },\n";
+            }
+            out << "            };\n";
+            out << "            return FIELDS;\n";
+            out << "        }\n";
+            out << "    };\n";
+        }
+
+        out << "}\n\n#endif //SHADERUNIFORMS_H\n";
+        return out.str();
+    }
+}
+
+int main(const int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: ShaderReflect <output header> <shader files...>" << std::endl;
+        return 1;
+    }
+
+    std::vector<UniformFile> files;
+    std::map<std::string, std::string> structOwners;
+    bool success = true;
+
+    for (int i = 2; i < argc; ++i) {
+        UniformFile file = { argv[i], structNameFor(argv[i]), {} };
+        if (!parseUniforms(file.path, file.uniforms)) {
+            success = false;
+            continue;
+        }
+        if (file.uniforms.empty()) { continue; }
+
+        if (const auto [it, inserted] = structOwners.emplace(file.structName, file.path); !inserted) {
+            std::cerr << "ERROR::SHADER_REFLECT::NAME_CLASH " << file.structName << " from " << file.path << " and " << it->second << std::endl;
+            success = false;
+            continue;
+        }
+        files.push_back(std::move(file));
+    }
+    if (!success) { return 1; }
+
+    const std::string header = generate(files);
+
+    // Leave the file alone when nothing changed, so everything including it doesn't rebuild.
+    const std::filesystem::path outputPath = argv[1];
+    if (std::ifstream existing(outputPath); existing) {
+        std::stringstream current;
+        current << existing.rdbuf();
+        if (current.str() == header) { return 0; }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(outputPath.parent_path(), error);
+    std::ofstream output(outputPath, std::ios::trunc);
+    output << header;
+    if (!output) {
+        std::cerr << "ERROR::SHADER_REFLECT::WRITE_FAILED " << outputPath.string() << std::endl;
+        return 1;
+    }
+    return 0;
+}
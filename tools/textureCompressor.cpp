@@ -0,0 +1,611 @@
+// TextureCompressor: converts PNG (or anything stb_image reads) into block compressed DDS files the TextureLoader
+// uploads without decoding. Self contained, blocks are encoded on every core.
+//
+//   TextureCompressor [--format auto|bc1|bc3|bc4|bc5|bc7] [--srgb] [--flip] [--no-mips] [--threads N] [-o dir] inputs...
+//
+// Inputs may be files or directories, directories are searched for .png files. auto picks BC7 for images with alpha
+// and BC1 otherwise. --flip stores the image bottom up like the loader does for PNGs, compressed files can't be
+// flipped at load time. Mips are box filtered, in linear space when --srgb is given.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    enum class Format { Auto, BC1, BC3, BC4, BC5, BC7 };
+
+    struct Options {
+        Format format = Format::Auto;
+        bool srgb = false;
+        bool flip = false;
+        bool mips = true;
+        unsigned int threads = 0;
+        std::filesystem::path outputDirectory;
+        std::vector<std::filesystem::path> inputs;
+    };
+
+    struct Image {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> rgba;
+    };
+
+    // 4x4 texels, RGBA8, row major.
+    using Block = uint8_t[16][4];
+
+    // ---- Shared helpers ----
+
+    int squaredDistance(const uint8_t* a, const uint8_t* b, const int channels) {
+        int sum = 0;
+        for (int c = 0; c < channels; ++c) {
+            const int d = a[c] - b[c];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    // Mean and principal axis of the block's colours, by power iteration on the covariance matrix.
+    void principalAxis(const Block& block, const int channels, float mean[4], float axis[4]) {
+        for (int c = 0; c < 4; ++c) { mean[c] = 0.0f; axis[c] = 0.0f; }
+        for (const auto& texel : block) {
+            for (int c = 0; c < channels; ++c) { mean[c] += texel[c] / 16.0f; }
+        }
+
+        float covariance[4][4] = {};
+        for (const auto& texel : block) {
+            float d[4];
+            for (int c = 0; c < channels; ++c) { d[c] = texel[c] - mean[c]; }
+            for (int i = 0; i < channels; ++i) {
+                for (int j = 0; j < channels; ++j) { covariance[i][j] += d[i] * d[j]; }
+            }
+        }
+
+        float v[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            float next[4] = {};
+            for (int i = 0; i < channels; ++i) {
+                for (int j = 0; j < channels; ++j) { next[i] += covariance[i][j] * v[j]; }
+            }
+            float length = 0.0f;
+            for (int c = 0; c < channels; ++c) { length += next[c] * next[c]; }
+            if (length < 1e-12f) { break; }
+            length = 1.0f / std::sqrt(length);
+            for (int c = 0; c < channels; ++c) { v[c] = next[c] * length; }
+        }
+        for (int c = 0; c < channels; ++c) { axis[c] = v[c]; }
+    }
+
+    // Endpoints at the extremes of the block projected onto its principal axis.
+    void axisEndpoints(const Block& block, const int channels, const bool* include, float low[4], float high[4]) {
+        float mean[4], axis[4];
+        principalAxis(block, channels, mean, axis);
+
+        float minT = 1e30f, maxT = -1e30f;
+        for (int i = 0; i < 16; ++i) {
+            if (include && !include[i]) { continue; }
+            float t = 0.0f;
+            for (int c = 0; c < channels; ++c) { t += (block[i][c] - mean[c]) * axis[c]; }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        if (minT > maxT) { minT = maxT = 0.0f; }
+
+        for (int c = 0; c < channels; ++c) {
+            low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+            high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+        }
+    }
+
+    // ---- BC1 ----
+
+    uint16_t to565(const float* c) {
+        const int r = std::clamp(static_cast<int>(std::lround(c[0] * 31.0f / 255.0f)), 0, 31);
+        const int g = std::clamp(static_cast<int>(std::lround(c[1] * 63.0f / 255.0f)), 0, 63);
+        const int b = std::clamp(static_cast<int>(std::lround(c[2] * 31.0f / 255.0f)), 0, 31);
+        return static_cast<uint16_t>(r << 11 | g << 5 | b);
+    }
+
+    void from565(const uint16_t c, uint8_t* out) {
+        const int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+        out[0] = static_cast<uint8_t>(r << 3 | r >> 2);
+        out[1] = static_cast<uint8_t>(g << 2 | g >> 4);
+        out[2] = static_cast<uint8_t>(b << 3 | b >> 2);
+        out[3] = 255;
+    }
+
+    // Palette as the decoder builds it.
+    void bc1Palette(const uint16_t c0, const uint16_t c1, const bool fourColour, uint8_t palette[4][4]) {
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            if (fourColour) {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+            } else {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = fourColour ? 255 : 0;
+    }
+
+    uint32_t bc1Indices(const Block& block, const uint8_t palette[4][4], const int paletteSize, const bool* transparent, int& error) {
+        uint32_t indices = 0;
+        error = 0;
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestError = 1 << 30;
+            if (transparent && transparent[i]) {
+                best = 3;
+                bestError = 0;
+            } else {
+                for (int p = 0; p < paletteSize; ++p) {
+                    const int e = squaredDistance(block[i], palette[p], 3);
+                    if (e < bestError) { bestError = e; best = p; }
+                }
+            }
+            error += bestError;
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+        return indices;
+    }
+
+    // Least squares endpoints for fixed indices, weights are where each index sits between the endpoints.
+    bool refineEndpoints(const Block& block, const int channels, const int* selectors, const float* weights, const bool* include, float low[4], float high[4]) {
+        float aa = 0, ab = 0, bb = 0, ax[4] = {}, bx[4] = {};
+        for (int i = 0; i < 16; ++i) {
+            if (include && !include[i]) { continue; }
+            const float b = weights[selectors[i]];
+            const float a = 1.0f - b;
+            aa += a * a; ab += a * b; bb += b * b;
+            for (int c = 0; c < channels; ++c) {
+                ax[c] += a * block[i][c];
+                bx[c] += b * block[i][c];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) { return false; }
+
+        const float inverse = 1.0f / determinant;
+        for (int c = 0; c < channels; ++c) {
+            low[c] = std::clamp((ax[c] * bb - bx[c] * ab) * inverse, 0.0f, 255.0f);
+            high[c] = std::clamp((bx[c] * aa - ax[c] * ab) * inverse, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    // forceFourColour is for BC3's colour half, which always decodes as four colours.
+    void encodeBC1(const Block& block, uint8_t* out, const bool forceFourColour) {
+        bool transparent[16];
+        bool opaque[16];
+        bool anyTransparent = false;
+        for (int i = 0; i < 16; ++i) {
+            transparent[i] = !forceFourColour && block[i][3] < 128;
+            opaque[i] = !transparent[i];
+            anyTransparent |= transparent[i];
+        }
+
+        float low[4], high[4];
+        axisEndpoints(block, 3, opaque, low, high);
+
+        uint16_t c0 = 0, c1 = 0;
+        uint32_t indices = 0;
+        int bestError = 1 << 30;
+
+        // Try the fitted endpoints, then one least squares refinement from the resulting indices.
+        for (int pass = 0; pass < 2; ++pass) {
+            uint16_t a = to565(high), b = to565(low);
+            const bool fourColour = !anyTransparent;
+            // Four colour mode needs c0 > c1, three colour mode c0 <= c1.
+            if (fourColour ? a < b : a > b) { std::swap(a, b); }
+
+            // Equal endpoints decode as three colour mode, which is fine since every index then picks the same colour.
+            uint8_t palette[4][4];
+            bc1Palette(a, b, fourColour && a != b, palette);
+            int error;
+            const uint32_t candidate = bc1Indices(block, palette, fourColour && a != b ? 4 : 3, anyTransparent ? transparent : nullptr, error);
+
+            if (error < bestError) {
+                bestError = error;
+                c0 = a; c1 = b; indices = candidate;
+            }
+            if (pass == 1 || a == b) { break; }
+
+            // Where each index sits from c1 (low) to c0 (high), so the refit lines up with whichever way round they ended.
+            int selectors[16];
+            for (int i = 0; i < 16; ++i) { selectors[i] = candidate >> (2 * i) & 3; }
+            constexpr float FOUR_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+            constexpr float THREE_WEIGHTS[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+            if (!refineEndpoints(block, 3, selectors, fourColour ? FOUR_WEIGHTS : THREE_WEIGHTS, opaque, low, high)) { break; }
+        }
+
+        out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+        out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+        for (int i = 0; i < 4; ++i) { out[4 + i] = indices >> (8 * i) & 0xFF; }
+    }
+
+    // ---- BC4 ----
+
+    void encodeBC4(const Block& block, const int channel, uint8_t* out) {
+        int low = 255, high = 0;
+        for (const auto& texel : block) {
+            low = std::min<int>(low, texel[channel]);
+            high = std::max<int>(high, texel[channel]);
+        }
+
+        // Eight value mode, a0 > a1. A flat block just uses a0 = a1 with every index 0.
+        int palette[8] = { high, low };
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * high + i * low) / 7;
+        }
+
+        uint64_t bits = 0;
+        if (high != low) {
+            for (int i = 0; i < 16; ++i) {
+                int best = 0, bestError = 1 << 30;
+                for (int p = 0; p < 8; ++p) {
+                    const int e = std::abs(block[i][channel] - palette[p]);
+                    if (e < bestError) { bestError = e; best = p; }
+                }
+                bits |= static_cast<uint64_t>(best) << (3 * i);
+            }
+        }
+
+        out[0] = static_cast<uint8_t>(high);
+        out[1] = static_cast<uint8_t>(low);
+        for (int i = 0; i < 6; ++i) { out[2 + i] = bits >> (8 * i) & 0xFF; }
+    }
+
+    // ---- BC7, mode 6: one subset, RGBA 7.7.7.7 endpoints with a p bit each, 4 bit indices ----
+
+    constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct BitWriter {
+        uint8_t* out;
+        int position = 0;
+
+        void write(uint32_t value, const int count) {
+            for (int i = 0; i < count; ++i, ++position, value >>= 1) {
+                if (value & 1) { out[position >> 3] |= static_cast<uint8_t>(1 << (position & 7)); }
+            }
+        }
+    };
+
+    // Picks the 7 bit value and shared p bit that best reproduce an RGBA endpoint.
+    void quantiseBC7Endpoint(const float* colour, uint8_t quantised[4], int& pBit) {
+        int bestError = 1 << 30;
+        for (int p = 0; p < 2; ++p) {
+            int error = 0;
+            uint8_t candidate[4];
+            for (int c = 0; c < 4; ++c) {
+                const int q = std::clamp(static_cast<int>(std::lround((colour[c] - p) / 2.0f)), 0, 127);
+                candidate[c] = static_cast<uint8_t>(q);
+                const int d = (q << 1 | p) - static_cast<int>(std::lround(colour[c]));
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                pBit = p;
+                std::memcpy(quantised, candidate, 4);
+            }
+        }
+    }
+
+    void encodeBC7(const Block& block, uint8_t* out) {
+        float low[4], high[4];
+        axisEndpoints(block, 4, nullptr, low, high);
+
+        uint8_t q0[4], q1[4];
+        int p0 = 0, p1 = 0;
+        int indices[16] = {};
+        int bestError = 1 << 30;
+        uint8_t best0[4] = {}, best1[4] = {};
+        int bestP0 = 0, bestP1 = 0, bestIndices[16] = {};
+
+        for (int pass = 0; pass < 2; ++pass) {
+            quantiseBC7Endpoint(low, q0, p0);
+            quantiseBC7Endpoint(high, q1, p1);
+
+            uint8_t e0[4], e1[4], palette[16][4];
+            for (int c = 0; c < 4; ++c) {
+                e0[c] = static_cast<uint8_t>(q0[c] << 1 | p0);
+                e1[c] = static_cast<uint8_t>(q1[c] << 1 | p1);
+            }
+            for (int i = 0; i < 16; ++i) {
+                for (int c = 0; c < 4; ++c) {
+                    palette[i][c] = static_cast<uint8_t>(((64 - BC7_WEIGHTS[i]) * e0[c] + BC7_WEIGHTS[i] * e1[c] + 32) >> 6);
+                }
+            }
+
+            int error = 0;
+            for (int i = 0; i < 16; ++i) {
+                int bestIndex = 0, bestTexelError = 1 << 30;
+                for (int p = 0; p < 16; ++p) {
+                    const int e = squaredDistance(block[i], palette[p], 4);
+                    if (e < bestTexelError) { bestTexelError = e; bestIndex = p; }
+                }
+                indices[i] = bestIndex;
+                error += bestTexelError;
+            }
+
+            if (error < bestError) {
+                bestError = error;
+                std::memcpy(best0, q0, 4); std::memcpy(best1, q1, 4);
+                bestP0 = p0; bestP1 = p1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+            if (pass == 1) { break; }
+
+            float weights[16];
+            for (int i = 0; i < 16; ++i) { weights[i] = BC7_WEIGHTS[i] / 64.0f; }
+            if (!refineEndpoints(block, 4, indices, weights, nullptr, low, high)) { break; }
+        }
+
+        // The first index is stored with its top bit implied zero, so flip the block round if it's set.
+        if (bestIndices[0] & 8) {
+            std::swap(best0, best1);
+            std::swap(bestP0, bestP1);
+            for (int& index : bestIndices) { index = 15 - index; }
+        }
+
+        std::memset(out, 0, 16);
+        BitWriter writer{ out };
+        writer.write(1u << 6, 7);
+        for (int c = 0; c < 4; ++c) {
+            writer.write(best0[c], 7);
+            writer.write(best1[c], 7);
+        }
+        writer.write(bestP0, 1);
+        writer.write(bestP1, 1);
+        writer.write(bestIndices[0], 3);
+        for (int i = 1; i < 16; ++i) { writer.write(bestIndices[i], 4); }
+    }
+
+    // ---- Images ----
+
+    float toLinear(const uint8_t value) {
+        const float c = value / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    uint8_t fromLinear(const float value) {
+        const float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::clamp(std::lround(c * 255.0f), 0l, 255l));
+    }
+
+    Image downsample(const Image& source, const bool srgb) {
+        Image result;
+        result.width = std::max(1, source.width / 2);
+        result.height = std::max(1, source.height / 2);
+        result.rgba.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+        for (int y = 0; y < result.height; ++y) {
+            for (int x = 0; x < result.width; ++x) {
+                float sum[4] = {};
+                for (int dy = 0; dy < 2; ++dy) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        const int sx = std::min(x * 2 + dx, source.width - 1);
+                        const int sy = std::min(y * 2 + dy, source.height - 1);
+                        const uint8_t* texel = &source.rgba[(static_cast<size_t>(sy) * source.width + sx) * 4];
+                        for (int c = 0; c < 4; ++c) {
+                            sum[c] += srgb && c < 3 ? toLinear(texel[c]) : texel[c];
+                        }
+                    }
+                }
+                uint8_t* out = &result.rgba[(static_cast<size_t>(y) * result.width + x) * 4];
+                for (int c = 0; c < 4; ++c) {
+                    out[c] = srgb && c < 3 ? fromLinear(sum[c] / 4.0f) : static_cast<uint8_t>(std::lround(sum[c] / 4.0f));
+                }
+            }
+        }
+        return result;
+    }
+
+    size_t blockSize(const Format format) {
+        return format == Format::BC1 || format == Format::BC4 ? 8 : 16;
+    }
+
+    std::vector<uint8_t> compress(const Image& image, const Format format, const unsigned int threadCount) {
+        const int blocksX = (image.width + 3) / 4;
+        const int blocksY = (image.height + 3) / 4;
+        const size_t bytesPerBlock = blockSize(format);
+        std::vector<uint8_t> output(static_cast<size_t>(blocksX) * blocksY * bytesPerBlock);
+
+        // Workers pull block rows off a shared counter.
+        std::atomic<int> nextRow = 0;
+        const auto work = [&] {
+            for (int by = nextRow++; by < blocksY; by = nextRow++) {
+                for (int bx = 0; bx < blocksX; ++bx) {
+                    Block block;
+                    for (int i = 0; i < 16; ++i) {
+                        // Edge blocks repeat the last row and column.
+                        const int x = std::min(bx * 4 + (i & 3), image.width - 1);
+                        const int y = std::min(by * 4 + (i >> 2), image.height - 1);
+                        std::memcpy(block[i], &image.rgba[(static_cast<size_t>(y) * image.width + x) * 4], 4);
+                    }
+
+                    uint8_t* out = &output[(static_cast<size_t>(by) * blocksX + bx) * bytesPerBlock];
+                    switch (format) {
+                        case Format::BC1: encodeBC1(block, out, false); break;
+                        case Format::BC3: encodeBC4(block, 3, out); encodeBC1(block, out + 8, true); break;
+                        case Format::BC4: encodeBC4(block, 0, out); break;
+                        case Format::BC5: encodeBC4(block, 0, out); encodeBC4(block, 1, out + 8); break;
+                        default: encodeBC7(block, out); break;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < std::min<unsigned int>(threadCount, blocksY); ++i) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (std::thread& thread : threads) { thread.join(); }
+        return output;
+    }
+
+    uint32_t dxgiFormat(const Format format, const bool srgb) {
+        switch (format) {
+            case Format::BC1: return srgb ? 72 : 71;
+            case Format::BC3: return srgb ? 78 : 77;
+            case Format::BC4: return 80;
+            case Format::BC5: return 83;
+            default: return srgb ? 99 : 98;
+        }
+    }
+
+    bool writeDds(const std::filesystem::path& path, const Image& base, const std::vector<std::vector<uint8_t>>& levels, const Format format, const bool srgb) {
+        uint32_t header[32] = {};
+        header[0] = 0x20534444; // "DDS "
+        header[1] = 124;
+        header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+        header[3] = static_cast<uint32_t>(base.height);
+        header[4] = static_cast<uint32_t>(base.width);
+        header[5] = static_cast<uint32_t>(levels[0].size());
+        header[7] = static_cast<uint32_t>(levels.size());
+        header[19] = 32;
+        header[20] = 0x4;        // DDPF_FOURCC
+        header[21] = 0x30315844; // "DX10"
+        header[27] = 0x1000 | (levels.size() > 1 ? 0x8 | 0x400000 : 0);
+
+        const uint32_t dx10[5] = { dxgiFormat(format, srgb), 3, 0, 1, 0 };
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(dx10), sizeof(dx10));
+        for (const std::vector<uint8_t>& level : levels) {
+            file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+        }
+        return static_cast<bool>(file);
+    }
+
+    bool convert(const std::filesystem::path& input, const Options& options) {
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(input.string().c_str(), &width, &height, &channels, 4);
+        if (!pixels) {
+            std::cerr << "ERROR::TEXTURE_COMPRESSOR::LOAD_FAILED " << input.string() << std::endl;
+            return false;
+        }
+
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.rgba.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(pixels);
+
+        if (options.flip) {
+            const size_t rowSize = static_cast<size_t>(width) * 4;
+            for (int y = 0; y < height / 2; ++y) {
+                std::swap_ranges(image.rgba.begin() + rowSize * y, image.rgba.begin() + rowSize * (y + 1), image.rgba.begin() + rowSize * (height - 1 - y));
+            }
+        }
+
+        Format format = options.format;
+        if (format == Format::Auto) {
+            bool hasAlpha = false;
+            for (size_t i = 3; i < image.rgba.size() && !hasAlpha; i += 4) { hasAlpha = image.rgba[i] != 255; }
+            format = hasAlpha ? Format::BC7 : Format::BC1;
+        }
+
+        std::vector<std::vector<uint8_t>> levels;
+        levels.push_back(compress(image, format, options.threads));
+        if (options.mips) {
+            Image level = image;
+            while (level.width > 1 || level.height > 1) {
+                level = downsample(level, options.srgb);
+                levels.push_back(compress(level, format, options.threads));
+            }
+        }
+
+        const std::filesystem::path directory = options.outputDirectory.empty() ? input.parent_path() : options.outputDirectory;
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        const std::filesystem::path output = directory / input.filename().replace_extension(".dds");
+
+        if (!writeDds(output, image, levels, format, options.srgb)) {
+            std::cerr << "ERROR::TEXTURE_COMPRESSOR::WRITE_FAILED " << output.string() << std::endl;
+            return false;
+        }
+
+        size_t bytes = 0;
+        for (const auto& level : levels) { bytes += level.size(); }
+        std::cout << input.string() << " -> " << output.string() << " (" << width << "x" << height << ", "
+                  << levels.size() << " levels, " << bytes / 1024 << " KiB)" << std::endl;
+        return true;
+    }
+
+    bool parseArguments(const int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (argument == "--format" && hasValue) {
+                const std::string value = argv[++i];
+                if (value == "auto") { options.format = Format::Auto; }
+                else if (value == "bc1") { options.format = Format::BC1; }
+                else if (value == "bc3") { options.format = Format::BC3; }
+                else if (value == "bc4") { options.format = Format::BC4; }
+                else if (value == "bc5") { options.format = Format::BC5; }
+                else if (value == "bc7") { options.format = Format::BC7; }
+                else { return false; }
+            } else if (argument == "--srgb") {
+                options.srgb = true;
+            } else if (argument == "--flip") {
+                options.flip = true;
+            } else if (argument == "--no-mips") {
+                options.mips = false;
+            } else if (argument == "--threads" && hasValue) {
+                options.threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (argument == "-o" && hasValue) {
+                options.outputDirectory = argv[++i];
+            } else if (!argument.empty() && argument[0] == '-') {
+                return false;
+            } else {
+                options.inputs.emplace_back(argument);
+            }
+        }
+        return !options.inputs.empty();
+    }
+}
+
+int main(const int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::cerr << "Usage: TextureCompressor [--format auto|bc1|bc3|bc4|bc5|bc7] [--srgb] [--flip] [--no-mips] [--threads N] [-o dir] inputs..." << std::endl;
+        return 1;
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<std::filesystem::path> files;
+    for (const std::filesystem::path& input : options.inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+                std::string extension = entry.path().extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+                if (entry.is_regular_file() && extension == ".png") { files.push_back(entry.path()); }
+            }
+        } else {
+            files.push_back(input);
+        }
+    }
+
+    bool success = true;
+    for (const std::filesystem::path& file : files) {
+        success = convert(file, options) && success;
+    }
+    return success ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// TexturePacker: cooks every texture under a directory into one TexturePack, which the game maps in and uploads
+// from directly (TextureLoader::load(pack, name)) instead of decoding each image at startup.
+//
+//   TexturePacker [--srgb] [--no-flip] [--kaiser] [--force] <directory> <output>
+//
+// Images (png, jpg, tga, bmp) are decoded and get full mip chains, flipped bottom up like the loader does unless
+// --no-flip is given. .dds and .ktx2 files go in as they are. Entries are named by their path relative to directory,
+// with forward slashes. The output is left alone when it is already newer than everything in directory, unless
+// --force is given.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CompressedTexture.h"
+#include "JobPool.h"
+#include "MipGenerator.h"
+#include "TexturePack.h"
+
+namespace {
+    enum class Kind { None, Image, Compressed };
+
+    Kind kindOf(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp") {
+            return Kind::Image;
+        }
+        if (extension == ".dds" || extension == ".ktx2") {
+            return Kind::Compressed;
+        }
+        return Kind::None;
+    }
+}
+
+int main(const int argc, char** argv) {
+    bool srgb = false;
+    bool flip = true;
+    bool force = false;
+    MipFilter filter = MipFilter::Box;
+    std::filesystem::path directory;
+    std::filesystem::path output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+
+        if (argument == "--srgb") {
+            srgb = true;
+        } else if (argument == "--no-flip") {
+            flip = false;
+        } else if (argument == "--kaiser") {
+            filter = MipFilter::Kaiser;
+        } else if (argument == "--force") {
+            force = true;
+        } else if (directory.empty()) {
+            directory = argument;
+        } else if (output.empty()) {
+            output = argument;
+        } else {
+            directory.clear();
+            break;
+        }
+    }
+
+    if (directory.empty() || output.empty()) {
+        std::cerr << "Usage: TexturePacker [--srgb] [--no-flip] [--kaiser] [--force] <directory> <output>" << std::endl;
+        return 1;
+    }
+
+    if (!force && TexturePack::isUpToDate(directory, output)) {
+        std::cout << output.string() << " is up to date" << std::endl;
+        return 0;
+    }
+
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+        if (it->is_regular_file(error) && kindOf(it->path()) != Kind::None) {
+            files.push_back(it->path());
+        }
+    }
+    if (error) {
+        std::cerr << "ERROR::TEXTURE_PACK::DIRECTORY_NOT_READ " << directory.string() << std::endl;
+        return 1;
+    }
+    // Same order every run, so an unchanged directory packs to an identical file.
+    std::sort(files.begin(), files.end());
+
+    // Decoded in parallel into per file slots, then added in order.
+    std::vector<MipChain> chains(files.size());
+    std::vector<CompressedImage> images(files.size());
+    JobPool pool;
+
+    // One file per chunk. Filtering inside loadMipChain shares the same pool, which parallelFor allows.
+    pool.parallelFor(files.size(), 1, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            FileData file = FileData::open(files[i]);
+            if (!file) { continue; }
+
+            if (kindOf(files[i]) == Kind::Compressed) {
+                loadCompressedImage(std::move(file), images[i]);
+                continue;
+            }
+
+            // Keep the image's own channel count, one and two channel data is never colour.
+            int width, height, channels = 0;
+            stbi_info_from_memory(file.bytes(), static_cast<int>(file.size()), &width, &height, &channels);
+            if (channels > 0) {
+                chains[i] = loadMipChain(file, channels, srgb && channels >= 3, flip, filter, nullptr, &pool);
+            }
+        }
+    });
+
+    TexturePackWriter writer;
+    std::vector<std::string> failed;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const std::string name = std::filesystem::relative(files[i], directory).generic_string();
+        if (chains[i].isValid()) {
+            writer.add(name, chains[i], srgb && chains[i].getChannels() >= 3);
+        } else if (!images[i].levels.empty()) {
+            writer.add(name, images[i]);
+        } else {
+            failed.push_back(name);
+        }
+    }
+
+    for (const std::string& name : failed) {
+        std::cerr << "ERROR::TEXTURE_PACK::NOT_LOADED " << name << std::endl;
+    }
+    if (!failed.empty() || !writer.save(output)) {
+        return 1;
+    }
+
+    std::cout << output.string() << ": " << writer.size() << " textures" << std::endl;
+    return 0;
+}